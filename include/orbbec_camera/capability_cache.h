@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include "libobsensor/h/ObTypes.h"
+#include "json.hpp"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace orbbec_camera {
+// Device capabilities that only change with the firmware: the stream types of each sensor,
+// property support, calibration and the manual exposure values read back after the launch
+// settings were applied. Kept in <directory>/<serial number>.json and only trusted when the
+// firmware version matches, so a launch can skip the USB control transfers that would read them
+// again.
+class CapabilityCache {
+ public:
+  CapabilityCache(const std::string &directory, const std::string &serial_number,
+                  const std::string &firmware_version);
+
+  // False when there is no file, it can not be parsed or it belongs to another firmware.
+  bool load();
+
+  // Writes the file if anything was added since load(). Thread safe, like every accessor.
+  bool save();
+
+  const std::string &path() const { return path_; }
+
+  bool propertySupported(int property, int permission, bool &supported) const;
+
+  void setPropertySupported(int property, int permission, bool supported);
+
+  // Stream types (OBStreamType) per sensor, in sensor list order.
+  bool sensorStreams(std::vector<std::vector<int>> &streams) const;
+
+  void setSensorStreams(const std::vector<std::vector<int>> &streams);
+
+  bool cameraParams(std::vector<OBCameraParam> &params) const;
+
+  void setCameraParams(const std::vector<OBCameraParam> &params);
+
+  bool value(const std::string &key, int &value) const;
+
+  void setValue(const std::string &key, int value);
+
+ private:
+  void reset();
+
+  std::string path_;
+  std::string serial_number_;
+  std::string firmware_version_;
+  mutable std::mutex mutex_;
+  nlohmann::json data_;
+  bool dirty_ = false;
+};
+}  // namespace orbbec_camera
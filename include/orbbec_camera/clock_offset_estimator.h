@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace orbbec_camera {
+// Online model of the device clock against the host clock, host = device + offset + skew * dt.
+// Every (device timestamp, host arrival time) pair lies above the true line by the transfer
+// latency, so the line is fitted to the lower envelope of the pairs: the minimum of each short
+// bucket, then the edge of their lower convex hull under the mean device time, which is the
+// supporting line with the smallest total distance to the points. Device stamps mapped through
+// it keep the smoothness of the device clock but are expressed in host time.
+class ClockOffsetEstimator {
+ public:
+  struct Config {
+    double window = 30.0;          // seconds of history in the fit
+    double bucket = 0.25;          // seconds per lower envelope point
+    double reset_threshold = 1.0;  // seconds of disagreement treated as a clock jump
+  };
+
+  struct State {
+    bool valid = false;       // a skew estimate needs two buckets
+    double offset = 0.0;      // seconds, host minus device at the latest sample
+    double skew = 0.0;        // parts per million, drift of the device clock
+    double jitter = 0.0;      // seconds, std dev of the arrival time above the fitted line
+    double latency = 0.0;     // seconds, mean arrival time above the fitted line
+    uint64_t samples = 0;     // since the last reset
+    uint64_t resets = 0;      // clock jumps seen
+  };
+
+  explicit ClockOffsetEstimator(const Config &config);
+
+  // device_us and host_us of the same event, host_us taken when the data reached the host.
+  void addSample(uint64_t device_us, uint64_t host_us);
+
+  // Host time of a device timestamp in microseconds, false before the first sample.
+  bool toHostTime(uint64_t device_us, uint64_t &host_us) const;
+
+  State state() const;
+
+  void reset();
+
+ private:
+  struct Point {
+    double x;  // microseconds of device time since the reference
+    double y;  // host minus device time in microseconds, relative to the reference
+  };
+
+  void resetLocked();
+
+  void refitLocked();
+
+  double lineAt(double x) const { return intercept_ + slope_ * x; }
+
+  Config config_;
+  mutable std::mutex mutex_;
+  bool has_reference_ = false;
+  uint64_t device_ref_ = 0;
+  uint64_t host_ref_ = 0;
+  double last_x_ = 0.0;
+  std::deque<Point> buckets_;  // finished buckets, oldest first
+  bool has_open_bucket_ = false;
+  Point open_bucket_{0.0, 0.0};
+  double bucket_start_ = 0.0;
+  double intercept_ = 0.0;
+  double slope_ = 0.0;
+  // exponentially weighted moments of the residual above the line
+  double residual_mean_ = 0.0;
+  double residual_var_ = 0.0;
+  uint64_t samples_ = 0;
+  uint64_t resets_ = 0;
+};
+}  // namespace orbbec_camera
@@ -116,5 +116,8 @@ const int32_t GEMINI_335LG_PID = 0x080B;  // Gemini 336Lg
 const int32_t GEMINI_336LG_PID = 0x080D;
 const int32_t GEMINI_335LE_PID = 0x080E;  // Gemini 335Le
 const int32_t GEMINI_336LE_PID = 0x0810;  // Gemini 335Le
-const std::string ORB_DEFAULT_LOCK_NAME = "orbbec_device.lock";
+// followed by the serial number or USB port and ".lock"
+const std::string ORB_DEVICE_LOCK_PREFIX = "/dev/shm/orbbec_device_";
+// device UID to serial number, on tmpfs so a reboot that renumbers USB ports starts empty
+const std::string ORB_DEVICE_SERIAL_CACHE_PATH = "/dev/shm/orbbec_device_serials.json";
 }  // namespace orbbec_camera
@@ -0,0 +1,49 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <orbbec_camera/DepthStats.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace orbbec_camera {
+// Range statistics of a raw depth frame. One pass counts every pixel into a histogram indexed by
+// the raw 16 bit value; min, max, mean, median and the published coarse histogram are then read
+// from that histogram, so the cost per pixel is a single increment whatever the resolution.
+class DepthStatistics {
+ public:
+  struct Config {
+    double bin_width = 0.1;  // meters per published histogram bin
+    double max_range = 10.0;  // meters, start of the last (open ended) bin
+  };
+
+  DepthStatistics();
+
+  void setConfig(const Config &config);
+
+  // Fills every field of stats except the header.
+  void compute(const uint16_t *depth_data, uint32_t width, uint32_t height, float depth_scale,
+               DepthStats &stats);
+
+ private:
+  Config config_;
+  // Two interleaved counters per raw value: neighbouring pixels often share a depth, and
+  // alternating between the tables keeps consecutive increments off the same memory location.
+  std::vector<uint32_t> raw_histogram_[2];
+};
+}  // namespace orbbec_camera
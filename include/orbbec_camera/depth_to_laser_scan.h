@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <sensor_msgs/LaserScan.h>
+#include <cstdint>
+#include <vector>
+#include "libobsensor/ObSensor.hpp"
+
+namespace orbbec_camera {
+// Projects a band of depth rows into a planar sensor_msgs/LaserScan. The angle bin and the
+// depth-to-range factor of every column are precomputed, so a frame costs one lookup and one
+// multiply per pixel of the band.
+class DepthToLaserScan {
+ public:
+  struct Config {
+    int row = -1;         // center row of the band, -1 uses the principal point
+    int band_height = 1;  // rows, the closest return of the band is kept
+    double angle_increment = 0.0;  // radians, 0 uses the angle of one column
+    double range_min = 0.1;        // meters
+    double range_max = 10.0;       // meters
+  };
+
+  void setConfig(const Config &config);
+
+  // Rebuilds the per-column lookup table when the frame size or the intrinsics change.
+  void updateIntrinsics(const OBCameraIntrinsic &intrinsic, int width, int height);
+
+  // Fills scan.ranges and the scan geometry, header is left to the caller.
+  bool project(const uint16_t *depth_data, int width, int height, float depth_scale,
+               sensor_msgs::LaserScan &scan) const;
+
+ private:
+  Config config_;
+  int width_ = 0;
+  int height_ = 0;
+  float fx_ = 0, cx_ = 0, cy_ = 0;
+  float angle_min_ = 0, angle_max_ = 0, angle_increment_ = 0;
+  int bin_count_ = 0;
+  std::vector<int> column_bin_;
+  // depth (millimeters, before depth scale) to range (meters) along the column's ray
+  std::vector<float> column_range_factor_;
+};
+}  // namespace orbbec_camera
@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include "json.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace orbbec_camera {
+// Host wide map from device UID to serial number. Selecting an OpenNI device by serial number
+// otherwise means opening every device, including the ones other nodes are about to use. The
+// file is re-read on every call under an flock(), so nodes of all processes share entries.
+class DeviceSerialCache {
+ public:
+  explicit DeviceSerialCache(const std::string &path);
+
+  bool lookup(const std::string &uid, std::string &serial_number) const;
+
+  void store(const std::string &uid, const std::string &serial_number);
+
+  // Removed devices are forgotten, another device may take over their port.
+  void erase(const std::vector<std::string> &uids);
+
+ private:
+  // Calls fn with the map while holding the file lock and writes the map back when fn
+  // returns true. False when the file can not be used.
+  bool access(bool exclusive, const std::function<bool(nlohmann::json &)> &fn) const;
+
+  std::string path_;
+};
+}  // namespace orbbec_camera
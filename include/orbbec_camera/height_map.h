@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <nav_msgs/OccupancyGrid.h>
+#include <tf2/LinearMath/Transform.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "ray_table.h"
+#include "worker_pool.h"
+
+namespace orbbec_camera {
+// Rasterizes depth pixels straight into a fixed-size max-height grid, no point cloud is built.
+// Pixels are projected through a RayTable with the grid rotation folded in. Rows are split over
+// a WorkerPool, every chunk writes its own grid and the grids are merged with a per-cell max.
+class HeightMapProjector {
+ public:
+  struct Config {
+    double resolution = 0.02;  // meters per cell
+    int width = 100;           // cells along x
+    int height = 100;          // cells along y
+    double origin_x = 0.0;     // grid frame position of cell (0, 0), meters
+    double origin_y = -1.0;
+    double min_height = 0.0;  // maps to 0 in the occupancy grid, meters
+    double max_height = 1.0;  // maps to 100, points above are ignored
+    double range_max = 4.0;   // depth beyond this is ignored, meters
+  };
+
+  explicit HeightMapProjector(int num_threads);
+
+  // Splits rows over a pool owned elsewhere, e.g. one shared by all cameras of the process.
+  explicit HeightMapProjector(std::shared_ptr<WorkerPool> pool);
+
+  void setConfig(const Config &config);
+
+  // Pose of the depth optical frame in the grid frame, meters.
+  void setTransform(const tf2::Transform &grid_from_optical);
+
+  const tf2::Transform &transform() const { return grid_from_optical_; }
+
+  // Rays of the depth frame, built with the rotation of transform().
+  void setRayTable(std::shared_ptr<const RayTable> rays) { rays_ = std::move(rays); }
+
+  // Fills grid.info and grid.data (-1 for unobserved cells), header is left to the caller.
+  bool project(const uint16_t *depth_data, int width, int height, float depth_scale,
+               nav_msgs::OccupancyGrid &grid);
+
+  // Number of cell updates done by the last project() call.
+  uint64_t lastCellUpdates() const { return last_cell_updates_; }
+
+ private:
+  Config config_;
+  tf2::Transform grid_from_optical_ = tf2::Transform::getIdentity();
+  std::shared_ptr<const RayTable> rays_;
+  float translation_[3] = {0, 0, 0};
+  std::vector<std::vector<float>> chunk_heights_;
+  std::vector<uint64_t> chunk_updates_;
+  uint64_t last_cell_updates_ = 0;
+  std::shared_ptr<WorkerPool> pool_;
+};
+}  // namespace orbbec_camera
@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <geometry_msgs/Vector3.h>
+#include <orbbec_camera/ImuBatch.h>
+#include <ros/time.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace orbbec_camera {
+// Packs IMU samples of one stream into ImuBatch messages. Messages come from a small pool
+// whose arrays are sized once for a full batch; a message is reused as soon as the publisher
+// has released it, so steady state publishing allocates nothing. Not thread safe, each stream
+// callback owns its batcher.
+class ImuBatcher {
+ public:
+  struct Config {
+    int batch_size = 10;  // samples per message
+    double window = 0.0;  // seconds, a batch is also sent once it spans this long, 0 disables
+    int pool_size = 4;    // messages kept for reuse
+  };
+
+  ImuBatcher(const Config &config, const std::string &frame_id);
+
+  // Appends one sample, either vector may be null. Returns the batch to publish once it is
+  // full, nullptr otherwise.
+  ImuBatchPtr add(const ros::Time &stamp, const geometry_msgs::Vector3 *angular_velocity,
+                  const geometry_msgs::Vector3 *linear_acceleration);
+
+  // Drops the partial batch, called when the stream stops.
+  void reset();
+
+  // Batches that found no free pooled message and were allocated.
+  uint64_t poolMisses() const { return pool_misses_; }
+
+ private:
+  ImuBatchPtr createMessage() const;
+
+  ImuBatchPtr acquire();
+
+  Config config_;
+  std::string frame_id_;
+  std::vector<ImuBatchPtr> pool_;
+  ImuBatchPtr current_;
+  uint64_t pool_misses_ = 0;
+};
+}  // namespace orbbec_camera
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "spsc_ring.h"
+
+namespace orbbec_camera {
+// Combines separate accel and gyro streams into one sample per gyro sample, for devices or
+// modes without the SDK's synchronized IMU output. Accel samples are handed over from the accel
+// callback thread through a lock-free ring; everything else runs on the gyro callback thread.
+//
+// COPY pairs each gyro sample with the latest accel sample. LINEAR_INTERPOLATION interpolates
+// accel to the gyro timestamp, so a gyro sample is held until an accel sample at or after its
+// timestamp has arrived.
+class ImuUnifier {
+ public:
+  enum class Method { NONE, COPY, LINEAR_INTERPOLATION };
+
+  struct Sample {
+    double time = 0.0;  // seconds
+    double value[3] = {0, 0, 0};
+  };
+
+  using OutputCallback = std::function<void(const Sample &gyro, const double accel[3])>;
+
+  explicit ImuUnifier(Method method, size_t capacity = 64);
+
+  Method method() const { return method_; }
+
+  // Accel callback thread.
+  void addAccel(const Sample &accel);
+
+  // Gyro callback thread. Calls output for every gyro sample that can be completed now, in
+  // timestamp order.
+  void addGyro(const Sample &gyro, const OutputCallback &output);
+
+  // Gyro thread, or with both streams stopped.
+  void reset();
+
+  // Accel samples lost because the gyro side did not drain the ring in time.
+  uint64_t accelOverflows() const { return accel_overflows_; }
+
+ private:
+  void drainAccel(const OutputCallback &output);
+
+  const Sample &accelAt(size_t index) const {
+    return accel_history_[(accel_begin_ + index) % accel_history_.size()];
+  }
+
+  void emitReady(const OutputCallback &output, bool flush);
+
+  Method method_;
+  SpscRing<Sample> accel_ring_;
+  uint64_t accel_overflows_ = 0;
+  // gyro thread state, fixed rings: recent accel samples, and the gyro samples waiting for a
+  // later accel sample
+  std::vector<Sample> accel_history_;
+  size_t accel_begin_ = 0;
+  size_t accel_count_ = 0;
+  std::vector<Sample> pending_;
+  size_t pending_begin_ = 0;
+  size_t pending_count_ = 0;
+};
+
+bool imuUnifierMethodFromString(const std::string &name, ImuUnifier::Method &method);
+}  // namespace orbbec_camera
@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace orbbec_camera {
+// Counts durations (ms) into fixed buckets. Fed rarely (once per device connect), read by the
+// diagnostics thread.
+class LatencyHistogram {
+ public:
+  struct Snapshot {
+    std::vector<double> edges_ms;  // upper bound of each bucket, the last bucket is open ended
+    std::vector<uint64_t> counts;  // edges_ms.size() + 1 entries
+    uint64_t count = 0;
+    double last_ms = 0.0;
+    double min_ms = 0.0;
+    double max_ms = 0.0;
+    double mean_ms = 0.0;
+  };
+
+  // 100 ms to 10 s, the range device connects fall into.
+  LatencyHistogram();
+
+  explicit LatencyHistogram(std::vector<double> edges_ms);
+
+  void record(double ms);
+
+  Snapshot snapshot() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<double> edges_ms_;
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  double sum_ms_ = 0.0;
+  double last_ms_ = 0.0;
+  double min_ms_ = 0.0;
+  double max_ms_ = 0.0;
+};
+}  // namespace orbbec_camera
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <sensor_msgs/PointCloud2.h>
+#include <memory>
+#include <vector>
+#include "worker_pool.h"
+
+namespace orbbec_camera {
+// Surface normals of an organized float32 x/y/z cloud using the average 3D gradient method on
+// integral images, so the cost per pixel does not depend on the smoothing window.
+class NormalEstimator {
+ public:
+  explicit NormalEstimator(int num_threads);
+
+  // pool may be shared, parallelFor() serializes concurrent callers.
+  explicit NormalEstimator(std::shared_ptr<WorkerPool> pool);
+
+  // Half size of the averaging window in pixels.
+  void setSmoothingSize(int smoothing_size) { smoothing_size_ = smoothing_size; }
+
+  // Normals are not computed where the depth across the window changes by more than
+  // factor * depth, which keeps them from smearing over object borders.
+  void setMaxDepthChangeFactor(float factor) { max_depth_change_factor_ = factor; }
+
+  // Normals are flipped to face this point, the sensor origin of the cloud's frame.
+  void setViewpoint(float x, float y, float z) {
+    viewpoint_[0] = x;
+    viewpoint_[1] = y;
+    viewpoint_[2] = z;
+  }
+
+  // Output layout: x, y, z, pad, normal_x, normal_y, normal_z, pad (PCL PointNormal order).
+  static void setupFields(sensor_msgs::PointCloud2 &msg);
+
+  // xyz holds width * height points of float x/y/z at the given stride, invalid points are NaN.
+  // msg must be set up with setupFields() and sized for width * height points.
+  void compute(const uint8_t *xyz, uint32_t point_step, int width, int height,
+               sensor_msgs::PointCloud2 &msg);
+
+ private:
+  struct Sum {
+    double x = 0, y = 0, z = 0, count = 0;
+  };
+
+  bool windowMean(int x0, int y0, int x1, int y1, float mean[3]) const;
+
+  int smoothing_size_ = 10;
+  float max_depth_change_factor_ = 0.05f;
+  float viewpoint_[3] = {0, 0, 0};
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<Sum> integral_;
+  std::shared_ptr<WorkerPool> pool_;
+};
+}  // namespace orbbec_camera
@@ -27,15 +27,19 @@
 #include <sensor_msgs/PointCloud2.h>
 #include <sensor_msgs/distortion_models.h>
 #include <sensor_msgs/Imu.h>
+#include <nav_msgs/OccupancyGrid.h>
 #include <sensor_msgs/point_cloud2_iterator.h>
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2/LinearMath/Transform.h>
 #include <tf2/LinearMath/Vector3.h>
 #include <tf2_ros/static_transform_broadcaster.h>
 #include <tf2_ros/transform_broadcaster.h>
+#include <tf2_ros/transform_listener.h>
 #include <condition_variable>
 #include <thread>
 #include <atomic>
+#include <set>
+#include <chrono>
 #include <camera_info_manager/camera_info_manager.h>
 #include <std_srvs/SetBool.h>
 #include <std_srvs/Empty.h>
@@ -45,16 +49,46 @@
 #include <image_transport/image_transport.h>
 #include <orbbec_camera/Metadata.h>
 #include <orbbec_camera/IMUInfo.h>
+#include <orbbec_camera/Proximity.h>
+#include <orbbec_camera/Plane.h>
 
 #include "jpeg_decoder.h"
+#include "point_cloud_layout.h"
+#include "normal_estimator.h"
+#include "point_cloud_exporter.h"
+#include "depth_to_laser_scan.h"
+#include "height_map.h"
+#include "depth_statistics.h"
+#include "proximity_monitor.h"
+#include "plane_segmenter.h"
+#include "imu_batcher.h"
+#include "imu_unifier.h"
+#include "spsc_ring.h"
+#include "clock_offset_estimator.h"
+#include "capability_cache.h"
+#include "latency_histogram.h"
+#include "ray_table.h"
 
 #include <diagnostic_updater/diagnostic_updater.h>
 
 namespace orbbec_camera {
+// Optional wiring from the driver that creates the node.
+struct CameraNodeOptions {
+  // runs the point cloud post processing instead of the node's own pool, so the cameras hosted
+  // by one process share a fixed set of threads
+  std::shared_ptr<WorkerPool> worker_pool;
+  // when set, the time from enumerated_at to the first published frame is recorded in it
+  std::shared_ptr<LatencyHistogram> connect_latency;
+  std::chrono::steady_clock::time_point enumerated_at;
+  // the driver re-binds devices with attachDevice() instead of rebuilding the node
+  bool warm_reconnect = false;
+};
+
 class OBCameraNode {
  public:
   OBCameraNode(ros::NodeHandle &nh, ros::NodeHandle &nh_private,
-               std::shared_ptr<ob::Device> device);
+               std::shared_ptr<ob::Device> device,
+               const CameraNodeOptions &options = CameraNodeOptions());
 
   OBCameraNode(const OBCameraNode &) = delete;
 
@@ -68,18 +102,58 @@ class OBCameraNode {
 
   bool isInitialized() const;
 
- private:
-  struct IMUData {
-    IMUData() = default;
+  // Warm reconnect: stops the streams of a lost device but keeps publishers, services and the
+  // cached camera info alive.
+  void detachDevice();
 
-    IMUData(stream_index_pair stream, Eigen::Vector3d data, double timestamp)
-        : stream_(std::move(stream)), data_(std::move(data)), timestamp_(timestamp) {}
+  // Binds the re-enumerated device and restarts the streams that ran before detachDevice().
+  // Returns false when the device can not take over (other serial number, profile gone), the
+  // caller then rebuilds the node.
+  bool attachDevice(const std::shared_ptr<ob::Device> &device,
+                    const std::chrono::steady_clock::time_point &enumerated_at);
 
-    bool isSet() const { return timestamp_ >= 0; }
+ private:
+  // Range gating and spatial crop applied while generating point clouds.
+  struct PointCloudCrop {
+    bool inBox(float x, float y, float z) const {
+      const float bx = box_rot[0] * x + box_rot[1] * y + box_rot[2] * z + box_trans[0];
+      const float by = box_rot[3] * x + box_rot[4] * y + box_rot[5] * z + box_trans[1];
+      const float bz = box_rot[6] * x + box_rot[7] * y + box_rot[8] * z + box_trans[2];
+      return bx >= box_min[0] && bx <= box_max[0] && by >= box_min[1] && by <= box_max[1] &&
+             bz >= box_min[2] && bz <= box_max[2];
+    }
+
+    double min_range = 0.02;  // in meters
+    double max_range = 10.0;  // in meters
+    cv::Rect roi;             // in pixels, empty means the whole frame
+    bool use_box = false;
+    float box_min[3] = {0, 0, 0};  // in millimeters
+    float box_max[3] = {0, 0, 0};  // in millimeters
+    // Maps a point of the cloud's optical frame into the box frame, in millimeters.
+    float box_rot[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    float box_trans[3] = {0, 0, 0};
+  };
 
-    stream_index_pair stream_{};
-    Eigen::Vector3d data_{};
-    double timestamp_ = -1;  // in nanoseconds
+  // Rays of the stream in the output frame, a point is
+  // p = depth * (rays.column[u] + rays.row[v]) + trans, in millimeters.
+  struct PointCloudRayTable {
+    std::shared_ptr<const RayTable> rays;
+    tf2::Matrix3x3 rotation;  // of the output frame, the rays were built with it
+    float trans[3] = {0, 0, 0};
+    std::string frame_id;
+    // crop of the stream with the box expressed in the output frame
+    PointCloudCrop crop;
+    bool valid = false;
+  };
+
+  // Bias-free IMU reading handed from the SDK callback to the IMU publisher thread.
+  struct IMURawSample {
+    stream_index_pair stream_index;
+    bool synced = false;  // from the accel/gyro sync pipeline, both vectors are set
+    uint64_t device_us = 0;  // device clock
+    uint64_t system_us = 0;  // host arrival
+    double gyro[3] = {0, 0, 0};   // rad/s
+    double accel[3] = {0, 0, 0};  // m/s^2
   };
 
   void init();
@@ -120,10 +194,34 @@ class OBCameraNode {
   void onNewIMUFrameCallback(const std::shared_ptr<ob::Frame> &frame,
                              const stream_index_pair &stream_index);
 
+  // Builds and publishes the messages of one IMU sample, on the SDK callback thread or on the
+  // IMU publisher thread.
+  void publishIMUSample(const IMURawSample &sample);
+
+  // Hands a sample to the IMU publisher thread, or publishes it in place when there is none.
+  void dispatchIMUSample(const IMURawSample &sample,
+                         const std::chrono::steady_clock::time_point &callback_start);
+
+  void startIMUPublishThread();
+
+  // Notes the first stream, pipeline or IMU start after the device was (re)connected.
+  void markStreamStart();
+
+  // Logs and records the first frame the SDK delivers after the device was (re)connected,
+  // whether or not anybody subscribes to it, measured from markStreamStart().
+  void recordFirstFrame(const stream_index_pair &stream_index);
+
+  void imuPublishThreadLoop();
+
   bool decodeColorFrameToBuffer(const std::shared_ptr<ob::Frame> &frame, uint8_t *dest);
 
   std::shared_ptr<ob::Frame> decodeIRMJPGFrame(const std::shared_ptr<ob::Frame> &frame);
 
+  // Stamp of a device timestamp per use_hardware_time and enable_clock_sync.
+  ros::Time frameTimeStamp(uint64_t device_us, uint64_t system_us) const;
+
+  ros::Time frameTimeStamp(const std::shared_ptr<ob::Frame> &frame) const;
+
   void onNewFrameSetCallback(const std::shared_ptr<ob::FrameSet> &frame_set);
 
   std::shared_ptr<ob::Frame> processDepthFrameFilter(std::shared_ptr<ob::Frame> &frame);
@@ -136,10 +234,63 @@ class OBCameraNode {
 
   void publishColoredPointCloud(const std::shared_ptr<ob::FrameSet> &frame_set);
 
+  // Writes the points of the given pixel ROI into cloud_msg_.data using the given layout and
+  // returns the number of points written. The layout and the attribute source are resolved at
+  // compile time; range and box rejection happen before anything is written.
+  template <typename Layout, typename AttributeSource>
+  size_t fillPointCloud(const uint16_t *depth_data, int width, const cv::Rect &roi,
+                        const PointCloudRayTable &table, float depth_scale,
+                        const AttributeSource &attributes);
+
+  // Sets up cloud_msg_ for the configured encoding and ROI and fills it.
+  template <typename AttributeSource>
+  void generatePointCloud(const uint16_t *depth_data, int width, int height,
+                          const PointCloudRayTable &table, float depth_scale,
+                          PointAttribute attribute, const AttributeSource &attributes);
+
+  // Returns the ray table of the stream's point cloud, rebuilt when the frame geometry changes
+  // or the output frame transform becomes available.
+  const PointCloudRayTable &getPointCloudRayTable(const stream_index_pair &stream_index,
+                                                  const OBCameraIntrinsic &intrinsic, int width,
+                                                  int height);
+
+  // Transform from the stream's optical frame to point_cloud_frame_id, in meters.
+  bool getPointCloudTransform(const stream_index_pair &stream_index,
+                              tf2::Transform &cloud_from_optical);
+
+  void setupPointCloudCrop();
+
+  void publishPlaneSegmentation(const ros::Time &timestamp, const std::string &frame_id);
+
+  void publishPointCloudNormals(const ros::Time &timestamp, const std::string &frame_id);
+
+  void publishIntensityPointCloud(const std::shared_ptr<ob::FrameSet> &frame_set);
+
+  void savePointCloudMsg(const std::string &name, PointCloudExporter &exporter,
+                         std::atomic_int &remaining_saves);
+
+  tf2::Transform getOpticalToCameraLinkTransform(const stream_index_pair &stream_index);
+
   bool setupFormatConvertType(OBFormat type);
 
+  void setupCapabilityCache();
+
+  // Property support through the capability cache, the device is only asked on a miss.
+  bool isPropertySupported(OBPropertyID property, OBPermissionType permission);
+
+  // Launch settings that change the values readDefault*() reads back, spelled out in full as
+  // part of their cache key.
+  std::string deviceSettingsFingerprint() const;
+
+  bool isAutoExposureEnabled(const stream_index_pair &stream_index) const;
+
   void setupProfiles();
 
+  // Looks the selected profiles up again on a re-attached device, without re-selecting them.
+  bool rebindProfiles();
+
+  void setupHardwareAlignment();
+
   void updateImageConfig(const stream_index_pair &stream_index,
                          const std::shared_ptr<ob::VideoStreamProfile> &selected_profile);
   static void printProfiles(const std::shared_ptr<ob::Sensor> &sensor);
@@ -154,11 +305,23 @@ class OBCameraNode {
 
   void diagnosticTemperature(diagnostic_updater::DiagnosticStatusWrapper &stat);
 
+  void diagnosticClockSync(diagnostic_updater::DiagnosticStatusWrapper &stat);
+
+  void diagnosticConnectLatency(diagnostic_updater::DiagnosticStatusWrapper &stat);
+
+  void diagnosticReattachLatency(diagnostic_updater::DiagnosticStatusWrapper &stat);
+
+  void diagnosticStreamStartLatency(diagnostic_updater::DiagnosticStatusWrapper &stat);
+
+  void diagnosticProfileSwitch(diagnostic_updater::DiagnosticStatusWrapper &stat);
+
   void publishStaticTF(const ros::Time &t, const tf2::Vector3 &trans, const tf2::Quaternion &q,
                        const std::string &from, const std::string &to);
 
   void startStreams();
 
+  void startPipeline(const std::shared_ptr<ob::Config> &config);
+
   void startIMUSyncStream();
 
   void startAccel();
@@ -177,7 +340,11 @@ class OBCameraNode {
 
   IMUInfo createIMUInfo(const stream_index_pair &stream_index);
 
-  sensor_msgs::Imu createUnitIMUMessage(const IMUData &accel_data, const IMUData &gyro_data);
+  // Refreshes the cached calibration of an IMU stream, publishing it when it changed.
+  void updateIMUInfo(const stream_index_pair &stream_index);
+
+  // Output of the software IMU unifier, runs wherever the gyro samples are published.
+  void publishUnitedImu(const ImuUnifier::Sample &gyro, const double accel[3]);
 
   void startStream(const stream_index_pair &stream_index);
 
@@ -185,16 +352,69 @@ class OBCameraNode {
 
   void imageSubscribedCallback(const stream_index_pair &stream_index);
 
+  // Whether anything fed by the pipeline (images, camera info, clouds, depth outputs) is
+  // subscribed.
+  bool hasPipelineSubscribers();
+
+  // Same subscribers as hasPipelineSubscribers(), limited to what the stream feeds.
+  bool hasStreamSubscribers(const stream_index_pair &stream_index);
+
+  void setupIdlePolicy();
+
+  // Same mode as the selected profile at the offered rate closest to standby_fps_.
+  std::shared_ptr<ob::StreamProfile> standbyProfile(const stream_index_pair &stream_index);
+
+  // Applies the idle policy after idle_timeout_, called when the last subscriber of a stream
+  // leaves.
+  void scheduleIdlePolicy(const stream_index_pair &stream_index);
+
+  // Stops or idles the streams queued by scheduleIdlePolicy() that still have no subscribers,
+  // the whole pipeline in pipeline mode.
+  void applyIdlePolicy();
+
+  // Restarts a running stream, or the whole pipeline, at its standby or its launch profile.
+  void setStreamStandby(const stream_index_pair &stream_index, bool standby);
+
+  void setPipelineStandby(bool standby);
+
+  void recordResumeFrame(const stream_index_pair &stream_index);
+
+  void diagnosticResumeLatency(diagnostic_updater::DiagnosticStatusWrapper &stat);
+
   void imuSubscribedCallback(const stream_index_pair &stream_index);
 
   void imageUnsubscribedCallback(const stream_index_pair &stream_index);
 
   void imuUnsubscribedCallback(const stream_index_pair &stream_index);
 
+  void unitedImuSubscribedCallback();
+
+  void unitedImuUnsubscribedCallback();
+
   void pointCloudSubscribedCallback();
 
   void pointCloudUnsubscribedCallback();
 
+  void intensityPointCloudSubscribedCallback();
+
+  void intensityPointCloudUnsubscribedCallback();
+
+  void depthOutputSubscribedCallback();
+
+  void depthOutputUnsubscribedCallback();
+
+  void publishLaserScan(const std::shared_ptr<ob::Frame> &frame);
+
+  void setupHeightMap();
+
+  void publishHeightMap(const std::shared_ptr<ob::Frame> &frame);
+
+  void publishDepthStats(const std::shared_ptr<ob::Frame> &frame);
+
+  void setupProximityMonitor();
+
+  void publishProximity(const std::shared_ptr<ob::Frame> &frame);
+
   void coloredPointCloudSubscribedCallback();
 
   void coloredPointCloudUnsubscribedCallback();
@@ -207,6 +427,9 @@ class OBCameraNode {
 
   bool isGemini335PID(uint32_t pid);
 
+  // Calibration list of the device, read once (or from the capability cache).
+  const std::vector<OBCameraParam> &getCalibrationCameraParams();
+
   boost::optional<OBCameraParam> getCameraParam();
 
   boost::optional<OBCameraParam> getCameraDepthParam();
@@ -217,6 +440,8 @@ class OBCameraNode {
 
   void setupCameraInfo();
 
+  void updateCameraInfos();
+
   // camera control services
   bool setMirrorCallback(std_srvs::SetBoolRequest &request, std_srvs::SetBoolResponse &response,
                          const stream_index_pair &stream_index);
@@ -275,6 +500,16 @@ class OBCameraNode {
 
   bool toggleSensor(const stream_index_pair &stream_index, bool enabled, std::string &msg);
 
+  bool setStreamProfileCallback(SetStreamProfileRequest &request,
+                                SetStreamProfileResponse &response,
+                                const stream_index_pair &stream_index);
+
+  // Swaps the profile and everything sized by it, the stream must be stopped.
+  void applyStreamProfile(const stream_index_pair &stream_index,
+                          const std::shared_ptr<ob::VideoStreamProfile> &profile);
+
+  void recordProfileSwitchFrame(const stream_index_pair &stream_index);
+
   bool getCameraParamsCallback(orbbec_camera::GetCameraParamsRequest &request,
                                orbbec_camera::GetCameraParamsResponse &response);
 
@@ -358,6 +593,7 @@ class OBCameraNode {
   std::map<stream_index_pair, ros::ServiceServer> set_auto_exposure_srv_;
   std::map<stream_index_pair, ros::ServiceServer> get_auto_exposure_srv_;
   std::map<stream_index_pair, ros::ServiceServer> get_camera_info_srv_;
+  std::map<stream_index_pair, ros::ServiceServer> set_stream_profile_srv_;
   ros::ServiceServer get_sdk_version_srv_;
   ros::ServiceServer get_device_info_srv_;
   ros::ServiceServer set_laser_srv_;
@@ -397,17 +633,72 @@ class OBCameraNode {
   bool enable_pipeline_ = false;
   std::shared_ptr<ob::Pipeline> pipeline_ = nullptr;
   std::shared_ptr<ob::Config> pipeline_config_ = nullptr;
+  // idle policy
+  IdlePolicy idle_policy_ = IdlePolicy::KEEP;
+  double idle_timeout_ = 0.0;  // seconds without subscribers before the policy applies
+  int standby_fps_ = 5;
+  ros::WallTimer idle_timer_;
+  std::shared_ptr<ob::Config> standby_pipeline_config_ = nullptr;
+  bool pipeline_standby_ = false;
+  std::map<stream_index_pair, bool> stream_standby_;
+  std::set<stream_index_pair> idle_streams_;  // waiting for the idle policy, under device_lock_
+  // subscribe to first frame once the node was idle
+  std::atomic_bool image_idle_{false};
+  std::atomic_bool await_resume_frame_{false};
+  std::chrono::steady_clock::time_point resume_requested_at_;
+  LatencyHistogram resume_latency_{std::vector<double>{10, 20, 50, 100, 200, 500, 1000}};
+  // frame gap of a runtime profile switch, armed by set_<stream>_profile
+  std::atomic_bool profile_switch_armed_{false};
+  std::mutex profile_switch_mutex_;
+  stream_index_pair profile_switch_stream_;
+  int profile_switch_fps_ = 0;
+  bool profile_switch_restarted_ = false;
+  bool profile_switch_has_last_frame_ = false;
+  std::chrono::steady_clock::time_point profile_switch_started_at_;
+  std::chrono::steady_clock::time_point profile_switch_last_frame_;
+  int profile_switch_missed_frames_ = 0;  // of the last completed switch
+  LatencyHistogram profile_switch_gap_{std::vector<double>{50, 100, 200, 500, 1000, 2000}};
   ros::Publisher depth_cloud_pub_;
   ros::Publisher depth_registered_cloud_pub_;
+  ros::Publisher depth_normals_pub_;
   sensor_msgs::PointCloud2 cloud_msg_;
+  sensor_msgs::PointCloud2 normals_msg_;
+  ros::Publisher floor_plane_pub_;
+  ros::Publisher ground_removed_cloud_pub_;
+  Plane floor_plane_msg_;
+  sensor_msgs::PointCloud2 ground_removed_msg_;
   std::recursive_mutex cloud_mutex_;
   std::atomic_bool pipeline_started_{false};
   bool enable_point_cloud_ = false;
   bool enable_colored_point_cloud_ = false;
-  std::atomic_bool save_point_cloud_{false};
-  std::atomic_bool save_colored_point_cloud_{false};
+  // number of consecutive clouds still to be saved
+  std::atomic_int save_point_cloud_{0};
+  std::atomic_int save_colored_point_cloud_{0};
+  int point_cloud_save_count_ = 1;
+  PointCloudExporter depth_cloud_exporter_;
+  PointCloudExporter colored_cloud_exporter_;
   boost::optional<OBCameraParam> camera_params_;
-  bool is_initialized_ = false;
+  std::atomic_bool is_initialized_{false};
+  bool enable_capability_cache_ = false;
+  std::string capability_cache_dir_;  // empty means $ROS_HOME/orbbec_camera
+  std::shared_ptr<CapabilityCache> capability_cache_ = nullptr;
+  std::vector<OBCameraParam> calibration_params_;
+  bool calibration_params_loaded_ = false;
+  // warm reconnect
+  std::atomic_bool device_detached_{false};
+  bool restart_pipeline_ = false;
+  bool restart_imu_sync_ = false;
+  std::map<stream_index_pair, bool> restart_streams_;  // image and IMU streams running at detach
+  std::chrono::steady_clock::time_point device_enumerated_at_;
+  std::atomic_bool await_first_frame_{false};
+  std::atomic<int64_t> stream_started_at_ns_{0};  // steady clock, 0 until markStreamStart()
+  std::shared_ptr<LatencyHistogram> connect_latency_ = nullptr;
+  // stream start to first frame of every connect and reattach, the SDK share of the above
+  LatencyHistogram stream_start_latency_;
+  bool warm_reconnect_ = false;
+  // re-enumeration to first frame of warm reconnects, kept apart from the cold connects above
+  std::atomic_bool reattached_{false};
+  LatencyHistogram reattach_latency_;
   bool enable_soft_filter_ = true;
   bool enable_color_auto_exposure_ = true;
   int color_exposure_ = -1;
@@ -440,10 +731,30 @@ class OBCameraNode {
   std::map<stream_index_pair, std::string> imu_qos_;
   std::map<stream_index_pair, bool> imu_started_;
   std::map<stream_index_pair, std::shared_ptr<ob::Sensor>> imu_sensor_;
+  // calibration read once per stream start, the sample callbacks only read the bias from here
+  std::map<stream_index_pair, IMUInfo> imu_info_;
+  bool enable_imu_batch_ = false;
+  ImuBatcher::Config imu_batch_config_;
+  std::map<stream_index_pair, ros::Publisher> imu_batch_publishers_;
+  std::map<stream_index_pair, std::shared_ptr<ImuBatcher>> imu_batchers_;
+  ros::Publisher imu_gyro_accel_batch_publisher_;
+  std::shared_ptr<ImuBatcher> imu_gyro_accel_batcher_ = nullptr;
   double liner_accel_cov_ = 0.0001;
   double angular_vel_cov_ = 0.0001;
-  std::deque<IMUData> imu_history_;
-  IMUData accel_data_{ACCEL, {0, 0, 0}, -1.0};
+  // "none", "copy" or "linear_interpolation", software unification of separate accel and gyro
+  std::string unite_imu_method_str_ = "none";
+  std::shared_ptr<ImuUnifier> imu_unifier_ = nullptr;
+  ImuUnifier::OutputCallback united_imu_output_;
+  // SDK IMU callbacks only fill a lock-free ring per stream, this thread publishes from there
+  bool enable_imu_publish_thread_ = false;
+  int imu_publish_thread_priority_ = 0;  // SCHED_FIFO priority, 0 keeps the default policy
+  int imu_ring_capacity_ = 256;
+  std::map<stream_index_pair, std::shared_ptr<SpscRing<IMURawSample>>> imu_rings_;
+  std::shared_ptr<std::thread> imu_publish_thread_ = nullptr;
+  std::mutex imu_publish_mutex_;  // held while publishing, stopIMU() resets under it
+  std::condition_variable imu_publish_cv_;
+  std::atomic<uint64_t> imu_ring_overflows_{0};
+  std::atomic<int64_t> imu_callback_max_ns_{0};
 
   bool enable_sync_output_accel_gyro_ = false;
   std::shared_ptr<ob::Pipeline> imuPipeline_ = nullptr;
@@ -467,8 +778,66 @@ class OBCameraNode {
   std::mutex colorFrameMtx_;
   std::condition_variable colorFrameCV_;
   bool use_hardware_time_ = false;
+  // host time stamps from a fitted model of the device clock, overrides use_hardware_time
+  bool enable_clock_sync_ = false;
+  ClockOffsetEstimator::Config clock_sync_config_;
+  std::shared_ptr<ClockOffsetEstimator> clock_offset_estimator_ = nullptr;
   // ordered point cloud
   bool ordered_pc_ = false;
+  PointCloudEncoding point_cloud_encoding_ = PointCloudEncoding::FLOAT32;
+  PointCloudCrop point_cloud_crop_params_;
+  // keyed by the stream whose optical frame the cloud is published in
+  std::map<stream_index_pair, PointCloudCrop> point_cloud_crop_;
+  std::string point_cloud_crop_box_frame_ = "optical";
+  // empty publishes clouds in the optical frame of the stream
+  std::string point_cloud_frame_id_;
+  std::map<stream_index_pair, PointCloudRayTable> point_cloud_ray_tables_;
+  // rays of the point clouds, the height map and the proximity monitor
+  RayTableCache ray_table_cache_;
+  std::shared_ptr<tf2_ros::Buffer> tf_buffer_ = nullptr;
+  std::shared_ptr<tf2_ros::TransformListener> tf_listener_ = nullptr;
+  bool enable_point_cloud_normals_ = false;
+  int normal_smoothing_size_ = 10;
+  double normal_max_depth_change_factor_ = 0.05;
+  std::shared_ptr<NormalEstimator> normal_estimator_ = nullptr;
+  bool enable_plane_segmentation_ = false;
+  PlaneSegmenter::Config plane_segmentation_config_;
+  std::shared_ptr<PlaneSegmenter> plane_segmenter_ = nullptr;
+  bool enable_point_cloud_intensity_ = false;
+  stream_index_pair intensity_ir_stream_ = INFRA1;
+  ros::Publisher intensity_cloud_pub_;
+  bool enable_laser_scan_ = false;
+  DepthToLaserScan laser_scan_projector_;
+  ros::Publisher laser_scan_pub_;
+  sensor_msgs::LaserScan laser_scan_msg_;
+  bool enable_height_map_ = false;
+  std::string height_map_frame_id_;
+  HeightMapProjector::Config height_map_config_;
+  // pose of camera_link in the height map frame
+  tf2::Transform height_map_ground_transform_;
+  // normals, plane segmentation and the height map, shared by the hosted cameras
+  int worker_threads_ = THREAD_NUM;
+  std::shared_ptr<WorkerPool> worker_pool_ = nullptr;
+  std::shared_ptr<HeightMapProjector> height_map_projector_ = nullptr;
+  ros::Publisher height_map_pub_;
+  nav_msgs::OccupancyGrid height_map_msg_;
+  uint64_t height_map_cell_updates_ = 0;
+  double height_map_seconds_ = 0.0;
+  bool enable_depth_stats_ = false;
+  DepthStatistics depth_statistics_;
+  ros::Publisher depth_stats_pub_;
+  DepthStats depth_stats_msg_;
+  bool enable_proximity_ = false;
+  std::string proximity_regions_;
+  // "camera_link" or "optical", frame the region boxes are given in
+  std::string proximity_frame_ = "camera_link";
+  ProximityMonitor proximity_monitor_;
+  std::vector<ProximityMonitor::Result> proximity_results_;
+  ros::Publisher proximity_pub_;
+  Proximity proximity_msg_;
+  uint64_t proximity_frame_count_ = 0;
+  double proximity_latency_sum_ = 0.0;
+  double proximity_latency_max_ = 0.0;
   std::shared_ptr<ob::Frame> depth_frame_ = nullptr;
   std::string device_preset_ = "Default";
   // filter switch
@@ -509,6 +878,10 @@ class OBCameraNode {
   std::shared_ptr<ob::Align> align_filter_ = nullptr;
   OBStreamType align_target_stream_ = OB_STREAM_COLOR;
   bool retry_on_usb3_detection_failure_ = false;
+  // MB/s the image streams may use, 0 derives it from the connection type, < 0 is unlimited
+  double bandwidth_budget_ = 0.0;
+  // fraction of the derived budget, cameras on one bus split it
+  double bandwidth_share_ = 1.0;
 };
 
 }  // namespace orbbec_camera
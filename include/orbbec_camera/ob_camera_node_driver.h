@@ -16,19 +16,41 @@
 
 #pragma once
 #include "ob_camera_node.h"
+#include "device_serial_cache.h"
 #include <thread>
 #include <mutex>
-#include <semaphore.h>
-#include <pthread.h>
+#include <set>
 
 namespace orbbec_camera {
 
+// What OBMultiCameraDriver hands to each camera it hosts.
+struct SharedDriverResources {
+  std::shared_ptr<ob::Context> ctx;
+  // device lists are walked by one camera at a time, the cameras then start in parallel
+  std::shared_ptr<std::mutex> select_lock;
+  std::shared_ptr<WorkerPool> worker_pool;
+  int device_num = 1;
+};
+
 class OBCameraNodeDriver {
  public:
   explicit OBCameraNodeDriver(ros::NodeHandle& nh, ros::NodeHandle& nh_private);
 
+  // Hosted mode: no context, device callback or query thread of its own, the owning
+  // OBMultiCameraDriver forwards the device events of the shared context.
+  OBCameraNodeDriver(ros::NodeHandle& nh, ros::NodeHandle& nh_private,
+                     const SharedDriverResources& shared);
+
   ~OBCameraNodeDriver();
 
+  void deviceConnectCallback(const std::shared_ptr<ob::DeviceList>& list);
+
+  void deviceDisconnectCallback(const std::shared_ptr<ob::DeviceList>& device_list);
+
+  bool isDeviceConnected() const { return device_connected_; }
+
+  static OBLogSeverity obLogSeverityFromString(const std::string& log_level);
+
  private:
   void init();
 
@@ -39,24 +61,28 @@ class OBCameraNodeDriver {
   std::shared_ptr<ob::Device> selectDeviceByUSBPort(const std::shared_ptr<ob::DeviceList>& list,
                                                     const std::string& usb_port);
 
-  void initializeDevice(const std::shared_ptr<ob::Device>& device);
+  // Selects the device and retries with exponential backoff until it answers or
+  // device_ready_timeout_ passes, then rethrows the last error.
+  std::shared_ptr<ob::Device> waitForDevice(const std::shared_ptr<ob::DeviceList>& list);
 
-  void deviceConnectCallback(const std::shared_ptr<ob::DeviceList>& list);
+  void initializeDevice(const std::shared_ptr<ob::Device>& device);
 
   void connectNetDevice(const std::string& ip_address, int port);
 
   void checkConnectionTimer();
 
-  void deviceDisconnectCallback(const std::shared_ptr<ob::DeviceList>& device_list);
-
-  static OBLogSeverity obLogSeverityFromString(const std::string& log_level);
-
   void queryDevice();
 
   void resetDeviceThread();
 
   static std::string parseUsbPort(const std::string& line);
 
+  std::string deviceLockPath() const;
+
+  // Blocks until no other node (in any process) is starting the device this node selects.
+  // Returns the guard that releases it, nullptr when the lock file can not be used.
+  std::shared_ptr<int> lockDevice();
+
  private:
   ros::NodeHandle nh_;
   ros::NodeHandle nh_private_;
@@ -72,18 +98,25 @@ class OBCameraNodeDriver {
   std::string device_uid_;
   std::string log_level_;
   std::string usb_port_;
-  int connection_delay_ = 1.0;
+  int connection_delay_ = 0;
+  int device_ready_timeout_ = 5000;  // ms
+  std::shared_ptr<LatencyHistogram> connect_latency_ = std::make_shared<LatencyHistogram>();
+  DeviceSerialCache serial_cache_{ORB_DEVICE_SERIAL_CACHE_PATH};
+  // UIDs opened to check their cached serial number, not again until the next device change
+  std::set<std::string> verified_uids_;
   std::shared_ptr<std::thread> query_thread_ = nullptr;
   std::recursive_mutex device_lock_;
   int device_num_ = 1;
+  // keep the camera node across disconnects and only re-bind the device
+  bool warm_reconnect_ = false;
+  std::chrono::steady_clock::time_point device_enumerated_at_;
   std::shared_ptr<std::thread> reset_device_thread_ = nullptr;
   std::condition_variable reset_device_cv_;
   std::atomic_bool reset_device_{false};
   std::mutex reset_device_lock_;
-  pthread_mutex_t* orb_device_lock_ = nullptr;
-  pthread_mutexattr_t orb_device_lock_attr_;
-  uint8_t* orb_device_lock_shm_addr_ = nullptr;
-  int orb_device_lock_shm_fd_ = -1;
+  bool hosted_ = false;
+  std::shared_ptr<std::mutex> select_lock_ = nullptr;
+  std::shared_ptr<WorkerPool> worker_pool_ = nullptr;
   // net work config
   std::string ip_address_;
   int port_ = 0;
@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+#include "ob_camera_node_driver.h"
+#include <condition_variable>
+#include <vector>
+
+namespace orbbec_camera {
+
+// Hosts several cameras in one process or nodelet: one ob::Context and one worker pool for all
+// of them, one OBCameraNodeDriver per entry of ~cameras. Camera <name> publishes under <name>/
+// and reads its parameters from ~<name>/. Devices that show up together are started in parallel.
+class OBMultiCameraDriver {
+ public:
+  OBMultiCameraDriver(ros::NodeHandle& nh, ros::NodeHandle& nh_private);
+
+  ~OBMultiCameraDriver();
+
+  // True when nh_private lists the cameras to host in ~cameras.
+  static bool isConfigured(const ros::NodeHandle& nh_private);
+
+ private:
+  void init();
+
+  // Splits the derived link budget between the cameras on one USB bus through
+  // ~<name>/bandwidth_share, unless the camera sets its own bandwidth_budget.
+  void shareLinkBudget();
+
+  // Offers the list to every camera without a device, each on its own thread.
+  void connectCameras(const std::shared_ptr<ob::DeviceList>& list);
+
+  void queryDevices();
+
+  bool allConnected() const;
+
+ private:
+  ros::NodeHandle nh_;
+  ros::NodeHandle nh_private_;
+  std::string config_path_;
+  SharedDriverResources shared_;
+  std::vector<std::string> camera_names_;
+  std::vector<std::shared_ptr<OBCameraNodeDriver>> drivers_;
+  std::mutex connect_lock_;
+  std::atomic_bool is_alive_{false};
+  std::mutex query_lock_;
+  std::condition_variable query_cv_;
+  std::shared_ptr<std::thread> query_thread_ = nullptr;
+};
+}  // namespace orbbec_camera
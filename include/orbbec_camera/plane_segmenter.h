@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+#include "worker_pool.h"
+
+namespace orbbec_camera {
+// Dominant plane of a float32 x/y/z cloud by RANSAC on a subsample of its points. The previous
+// frame's plane is scored as the first hypothesis and, when it still holds, only a fraction of
+// the iterations is run. Removing the plane is one classification pass split over a WorkerPool.
+class PlaneSegmenter {
+ public:
+  struct Config {
+    double distance_threshold = 0.02;  // meters, inlier distance to the plane
+    int max_iterations = 100;
+    int max_samples = 2000;         // points the hypotheses are scored on
+    double min_inlier_ratio = 0.2;  // of the samples, below this no plane is reported
+  };
+
+  explicit PlaneSegmenter(int num_threads);
+
+  explicit PlaneSegmenter(std::shared_ptr<WorkerPool> pool);
+
+  void setConfig(const Config &config);
+
+  // The plane normal is oriented towards this point, the sensor origin of the cloud's frame.
+  void setViewpoint(float x, float y, float z) {
+    viewpoint_[0] = x;
+    viewpoint_[1] = y;
+    viewpoint_[2] = z;
+  }
+
+  // points holds count points of float x/y/z at the given stride, invalid points are NaN.
+  bool fit(const uint8_t *points, uint32_t point_step, size_t count);
+
+  // a, b, c, d of a * x + b * y + c * z + d = 0 with a unit normal, valid after fit() succeeded.
+  const float *plane() const { return plane_; }
+
+  float inlierRatio() const { return inlier_ratio_; }
+
+  // Copies the points farther than the distance threshold from the plane into output (same
+  // stride, room for count points). Plane points are set to NaN when keep_organized is true and
+  // dropped otherwise. Returns the number of points written.
+  size_t removePlane(const uint8_t *points, uint32_t point_step, size_t count, bool keep_organized,
+                     uint8_t *output);
+
+  // Forgets the previous plane, the next fit() starts cold.
+  void reset() { has_previous_ = false; }
+
+ private:
+  size_t countInliers(const float plane[4]) const;
+
+  bool refine(float plane[4]) const;
+
+  Config config_;
+  float viewpoint_[3] = {0, 0, 0};
+  float plane_[4] = {0, 0, 0, 0};
+  float inlier_ratio_ = 0.0f;
+  bool has_previous_ = false;
+  std::vector<float> samples_;
+  std::minstd_rand random_;
+  std::vector<size_t> chunk_counts_;
+  std::shared_ptr<WorkerPool> pool_;
+};
+}  // namespace orbbec_camera
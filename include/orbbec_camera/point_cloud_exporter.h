@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <sensor_msgs/PointCloud2.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "libobsensor/ObSensor.hpp"
+
+namespace orbbec_camera {
+enum class PointCloudFileFormat { PLY, PCD };
+
+PointCloudFileFormat pointCloudFileFormatFromString(const std::string &format);
+
+// Writes point clouds as binary little-endian PLY or binary PCD. Valid points are packed into a
+// reusable staging buffer in a single pass over the cloud, then the header and the body are
+// written with one writev() call. Errors are reported with std::runtime_error.
+class PointCloudExporter {
+ public:
+  explicit PointCloudExporter(PointCloudFileFormat format = PointCloudFileFormat::PLY);
+
+  PointCloudFileFormat format() const { return format_; }
+
+  // File extension including the dot, ".ply" or ".pcd".
+  std::string extension() const;
+
+  // Accepts float32 x/y/z in meters or int16 x/y/z in millimeters (compact encoding) with an
+  // optional packed "rgb" field. NaN points (all-zero points for int16) are skipped.
+  size_t exportCloud(const sensor_msgs::PointCloud2 &msg, const std::string &filename);
+
+  // SDK point frames, coordinates are written unchanged (millimeters).
+  size_t exportPoints(const OBPoint *points, size_t count, const std::string &filename);
+
+  size_t exportPoints(const OBColorPoint *points, size_t count, const std::string &filename);
+
+  // Streaming export of consecutive clouds into <prefix>_<sequence><extension>.
+  void startSequence(const std::string &prefix);
+
+  std::string exportNext(const sensor_msgs::PointCloud2 &msg);
+
+  // Throughput of the last export and since construction, in MB/s.
+  double lastThroughput() const { return last_throughput_; }
+
+  double averageThroughput() const;
+
+ private:
+  template <typename Getter>
+  size_t write(size_t count, bool with_color, Getter get_point, const std::string &filename);
+
+  std::string header(size_t valid_count, bool with_color) const;
+
+  void writeFile(const std::string &filename, const std::string &header, size_t body_size);
+
+  PointCloudFileFormat format_;
+  std::vector<uint8_t> body_;
+  std::string sequence_prefix_;
+  uint64_t sequence_ = 0;
+  double last_throughput_ = 0.0;
+  uint64_t total_bytes_ = 0;
+  double total_seconds_ = 0.0;
+};
+}  // namespace orbbec_camera
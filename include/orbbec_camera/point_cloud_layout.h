@@ -0,0 +1,148 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/point_cloud2_iterator.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace orbbec_camera {
+
+enum class PointCloudEncoding { FLOAT32, COMPACT };
+
+// Per-point value written next to x/y/z.
+enum class PointAttribute { NONE, RGB, INTENSITY };
+
+// Default layout: float32 x/y/z in metres, optional packed "rgb" field.
+// Matches what the node has always published.
+struct Float32PointLayout {
+  static void setupFields(sensor_msgs::PointCloud2 &msg, PointAttribute attribute) {
+    msg.fields.clear();
+    int offset = sensor_msgs::addPointField(msg, "x", 1, sensor_msgs::PointField::FLOAT32, 0);
+    offset = sensor_msgs::addPointField(msg, "y", 1, sensor_msgs::PointField::FLOAT32, offset);
+    offset = sensor_msgs::addPointField(msg, "z", 1, sensor_msgs::PointField::FLOAT32, offset);
+    offset += sensor_msgs::sizeOfPointField(sensor_msgs::PointField::FLOAT32);
+    if (attribute == PointAttribute::RGB) {
+      offset =
+          sensor_msgs::addPointField(msg, "rgb", 1, sensor_msgs::PointField::FLOAT32, offset);
+    } else if (attribute == PointAttribute::INTENSITY) {
+      offset = sensor_msgs::addPointField(msg, "intensity", 1, sensor_msgs::PointField::FLOAT32,
+                                          offset);
+    }
+    msg.point_step = offset;
+  }
+
+  static uint32_t attributeOffset() { return 16; }
+
+  static inline void setIntensity(uint8_t *dest, uint16_t value) {
+    const float intensity = value;
+    std::memcpy(dest, &intensity, sizeof(intensity));
+  }
+
+  static inline void setInvalid(uint8_t *point) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float xyz[3] = {nan, nan, nan};
+    std::memcpy(point, xyz, sizeof(xyz));
+  }
+
+  // x, y, z are given in millimetres.
+  static inline void setXYZ(uint8_t *point, float x, float y, float z) {
+    const float xyz[3] = {x * 0.001f, y * 0.001f, z * 0.001f};
+    std::memcpy(point, xyz, sizeof(xyz));
+  }
+};
+
+// Compact layout for bandwidth limited links: int16 x/y/z in millimetres and a
+// uint32 packed "rgb" field. 6 bytes per point (12 with color) instead of 16 (20).
+struct CompactPointLayout {
+  static void setupFields(sensor_msgs::PointCloud2 &msg, PointAttribute attribute) {
+    msg.fields.clear();
+    int offset = sensor_msgs::addPointField(msg, "x", 1, sensor_msgs::PointField::INT16, 0);
+    offset = sensor_msgs::addPointField(msg, "y", 1, sensor_msgs::PointField::INT16, offset);
+    offset = sensor_msgs::addPointField(msg, "z", 1, sensor_msgs::PointField::INT16, offset);
+    if (attribute == PointAttribute::RGB) {
+      offset = sensor_msgs::addPointField(msg, "rgb", 1, sensor_msgs::PointField::UINT32,
+                                          static_cast<int>(attributeOffset()));
+    } else if (attribute == PointAttribute::INTENSITY) {
+      offset = sensor_msgs::addPointField(msg, "intensity", 1, sensor_msgs::PointField::UINT16,
+                                          static_cast<int>(attributeOffset()));
+    }
+    msg.point_step = offset;
+  }
+
+  static uint32_t attributeOffset() { return 8; }
+
+  static inline void setIntensity(uint8_t *dest, uint16_t value) {
+    std::memcpy(dest, &value, sizeof(value));
+  }
+
+  static inline int16_t toInt16(float value) {
+    const float max_value = std::numeric_limits<int16_t>::max();
+    const float min_value = std::numeric_limits<int16_t>::min();
+    value = value > max_value ? max_value : (value < min_value ? min_value : value);
+    return static_cast<int16_t>(std::lrint(value));
+  }
+
+  // int16 has no NaN, invalid points of an organized cloud are written as the origin.
+  static inline void setInvalid(uint8_t *point) { std::memset(point, 0, 3 * sizeof(int16_t)); }
+
+  // x, y, z are given in millimetres.
+  static inline void setXYZ(uint8_t *point, float x, float y, float z) {
+    const int16_t xyz[3] = {toInt16(x), toInt16(y), toInt16(z)};
+    std::memcpy(point, xyz, sizeof(xyz));
+  }
+};
+
+// Packs r/g/b the way PCL and rviz expect it: 0x00RRGGBB in a little-endian uint32.
+inline void setPackedRGB(uint8_t *dest, uint8_t r, uint8_t g, uint8_t b) {
+  const uint32_t rgb = (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | b;
+  std::memcpy(dest, &rgb, sizeof(rgb));
+}
+
+// Attribute sources used by the generation kernel, indexed by pixel. The kernel is instantiated
+// per source, so the xyz-only path carries no attribute code at all.
+struct NoAttributeSource {
+  template <typename Layout>
+  void write(uint8_t *, size_t) const {}
+};
+
+struct RGBAttributeSource {
+  template <typename Layout>
+  void write(uint8_t *dest, size_t index) const {
+    const uint8_t *pixel = rgb + index * 3;
+    setPackedRGB(dest, pixel[0], pixel[1], pixel[2]);
+  }
+
+  const uint8_t *rgb = nullptr;
+};
+
+// Y8 or Y16 IR image pixel-aligned with depth.
+template <typename Pixel>
+struct IntensityAttributeSource {
+  template <typename Layout>
+  void write(uint8_t *dest, size_t index) const {
+    Layout::setIntensity(dest, static_cast<uint16_t>(ir[index]));
+  }
+
+  const Pixel *ir = nullptr;
+};
+
+}  // namespace orbbec_camera
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include "libobsensor/h/ObTypes.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace orbbec_camera {
+// Picks one video profile per stream so that the estimated link traffic fits a budget.
+// Independent of the SDK objects, the node fills in what the profile lists offer.
+class ProfilePlanner {
+ public:
+  struct Profile {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t fps = 0;
+    OBFormat format = OB_FORMAT_UNKNOWN;
+  };
+
+  struct Stream {
+    std::string name;
+    // zero fields and OB_FORMAT_UNKNOWN take the value of the first matching candidate
+    Profile requested;
+    // tried in this order after the requested format, before the remaining ones
+    std::vector<OBFormat> fallback_formats;
+    // what the device offers, in profile list order
+    std::vector<Profile> candidates;
+    // streams that are set up but never started stay out of the budget
+    bool counted = true;
+  };
+
+  struct Choice {
+    int candidate = -1;  // index into Stream::candidates, -1 when there is none
+    bool exact = false;  // the requested profile was available
+    bool degraded = false;  // moved below the best match to fit the budget
+    double mb_per_s = 0.0;
+  };
+
+  struct Plan {
+    std::vector<Choice> choices;  // one per stream, same order
+    double total_mb_per_s = 0.0;
+    double budget_mb_per_s = 0.0;
+    bool fits = true;
+  };
+
+  // Wire bytes per pixel, a rough compression ratio for the encoded formats.
+  static double bytesPerPixel(OBFormat format);
+
+  static double bandwidth(const Profile &profile);
+
+  // Usable MB/s of a connection type reported by the SDK ("USB2.0", "USB3.1", "Ethernet", ...).
+  static double linkBudget(const std::string &connection_type);
+
+  // Starts from the best match of every stream and, while over budget, steps the stream with
+  // the most traffic to its next lower-traffic option. A budget <= 0 disables the stepping.
+  static Plan plan(const std::vector<Stream> &streams, double budget_mb_per_s);
+};
+}  // namespace orbbec_camera
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <tf2/LinearMath/Transform.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ray_table.h"
+
+namespace orbbec_camera {
+// Finds the closest depth pixel inside each of a set of axis-aligned boxes, straight from the
+// raw depth frame. Pixels are projected through a RayTable in the box frame, and pixels farther
+// than the farthest box corner are rejected on the raw value before any arithmetic.
+class ProximityMonitor {
+ public:
+  struct Region {
+    std::string name;
+    float min[3] = {0, 0, 0};  // meters, in the region frame
+    float max[3] = {0, 0, 0};
+  };
+
+  struct Result {
+    bool occupied = false;
+    float distance = 0.0f;  // meters from the optical frame origin
+    int u = -1;
+    int v = -1;
+  };
+
+  // Parses "name:min_x,min_y,min_z,max_x,max_y,max_z;name:...".
+  static bool parseRegions(const std::string &spec, std::vector<Region> &regions,
+                           std::string &error);
+
+  void setRegions(const std::vector<Region> &regions);
+
+  const std::vector<Region> &regions() const { return regions_; }
+
+  // Pose of the depth optical frame in the region frame, meters.
+  void setTransform(const tf2::Transform &region_from_optical);
+
+  const tf2::Transform &transform() const { return region_from_optical_; }
+
+  // Rays of the depth frame, built with the rotation of transform().
+  void setRayTable(std::shared_ptr<const RayTable> rays) { rays_ = std::move(rays); }
+
+  // results is resized to one entry per region, in the order of regions().
+  bool evaluate(const uint16_t *depth_data, int width, int height, float depth_scale,
+                std::vector<Result> &results) const;
+
+ private:
+  void updateMaxDistance();
+
+  std::vector<Region> regions_;
+  tf2::Transform region_from_optical_ = tf2::Transform::getIdentity();
+  std::shared_ptr<const RayTable> rays_;
+  float translation_[3] = {0, 0, 0};
+  // no box point is farther than this from the camera, meters
+  float max_distance_ = 0.0f;
+};
+}  // namespace orbbec_camera
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <tf2/LinearMath/Matrix3x3.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "libobsensor/h/ObTypes.h"
+
+namespace orbbec_camera {
+// Per-column and per-row terms of the optical rays of a depth frame with the rotation of the
+// output frame folded in: rotation * ((u - cx) / fx, (v - cy) / fy, 1) = column[u] + row[v].
+// A pixel at depth z then costs one multiply-add per axis, z * (column[u] + row[v]) + origin.
+struct RayTable {
+  struct Key {
+    int width = 0;
+    int height = 0;
+    float fx = 0, fy = 0, cx = 0, cy = 0;  // scaled to width x height
+    float rotation[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+    bool operator==(const Key &other) const;
+  };
+
+  // Intrinsics calibrated at another resolution are scaled to the frame size.
+  static Key makeKey(const OBCameraIntrinsic &intrinsic, int width, int height,
+                     const tf2::Matrix3x3 &rotation);
+
+  explicit RayTable(const Key &key);
+
+  Key key;
+  std::vector<float> column;  // 3 floats per column
+  std::vector<float> row;     // 3 floats per row
+  // squared optical ray length, |ray(u, v)|^2 = column_squared[u] + row_squared[v] + 1
+  std::vector<float> column_squared;
+  std::vector<float> row_squared;
+};
+
+// The ray tables of one node, shared by the point clouds, the height map and the proximity
+// monitor. A table is built the first time its key is asked for and kept while the frame
+// geometry stays the same.
+class RayTableCache {
+ public:
+  std::shared_ptr<const RayTable> get(const RayTable::Key &key);
+
+  void clear();
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<const RayTable>> tables_;  // most recently used last
+};
+}  // namespace orbbec_camera
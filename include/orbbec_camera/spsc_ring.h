@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace orbbec_camera {
+// Bounded lock-free ring for exactly one producer thread and one consumer thread. push() fails
+// instead of blocking when the ring is full, the caller decides what to do with the element.
+template <typename T>
+class SpscRing {
+ public:
+  // capacity is rounded up to a power of two.
+  explicit SpscRing(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    buffer_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscRing(const SpscRing &) = delete;
+
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  // Producer side.
+  bool push(const T &value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) > mask_) {
+      return false;
+    }
+    buffer_[head & mask_] = value;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side.
+  bool pop(T &value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = buffer_[tail & mask_];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side, drops everything queued so far.
+  void clear() { tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release); }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  std::vector<T> buffer_;
+  size_t mask_ = 0;
+  // head and tail are written by different threads, keep them on separate cache lines
+  char pad0_[64];
+  std::atomic<size_t> head_{0};
+  char pad1_[64];
+  std::atomic<size_t> tail_{0};
+  char pad2_[64];
+};
+}  // namespace orbbec_camera
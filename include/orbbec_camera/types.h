@@ -33,6 +33,7 @@
 #include "orbbec_camera/SetBool.h"
 #include "orbbec_camera/SetInt32.h"
 #include "orbbec_camera/SetString.h"
+#include "orbbec_camera/SetStreamProfile.h"
 #include "orbbec_camera/GetCameraParams.h"
 #include "std_srvs/SetBool.h"
 #include "std_srvs/Empty.h"
@@ -56,6 +57,9 @@ const stream_index_pair ACCEL{OB_STREAM_ACCEL, 0};
 const std::vector<stream_index_pair> IMAGE_STREAMS = {DEPTH, INFRA0, COLOR, INFRA1, INFRA2};
 
 const std::vector<stream_index_pair> HID_STREAMS = {GYRO, ACCEL};
+
+// What happens to running image streams once nobody subscribes to them.
+enum class IdlePolicy { KEEP, STANDBY, STOP };
 const std::map<std::string, OBDepthPrecisionLevel> DEPTH_PRECISION_STR2ENUM = {
     {"1mm", OB_PRECISION_1MM},    {"0.8mm", OB_PRECISION_0MM8}, {"0.4mm", OB_PRECISION_0MM4},
     {"0.2mm", OB_PRECISION_0MM2}, {"0.1mm", OB_PRECISION_0MM1},
@@ -23,6 +23,7 @@
 #include "types.h"
 #include "sensor_msgs/PointCloud2.h"
 #include "orbbec_camera/Extrinsics.h"
+#include "point_cloud_layout.h"
 #include <opencv2/opencv.hpp>
 
 // Utility function for failure messages
@@ -93,6 +94,7 @@ std::string ObDeviceTypeToString(const OBDeviceType &type);
 sensor_msgs::CameraInfo convertToCameraInfo(OBCameraIntrinsic intrinsic,
                                             OBCameraDistortion distortion, int width);
 
+// The PLY writers below write binary little-endian PLY through PointCloudExporter.
 void savePointsToPly(std::shared_ptr<ob::Frame> frame, const std::string &fileName);
 
 void saveRGBPointsToPly(std::shared_ptr<ob::Frame> frame, const std::string &fileName);
@@ -141,6 +143,12 @@ OBHoleFillingMode holeFillingModeFromString(const std::string &hole_filling_mode
 
 float depthPrecisionFromString(const std::string &depth_precision_level_str);
 
+PointCloudEncoding pointCloudEncodingFromString(const std::string &encoding);
+
+IdlePolicy idlePolicyFromString(const std::string &policy);
+
+std::string idlePolicyToString(IdlePolicy policy);
+
 std::ostream &operator<<(std::ostream &os, const OBFormat &rhs);
 
 std::string OBSensorTypeToString(const OBSensorType &type);
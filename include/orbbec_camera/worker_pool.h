@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace orbbec_camera {
+// Fixed set of threads used to split per-frame loops (point cloud post processing) into row
+// ranges. The calling thread takes part in the work, so a pool of N workers runs N + 1 chunks.
+// One pool can be shared by several cameras: every call queues its own job, the workers take
+// chunks from the queued jobs in turn and each caller keeps working on its own chunks, so a
+// caller never waits for another camera's frame to finish.
+class WorkerPool {
+ public:
+  explicit WorkerPool(int num_workers);
+
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  // Calls fn(chunk_begin, chunk_end) over disjoint ranges covering [begin, end) and returns
+  // once all of them are done. Safe to call from several threads at once.
+  void parallelFor(int begin, int end, const std::function<void(int, int)> &fn);
+
+  int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+ private:
+  // lives on the caller's stack for the duration of parallelFor
+  struct Job {
+    const std::function<void(int, int)> *fn = nullptr;
+    int begin = 0;
+    int end = 0;
+    int chunk_count = 0;
+    int next_chunk = 0;
+    int pending_chunks = 0;
+  };
+
+  void workerLoop();
+
+  // mutex_ held, false once every chunk of the job is claimed
+  bool claimChunkLocked(Job &job, int &chunk_begin, int &chunk_end);
+
+  void finishChunk(Job &job);
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Job *> jobs_;  // jobs with unclaimed chunks, served round robin
+  bool stop_ = false;
+};
+}  // namespace orbbec_camera
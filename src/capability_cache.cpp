@@ -0,0 +1,225 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/capability_cache.h"
+
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace orbbec_camera {
+namespace {
+// bump when the layout of the file changes
+constexpr int CACHE_FORMAT = 1;
+
+std::string propertyKey(int property, int permission) {
+  return std::to_string(property) + ":" + std::to_string(permission);
+}
+
+std::string toHex(const uint8_t *data, size_t size) {
+  static const char digits[] = "0123456789abcdef";
+  std::string hex(size * 2, '0');
+  for (size_t i = 0; i < size; i++) {
+    hex[2 * i] = digits[data[i] >> 4];
+    hex[2 * i + 1] = digits[data[i] & 0x0f];
+  }
+  return hex;
+}
+
+bool fromHex(const std::string &hex, uint8_t *data, size_t size) {
+  if (hex.size() != size * 2) {
+    return false;
+  }
+  auto nibble = [](char c) -> int {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+    return -1;
+  };
+  for (size_t i = 0; i < size; i++) {
+    int high = nibble(hex[2 * i]);
+    int low = nibble(hex[2 * i + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    data[i] = static_cast<uint8_t>((high << 4) | low);
+  }
+  return true;
+}
+}  // namespace
+
+CapabilityCache::CapabilityCache(const std::string &directory, const std::string &serial_number,
+                                 const std::string &firmware_version)
+    : path_(directory + "/" + serial_number + ".json"),
+      serial_number_(serial_number),
+      firmware_version_(firmware_version) {
+  reset();
+}
+
+bool CapabilityCache::load() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  reset();
+  std::ifstream file(path_);
+  if (!file.is_open()) {
+    return false;
+  }
+  nlohmann::json data = nlohmann::json::parse(file, nullptr, false);
+  if (data.is_discarded() || !data.is_object() || data.value("format", 0) != CACHE_FORMAT ||
+      data.value("serial_number", "") != serial_number_ ||
+      data.value("firmware_version", "") != firmware_version_ ||
+      data.value("camera_param_size", 0) != static_cast<int>(sizeof(OBCameraParam))) {
+    // stale or foreign, it is overwritten by the next save()
+    dirty_ = true;
+    return false;
+  }
+  data_ = data;
+  dirty_ = false;
+  return true;
+}
+
+bool CapabilityCache::save() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!dirty_) {
+    return true;
+  }
+  boost::system::error_code error;
+  boost::filesystem::create_directories(boost::filesystem::path(path_).parent_path(), error);
+  if (error) {
+    return false;
+  }
+  // write a temporary file and rename it, a concurrent reader never sees half a file
+  const std::string temporary_path = path_ + ".tmp";
+  {
+    std::ofstream file(temporary_path);
+    if (!file.is_open()) {
+      return false;
+    }
+    file << data_.dump(2);
+    if (!file.good()) {
+      return false;
+    }
+  }
+  if (std::rename(temporary_path.c_str(), path_.c_str()) != 0) {
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+  dirty_ = false;
+  return true;
+}
+
+bool CapabilityCache::propertySupported(int property, int permission, bool &supported) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto properties = data_.find("properties");
+  if (properties == data_.end() || !properties->is_object()) {
+    return false;
+  }
+  auto it = properties->find(propertyKey(property, permission));
+  if (it == properties->end() || !it->is_boolean()) {
+    return false;
+  }
+  supported = it->get<bool>();
+  return true;
+}
+
+void CapabilityCache::setPropertySupported(int property, int permission, bool supported) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  data_["properties"][propertyKey(property, permission)] = supported;
+  dirty_ = true;
+}
+
+bool CapabilityCache::sensorStreams(std::vector<std::vector<int>> &streams) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = data_.find("sensor_streams");
+  if (it == data_.end() || !it->is_array()) {
+    return false;
+  }
+  try {
+    streams = it->get<std::vector<std::vector<int>>>();
+  } catch (const nlohmann::json::exception &) {
+    return false;
+  }
+  return true;
+}
+
+void CapabilityCache::setSensorStreams(const std::vector<std::vector<int>> &streams) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  data_["sensor_streams"] = streams;
+  dirty_ = true;
+}
+
+bool CapabilityCache::cameraParams(std::vector<OBCameraParam> &params) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = data_.find("camera_params");
+  if (it == data_.end() || !it->is_array()) {
+    return false;
+  }
+  std::vector<OBCameraParam> result(it->size());
+  for (size_t i = 0; i < result.size(); i++) {
+    const auto &entry = (*it)[i];
+    if (!entry.is_string() || !fromHex(entry.get<std::string>(),
+                                       reinterpret_cast<uint8_t *>(&result[i]),
+                                       sizeof(OBCameraParam))) {
+      return false;
+    }
+  }
+  params.swap(result);
+  return true;
+}
+
+void CapabilityCache::setCameraParams(const std::vector<OBCameraParam> &params) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entries = nlohmann::json::array();
+  for (const auto &param : params) {
+    entries.push_back(toHex(reinterpret_cast<const uint8_t *>(&param), sizeof(param)));
+  }
+  data_["camera_params"] = entries;
+  dirty_ = true;
+}
+
+bool CapabilityCache::value(const std::string &key, int &value) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto values = data_.find("values");
+  if (values == data_.end() || !values->is_object()) {
+    return false;
+  }
+  auto it = values->find(key);
+  if (it == values->end() || !it->is_number_integer()) {
+    return false;
+  }
+  value = it->get<int>();
+  return true;
+}
+
+void CapabilityCache::setValue(const std::string &key, int value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  data_["values"][key] = value;
+  dirty_ = true;
+}
+
+void CapabilityCache::reset() {
+  data_ = nlohmann::json::object();
+  data_["format"] = CACHE_FORMAT;
+  data_["serial_number"] = serial_number_;
+  data_["firmware_version"] = firmware_version_;
+  data_["camera_param_size"] = static_cast<int>(sizeof(OBCameraParam));
+  data_["properties"] = nlohmann::json::object();
+  data_["values"] = nlohmann::json::object();
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,177 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/clock_offset_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace orbbec_camera {
+namespace {
+constexpr double US_PER_SECOND = 1e6;
+// weight of a new residual in its running mean and variance, about the last 100 samples
+constexpr double RESIDUAL_ALPHA = 0.01;
+}  // namespace
+
+ClockOffsetEstimator::ClockOffsetEstimator(const Config &config) : config_(config) {
+  config_.window = std::max(config_.window, 1.0);
+  config_.bucket = std::min(std::max(config_.bucket, 0.001), config_.window);
+  config_.reset_threshold = std::max(config_.reset_threshold, 0.001);
+}
+
+void ClockOffsetEstimator::addSample(uint64_t device_us, uint64_t host_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!has_reference_) {
+    has_reference_ = true;
+    device_ref_ = device_us;
+    host_ref_ = host_us;
+  }
+  double x = static_cast<double>(static_cast<int64_t>(device_us - device_ref_));
+  double y = static_cast<double>(static_cast<int64_t>(host_us - host_ref_)) - x;
+  const double reset_threshold = config_.reset_threshold * US_PER_SECOND;
+  // samples of different streams may arrive slightly out of device order, only a large step
+  // back or away from the line means the device clock was reset
+  const bool jumped =
+      x < last_x_ - reset_threshold || std::fabs(y - lineAt(x)) > reset_threshold;
+  if (samples_ > 0 && jumped) {
+    ++resets_;
+    resetLocked();
+    has_reference_ = true;
+    device_ref_ = device_us;
+    host_ref_ = host_us;
+    x = 0.0;
+    y = 0.0;
+  }
+  last_x_ = samples_ > 0 ? std::max(last_x_, x) : x;
+  ++samples_;
+
+  if (!has_open_bucket_) {
+    has_open_bucket_ = true;
+    bucket_start_ = x;
+    open_bucket_ = {x, y};
+  } else if (x - bucket_start_ >= config_.bucket * US_PER_SECOND) {
+    buckets_.push_back(open_bucket_);
+    const double oldest = x - config_.window * US_PER_SECOND;
+    while (buckets_.size() > 2 && buckets_.front().x < oldest) {
+      buckets_.pop_front();
+    }
+    refitLocked();
+    bucket_start_ = x;
+    open_bucket_ = {x, y};
+  } else if (y < open_bucket_.y) {
+    open_bucket_ = {x, y};
+  }
+  if (buckets_.empty()) {
+    // no finished bucket yet, follow the lowest sample with a flat line
+    intercept_ = open_bucket_.y;
+    slope_ = 0.0;
+  }
+
+  const double residual = y - lineAt(x);
+  if (samples_ == 1) {
+    residual_mean_ = residual;
+    residual_var_ = 0.0;
+  } else {
+    const double delta = residual - residual_mean_;
+    residual_mean_ += RESIDUAL_ALPHA * delta;
+    residual_var_ = (1.0 - RESIDUAL_ALPHA) * (residual_var_ + RESIDUAL_ALPHA * delta * delta);
+  }
+}
+
+bool ClockOffsetEstimator::toHostTime(uint64_t device_us, uint64_t &host_us) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!has_reference_) {
+    return false;
+  }
+  const double x = static_cast<double>(static_cast<int64_t>(device_us - device_ref_));
+  host_us = host_ref_ + static_cast<uint64_t>(std::llround(x + lineAt(x)));
+  return true;
+}
+
+ClockOffsetEstimator::State ClockOffsetEstimator::state() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  State state;
+  state.valid = buckets_.size() >= 2;
+  if (has_reference_) {
+    const double reference_offset = static_cast<double>(static_cast<int64_t>(host_ref_)) -
+                                    static_cast<double>(static_cast<int64_t>(device_ref_));
+    state.offset = (reference_offset + lineAt(last_x_)) / US_PER_SECOND;
+  }
+  state.skew = slope_ * 1e6;
+  state.jitter = std::sqrt(residual_var_) / US_PER_SECOND;
+  state.latency = residual_mean_ / US_PER_SECOND;
+  state.samples = samples_;
+  state.resets = resets_;
+  return state;
+}
+
+void ClockOffsetEstimator::reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  resetLocked();
+}
+
+void ClockOffsetEstimator::resetLocked() {
+  has_reference_ = false;
+  device_ref_ = 0;
+  host_ref_ = 0;
+  last_x_ = 0.0;
+  buckets_.clear();
+  has_open_bucket_ = false;
+  intercept_ = 0.0;
+  slope_ = 0.0;
+  residual_mean_ = 0.0;
+  residual_var_ = 0.0;
+  samples_ = 0;
+}
+
+void ClockOffsetEstimator::refitLocked() {
+  std::vector<Point> points(buckets_.begin(), buckets_.end());
+  std::sort(points.begin(), points.end(),
+            [](const Point &a, const Point &b) { return a.x < b.x; });
+  // lower convex hull, monotone chain
+  std::vector<Point> hull;
+  hull.reserve(points.size());
+  double mean_x = 0.0;
+  for (const auto &p : points) {
+    mean_x += p.x;
+    while (hull.size() >= 2) {
+      const Point &a = hull[hull.size() - 2];
+      const Point &b = hull.back();
+      const double cross = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+      if (cross > 0.0) {
+        break;
+      }
+      hull.pop_back();
+    }
+    hull.push_back(p);
+  }
+  mean_x /= static_cast<double>(points.size());
+  if (hull.size() < 2 || hull.back().x <= hull.front().x) {
+    slope_ = 0.0;
+    intercept_ = hull.front().y;
+    return;
+  }
+  size_t edge = 0;
+  while (edge + 2 < hull.size() && hull[edge + 1].x < mean_x) {
+    ++edge;
+  }
+  const Point &a = hull[edge];
+  const Point &b = hull[edge + 1];
+  slope_ = b.x > a.x ? (b.y - a.y) / (b.x - a.x) : 0.0;
+  intercept_ = a.y - slope_ * a.x;
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/depth_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace orbbec_camera {
+namespace {
+constexpr size_t RAW_VALUE_COUNT = 1 << 16;
+}  // namespace
+
+DepthStatistics::DepthStatistics() {
+  raw_histogram_[0].assign(RAW_VALUE_COUNT, 0);
+  raw_histogram_[1].assign(RAW_VALUE_COUNT, 0);
+}
+
+void DepthStatistics::setConfig(const Config &config) {
+  config_ = config;
+  config_.bin_width = std::max(config_.bin_width, 0.001);
+  config_.max_range = std::max(config_.max_range, config_.bin_width);
+}
+
+void DepthStatistics::compute(const uint16_t *depth_data, uint32_t width, uint32_t height,
+                              float depth_scale, DepthStats &stats) {
+  const size_t count = static_cast<size_t>(width) * height;
+  uint32_t *even = raw_histogram_[0].data();
+  uint32_t *odd = raw_histogram_[1].data();
+  size_t i = 0;
+  for (; i + 1 < count; i += 2) {
+    ++even[depth_data[i]];
+    ++odd[depth_data[i + 1]];
+  }
+  if (i < count) {
+    ++even[depth_data[i]];
+  }
+
+  const size_t bin_count =
+      static_cast<size_t>(std::ceil(config_.max_range / config_.bin_width)) + 1;
+  stats.width = width;
+  stats.height = height;
+  stats.histogram_bin_width = static_cast<float>(config_.bin_width);
+  stats.histogram.assign(bin_count, 0);
+
+  // raw value 0 marks a pixel without depth
+  const uint32_t invalid = even[0] + odd[0];
+  even[0] = odd[0] = 0;
+  const uint32_t valid = static_cast<uint32_t>(count) - invalid;
+  stats.valid_pixels = valid;
+  stats.valid_ratio = count > 0 ? static_cast<float>(valid) / static_cast<float>(count) : 0.0f;
+  stats.min_range = stats.median_range = stats.mean_range = stats.max_range = 0.0f;
+  if (valid == 0) {
+    return;
+  }
+
+  const double meters_per_unit = depth_scale * 0.001;
+  const double units_per_bin = config_.bin_width / meters_per_unit;
+  const uint32_t median_rank = (valid + 1) / 2;
+  uint32_t seen = 0;
+  uint64_t sum = 0;
+  uint32_t min_value = 0, max_value = 0, median_value = 0;
+  // the counters are cleared while they are read, ready for the next frame
+  for (size_t value = 1; value < RAW_VALUE_COUNT && seen < valid; ++value) {
+    const uint32_t n = even[value] + odd[value];
+    if (n == 0) {
+      continue;
+    }
+    even[value] = odd[value] = 0;
+    if (min_value == 0) {
+      min_value = static_cast<uint32_t>(value);
+    }
+    max_value = static_cast<uint32_t>(value);
+    if (seen < median_rank && seen + n >= median_rank) {
+      median_value = static_cast<uint32_t>(value);
+    }
+    seen += n;
+    sum += static_cast<uint64_t>(value) * n;
+    const size_t bin = std::min(static_cast<size_t>(value / units_per_bin), bin_count - 1);
+    stats.histogram[bin] += n;
+  }
+  stats.min_range = static_cast<float>(min_value * meters_per_unit);
+  stats.median_range = static_cast<float>(median_value * meters_per_unit);
+  stats.mean_range = static_cast<float>(static_cast<double>(sum) / valid * meters_per_unit);
+  stats.max_range = static_cast<float>(max_value * meters_per_unit);
+}
+}  // namespace orbbec_camera
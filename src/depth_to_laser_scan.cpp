@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/depth_to_laser_scan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace orbbec_camera {
+void DepthToLaserScan::setConfig(const Config &config) {
+  config_ = config;
+  config_.band_height = std::max(config_.band_height, 1);
+  // force a rebuild on the next frame
+  width_ = 0;
+  height_ = 0;
+}
+
+void DepthToLaserScan::updateIntrinsics(const OBCameraIntrinsic &intrinsic, int width,
+                                        int height) {
+  const float fx = intrinsic.fx * (static_cast<float>(width) / intrinsic.width);
+  const float cx = intrinsic.cx * (static_cast<float>(width) / intrinsic.width);
+  const float cy = intrinsic.cy * (static_cast<float>(height) / intrinsic.height);
+  if (width == width_ && height == height_ && fx == fx_ && cx == cx_ && cy == cy_) {
+    return;
+  }
+  width_ = width;
+  height_ = height;
+  fx_ = fx;
+  cx_ = cx;
+  cy_ = cy;
+  // the scan is in the camera frame (x forward, y left), so column 0 has the largest angle
+  angle_max_ = -std::atan((0 - cx_) / fx_);
+  angle_min_ = -std::atan((width_ - 1 - cx_) / fx_);
+  angle_increment_ = config_.angle_increment > 0
+                         ? static_cast<float>(config_.angle_increment)
+                         : (angle_max_ - angle_min_) / static_cast<float>(std::max(width_ - 1, 1));
+  bin_count_ = static_cast<int>(std::lround((angle_max_ - angle_min_) / angle_increment_)) + 1;
+  column_bin_.resize(width_);
+  column_range_factor_.resize(width_);
+  for (int u = 0; u < width_; u++) {
+    const float ray = (u - cx_) / fx_;
+    const float angle = -std::atan(ray);
+    column_bin_[u] = static_cast<int>(std::lround((angle - angle_min_) / angle_increment_));
+    column_range_factor_[u] = std::sqrt(1.0f + ray * ray) * 0.001f;
+  }
+}
+
+bool DepthToLaserScan::project(const uint16_t *depth_data, int width, int height,
+                               float depth_scale, sensor_msgs::LaserScan &scan) const {
+  if (width != width_ || height != height_ || column_bin_.empty()) {
+    return false;
+  }
+  const int bin_count = bin_count_;
+  scan.angle_min = angle_min_;
+  scan.angle_max = angle_min_ + (bin_count - 1) * angle_increment_;
+  scan.angle_increment = angle_increment_;
+  scan.time_increment = 0.0;
+  scan.scan_time = 0.0;
+  scan.range_min = static_cast<float>(config_.range_min);
+  scan.range_max = static_cast<float>(config_.range_max);
+  scan.ranges.assign(bin_count, std::numeric_limits<float>::infinity());
+  scan.intensities.clear();
+
+  const int center_row = config_.row >= 0 ? config_.row : static_cast<int>(std::lround(cy_));
+  const int row_begin = std::max(center_row - config_.band_height / 2, 0);
+  const int row_end = std::min(row_begin + config_.band_height, height);
+  const float range_min = scan.range_min;
+  const float range_max = scan.range_max;
+  float *ranges = scan.ranges.data();
+  for (int v = row_begin; v < row_end; v++) {
+    const uint16_t *depth_row = depth_data + v * width;
+    for (int u = 0; u < width; u++) {
+      if (depth_row[u] == 0) {
+        continue;
+      }
+      const float range = depth_row[u] * depth_scale * column_range_factor_[u];
+      if (range < range_min || range > range_max) {
+        continue;
+      }
+      float &bin = ranges[column_bin_[u]];
+      bin = std::min(bin, range);
+    }
+  }
+  return true;
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/device_serial_cache.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace orbbec_camera {
+DeviceSerialCache::DeviceSerialCache(const std::string &path) : path_(path) {}
+
+bool DeviceSerialCache::lookup(const std::string &uid, std::string &serial_number) const {
+  bool found = false;
+  access(false, [&](nlohmann::json &map) {
+    auto it = map.find(uid);
+    if (it != map.end() && it->is_string()) {
+      serial_number = it->get<std::string>();
+      found = true;
+    }
+    return false;
+  });
+  return found;
+}
+
+void DeviceSerialCache::store(const std::string &uid, const std::string &serial_number) {
+  if (uid.empty() || serial_number.empty()) {
+    return;
+  }
+  access(true, [&](nlohmann::json &map) {
+    auto it = map.find(uid);
+    if (it != map.end() && *it == serial_number) {
+      return false;
+    }
+    map[uid] = serial_number;
+    return true;
+  });
+}
+
+void DeviceSerialCache::erase(const std::vector<std::string> &uids) {
+  access(true, [&](nlohmann::json &map) {
+    bool changed = false;
+    for (const auto &uid : uids) {
+      changed = map.erase(uid) > 0 || changed;
+    }
+    return changed;
+  });
+}
+
+bool DeviceSerialCache::access(bool exclusive,
+                               const std::function<bool(nlohmann::json &)> &fn) const {
+  int fd = open(path_.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0666);
+  if (fd < 0) {
+    return false;
+  }
+  // shared by the nodes of every user on this host
+  (void)fchmod(fd, 0666);
+  if (flock(fd, exclusive ? LOCK_EX : LOCK_SH) != 0) {
+    close(fd);
+    return false;
+  }
+  std::string content;
+  char buffer[4096];
+  ssize_t count = 0;
+  while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+    content.append(buffer, static_cast<size_t>(count));
+  }
+  nlohmann::json map = nlohmann::json::parse(content, nullptr, false);
+  if (map.is_discarded() || !map.is_object()) {
+    map = nlohmann::json::object();
+  }
+  bool ok = true;
+  if (fn(map) && exclusive) {
+    const std::string data = map.dump();
+    ok = ftruncate(fd, 0) == 0 &&
+         pwrite(fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size());
+  }
+  flock(fd, LOCK_UN);
+  close(fd);
+  return ok;
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,141 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/height_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace orbbec_camera {
+HeightMapProjector::HeightMapProjector(int num_threads)
+    : HeightMapProjector(std::make_shared<WorkerPool>(num_threads > 1 ? num_threads - 1 : 0)) {}
+
+HeightMapProjector::HeightMapProjector(std::shared_ptr<WorkerPool> pool) : pool_(std::move(pool)) {}
+
+void HeightMapProjector::setConfig(const Config &config) {
+  config_ = config;
+  config_.width = std::max(config_.width, 1);
+  config_.height = std::max(config_.height, 1);
+  if (config_.resolution <= 0) {
+    config_.resolution = 0.02;
+  }
+}
+
+void HeightMapProjector::setTransform(const tf2::Transform &grid_from_optical) {
+  grid_from_optical_ = grid_from_optical;
+  const auto &origin = grid_from_optical_.getOrigin();
+  for (int i = 0; i < 3; i++) {
+    translation_[i] = static_cast<float>(origin[i]);
+  }
+  // built for the previous rotation
+  rays_.reset();
+}
+
+bool HeightMapProjector::project(const uint16_t *depth_data, int width, int height,
+                                 float depth_scale, nav_msgs::OccupancyGrid &grid) {
+  if (!rays_ || width != rays_->key.width || height != rays_->key.height) {
+    return false;
+  }
+  const RayTable &rays = *rays_;
+  const int grid_width = config_.width;
+  const int grid_height = config_.height;
+  const size_t cell_count = static_cast<size_t>(grid_width) * grid_height;
+  const float unknown = -std::numeric_limits<float>::infinity();
+  const int chunk_count = std::min(pool_->size(), height);
+  chunk_heights_.resize(chunk_count);
+  chunk_updates_.assign(chunk_count, 0);
+
+  const float inv_resolution = static_cast<float>(1.0 / config_.resolution);
+  const float origin_x = static_cast<float>(config_.origin_x);
+  const float origin_y = static_cast<float>(config_.origin_y);
+  const float max_height = static_cast<float>(config_.max_height);
+  // depth units to meters, rejected before projection when out of range
+  const float to_meters = depth_scale * 0.001f;
+  const float max_depth = static_cast<float>(config_.range_max / to_meters);
+  pool_->parallelFor(0, chunk_count, [&](int chunk_begin, int chunk_end) {
+    for (int chunk = chunk_begin; chunk < chunk_end; chunk++) {
+      auto &cells = chunk_heights_[chunk];
+      cells.assign(cell_count, unknown);
+      uint64_t updates = 0;
+      const int row_begin = static_cast<int>(static_cast<int64_t>(height) * chunk / chunk_count);
+      const int row_end =
+          static_cast<int>(static_cast<int64_t>(height) * (chunk + 1) / chunk_count);
+      for (int v = row_begin; v < row_end; v++) {
+        const uint16_t *depth_row = depth_data + static_cast<size_t>(v) * width;
+        const float *row = &rays.row[v * 3];
+        for (int u = 0; u < width; u++) {
+          const float depth = depth_row[u];
+          if (depth == 0 || depth > max_depth) {
+            continue;
+          }
+          const float z = depth * to_meters;
+          const float *column = &rays.column[u * 3];
+          const float px = z * (column[0] + row[0]) + translation_[0];
+          const float py = z * (column[1] + row[1]) + translation_[1];
+          const float pz = z * (column[2] + row[2]) + translation_[2];
+          if (pz > max_height) {
+            continue;
+          }
+          const float cell_x = (px - origin_x) * inv_resolution;
+          const float cell_y = (py - origin_y) * inv_resolution;
+          if (cell_x < 0 || cell_y < 0 || cell_x >= grid_width || cell_y >= grid_height) {
+            continue;
+          }
+          float &cell = cells[static_cast<int>(cell_y) * grid_width + static_cast<int>(cell_x)];
+          cell = std::max(cell, pz);
+          ++updates;
+        }
+      }
+      chunk_updates_[chunk] = updates;
+    }
+  });
+
+  grid.info.resolution = static_cast<float>(config_.resolution);
+  grid.info.width = grid_width;
+  grid.info.height = grid_height;
+  grid.info.origin.position.x = config_.origin_x;
+  grid.info.origin.position.y = config_.origin_y;
+  grid.info.origin.position.z = 0.0;
+  grid.info.origin.orientation.x = 0.0;
+  grid.info.origin.orientation.y = 0.0;
+  grid.info.origin.orientation.z = 0.0;
+  grid.info.origin.orientation.w = 1.0;
+  grid.data.resize(cell_count);
+  const float min_height = static_cast<float>(config_.min_height);
+  const float scale = max_height > min_height ? 100.0f / (max_height - min_height) : 0.0f;
+  pool_->parallelFor(0, grid_height, [&](int row_begin, int row_end) {
+    for (size_t i = static_cast<size_t>(row_begin) * grid_width;
+         i < static_cast<size_t>(row_end) * grid_width; i++) {
+      float cell = unknown;
+      for (const auto &cells : chunk_heights_) {
+        cell = std::max(cell, cells[i]);
+      }
+      if (cell == unknown) {
+        grid.data[i] = -1;
+      } else {
+        const float value = std::min(std::max((cell - min_height) * scale, 0.0f), 100.0f);
+        grid.data[i] = static_cast<int8_t>(std::lround(value));
+      }
+    }
+  });
+  last_cell_updates_ = 0;
+  for (auto updates : chunk_updates_) {
+    last_cell_updates_ += updates;
+  }
+  return true;
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/imu_batcher.h"
+
+#include <algorithm>
+
+namespace orbbec_camera {
+namespace {
+void appendVector(const geometry_msgs::Vector3 &value, std::vector<double> &dest) {
+  dest.push_back(value.x);
+  dest.push_back(value.y);
+  dest.push_back(value.z);
+}
+}  // namespace
+
+ImuBatcher::ImuBatcher(const Config &config, const std::string &frame_id)
+    : config_(config), frame_id_(frame_id) {
+  config_.batch_size = std::max(config_.batch_size, 1);
+  config_.pool_size = std::max(config_.pool_size, 1);
+  for (int i = 0; i < config_.pool_size; i++) {
+    pool_.push_back(createMessage());
+  }
+}
+
+ImuBatchPtr ImuBatcher::createMessage() const {
+  auto msg = boost::make_shared<ImuBatch>();
+  msg->header.frame_id = frame_id_;
+  msg->stamps.reserve(config_.batch_size);
+  msg->angular_velocity.reserve(config_.batch_size * 3);
+  msg->linear_acceleration.reserve(config_.batch_size * 3);
+  return msg;
+}
+
+ImuBatchPtr ImuBatcher::acquire() {
+  // the publisher may still hold a message queued for serialization, only take released ones
+  for (auto &msg : pool_) {
+    if (msg.unique()) {
+      msg->stamps.clear();
+      msg->angular_velocity.clear();
+      msg->linear_acceleration.clear();
+      return msg;
+    }
+  }
+  pool_misses_++;
+  return createMessage();
+}
+
+ImuBatchPtr ImuBatcher::add(const ros::Time &stamp,
+                            const geometry_msgs::Vector3 *angular_velocity,
+                            const geometry_msgs::Vector3 *linear_acceleration) {
+  if (!current_) {
+    current_ = acquire();
+    current_->header.stamp = stamp;
+  }
+  current_->stamps.push_back(stamp);
+  if (angular_velocity) {
+    appendVector(*angular_velocity, current_->angular_velocity);
+  }
+  if (linear_acceleration) {
+    appendVector(*linear_acceleration, current_->linear_acceleration);
+  }
+  const bool full = static_cast<int>(current_->stamps.size()) >= config_.batch_size;
+  const bool window_elapsed =
+      config_.window > 0 && (stamp - current_->header.stamp).toSec() >= config_.window;
+  if (!full && !window_elapsed) {
+    return nullptr;
+  }
+  ImuBatchPtr batch;
+  batch.swap(current_);
+  return batch;
+}
+
+void ImuBatcher::reset() { current_.reset(); }
+}  // namespace orbbec_camera
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/imu_unifier.h"
+
+#include <algorithm>
+
+namespace orbbec_camera {
+ImuUnifier::ImuUnifier(Method method, size_t capacity)
+    : method_(method), accel_ring_(capacity), accel_history_(capacity), pending_(capacity) {}
+
+void ImuUnifier::addAccel(const Sample &accel) {
+  if (!accel_ring_.push(accel)) {
+    // single writer, the plain counter is only read for reporting
+    accel_overflows_++;
+  }
+}
+
+void ImuUnifier::drainAccel(const OutputCallback &output) {
+  Sample accel;
+  while (accel_ring_.pop(accel)) {
+    if (accel_count_ == accel_history_.size()) {
+      // complete what the oldest sample still brackets before it is dropped
+      emitReady(output, false);
+      accel_begin_ = (accel_begin_ + 1) % accel_history_.size();
+      accel_count_--;
+    }
+    accel_history_[(accel_begin_ + accel_count_) % accel_history_.size()] = accel;
+    accel_count_++;
+  }
+}
+
+void ImuUnifier::emitReady(const OutputCallback &output, bool flush) {
+  while (pending_count_ > 0 && accel_count_ > 0) {
+    const Sample &gyro = pending_[pending_begin_];
+    const Sample &newest = accelAt(accel_count_ - 1);
+    double accel[3];
+    if (method_ == Method::LINEAR_INTERPOLATION && !flush) {
+      if (gyro.time > newest.time) {
+        return;  // wait for an accel sample past this gyro sample
+      }
+      size_t after = 0;
+      while (accelAt(after).time < gyro.time) {
+        after++;
+      }
+      if (after == 0) {
+        // older than every accel sample at hand, hold the oldest one
+        std::copy(accelAt(0).value, accelAt(0).value + 3, accel);
+      } else {
+        const Sample &a0 = accelAt(after - 1);
+        const Sample &a1 = accelAt(after);
+        const double ratio = (gyro.time - a0.time) / (a1.time - a0.time);
+        for (int i = 0; i < 3; i++) {
+          accel[i] = a0.value[i] + ratio * (a1.value[i] - a0.value[i]);
+        }
+        // gyro samples come in order, samples before a0 will not be needed again
+        accel_begin_ = (accel_begin_ + after - 1) % accel_history_.size();
+        accel_count_ -= after - 1;
+      }
+    } else {
+      std::copy(newest.value, newest.value + 3, accel);
+    }
+    output(gyro, accel);
+    pending_begin_ = (pending_begin_ + 1) % pending_.size();
+    pending_count_--;
+  }
+}
+
+void ImuUnifier::addGyro(const Sample &gyro, const OutputCallback &output) {
+  if (method_ == Method::NONE) {
+    return;
+  }
+  drainAccel(output);
+  if (accel_count_ == 0) {
+    return;  // nothing to pair with yet
+  }
+  if (pending_count_ == pending_.size()) {
+    // accel has stalled for a whole ring of gyro samples, stop waiting for it
+    emitReady(output, true);
+  }
+  pending_[(pending_begin_ + pending_count_) % pending_.size()] = gyro;
+  pending_count_++;
+  emitReady(output, false);
+}
+
+void ImuUnifier::reset() {
+  accel_ring_.clear();
+  accel_begin_ = 0;
+  accel_count_ = 0;
+  pending_begin_ = 0;
+  pending_count_ = 0;
+}
+
+bool imuUnifierMethodFromString(const std::string &name, ImuUnifier::Method &method) {
+  if (name.empty() || name == "none") {
+    method = ImuUnifier::Method::NONE;
+  } else if (name == "copy") {
+    method = ImuUnifier::Method::COPY;
+  } else if (name == "linear_interpolation") {
+    method = ImuUnifier::Method::LINEAR_INTERPOLATION;
+  } else {
+    return false;
+  }
+  return true;
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,54 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/latency_histogram.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace orbbec_camera {
+LatencyHistogram::LatencyHistogram()
+    : LatencyHistogram(std::vector<double>{100, 200, 500, 1000, 2000, 5000, 10000}) {}
+
+LatencyHistogram::LatencyHistogram(std::vector<double> edges_ms) : edges_ms_(std::move(edges_ms)) {
+  std::sort(edges_ms_.begin(), edges_ms_.end());
+  counts_.assign(edges_ms_.size() + 1, 0);
+}
+
+void LatencyHistogram::record(double ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto bucket = std::lower_bound(edges_ms_.begin(), edges_ms_.end(), ms) - edges_ms_.begin();
+  counts_[bucket]++;
+  min_ms_ = count_ == 0 ? ms : std::min(min_ms_, ms);
+  max_ms_ = count_ == 0 ? ms : std::max(max_ms_, ms);
+  count_++;
+  sum_ms_ += ms;
+  last_ms_ = ms;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Snapshot snapshot;
+  snapshot.edges_ms = edges_ms_;
+  snapshot.counts = counts_;
+  snapshot.count = count_;
+  snapshot.last_ms = last_ms_;
+  snapshot.min_ms = min_ms_;
+  snapshot.max_ms = max_ms_;
+  snapshot.mean_ms = count_ > 0 ? sum_ms_ / static_cast<double>(count_) : 0.0;
+  return snapshot;
+}
+}  // namespace orbbec_camera
@@ -15,12 +15,19 @@
  *******************************************************************************/
 #include "ros/ros.h"
 #include "orbbec_camera/ob_camera_node_driver.h"
+#include "orbbec_camera/ob_multi_camera_driver.h"
 
 int main(int argc, char** argv) {
   ros::init(argc, argv, "orbbec_camera");
   ros::NodeHandle nh;
   ros::NodeHandle nh_private("~");
-  orbbec_camera::OBCameraNodeDriver ob_camera_node_factory(nh, nh_private);
+  std::unique_ptr<orbbec_camera::OBMultiCameraDriver> multi_camera_driver;
+  std::unique_ptr<orbbec_camera::OBCameraNodeDriver> ob_camera_node_factory;
+  if (orbbec_camera::OBMultiCameraDriver::isConfigured(nh_private)) {
+    multi_camera_driver.reset(new orbbec_camera::OBMultiCameraDriver(nh, nh_private));
+  } else {
+    ob_camera_node_factory.reset(new orbbec_camera::OBCameraNodeDriver(nh, nh_private));
+  }
   ros::spin();
   ros::shutdown();
   return 0;
@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include "orbbec_camera/normal_estimator.h"
+
+#include <sensor_msgs/point_cloud2_iterator.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace orbbec_camera {
+NormalEstimator::NormalEstimator(int num_threads)
+    : NormalEstimator(std::make_shared<WorkerPool>(num_threads > 1 ? num_threads - 1 : 0)) {}
+
+NormalEstimator::NormalEstimator(std::shared_ptr<WorkerPool> pool) : pool_(std::move(pool)) {}
+
+void NormalEstimator::setupFields(sensor_msgs::PointCloud2 &msg) {
+  msg.fields.clear();
+  sensor_msgs::addPointField(msg, "x", 1, sensor_msgs::PointField::FLOAT32, 0);
+  sensor_msgs::addPointField(msg, "y", 1, sensor_msgs::PointField::FLOAT32, 4);
+  sensor_msgs::addPointField(msg, "z", 1, sensor_msgs::PointField::FLOAT32, 8);
+  sensor_msgs::addPointField(msg, "normal_x", 1, sensor_msgs::PointField::FLOAT32, 16);
+  sensor_msgs::addPointField(msg, "normal_y", 1, sensor_msgs::PointField::FLOAT32, 20);
+  sensor_msgs::addPointField(msg, "normal_z", 1, sensor_msgs::PointField::FLOAT32, 24);
+  msg.point_step = 32;
+}
+
+bool NormalEstimator::windowMean(int x0, int y0, int x1, int y1, float mean[3]) const {
+  // [x0, x1) x [y0, y1), clipped to the image
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+  x1 = std::min(x1, width_);
+  y1 = std::min(y1, height_);
+  if (x1 <= x0 || y1 <= y0) {
+    return false;
+  }
+  const int stride = width_ + 1;
+  const Sum &a = integral_[y0 * stride + x0];
+  const Sum &b = integral_[y0 * stride + x1];
+  const Sum &c = integral_[y1 * stride + x0];
+  const Sum &d = integral_[y1 * stride + x1];
+  const double count = d.count - b.count - c.count + a.count;
+  // require at least half of the window to be valid
+  if (count * 2 < static_cast<double>((x1 - x0) * (y1 - y0))) {
+    return false;
+  }
+  mean[0] = static_cast<float>((d.x - b.x - c.x + a.x) / count);
+  mean[1] = static_cast<float>((d.y - b.y - c.y + a.y) / count);
+  mean[2] = static_cast<float>((d.z - b.z - c.z + a.z) / count);
+  return true;
+}
+
+void NormalEstimator::compute(const uint8_t *xyz, uint32_t point_step, int width, int height,
+                              sensor_msgs::PointCloud2 &msg) {
+  const int stride = width + 1;
+  // the passes below overwrite every cell except the zero first row and column, so the table
+  // is only reallocated and cleared when the frame geometry changes
+  if (width != width_ || height != height_ || integral_.empty()) {
+    integral_.assign(static_cast<size_t>(stride) * (height + 1), Sum());
+  }
+  width_ = width;
+  height_ = height;
+
+  // row prefix sums, rows are independent
+  pool_->parallelFor(0, height, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      const uint8_t *point = xyz + static_cast<size_t>(y) * width * point_step;
+      Sum *row = &integral_[(y + 1) * stride];
+      for (int x = 0; x < width; x++, point += point_step) {
+        float p[3];
+        std::memcpy(p, point, sizeof(p));
+        row[x + 1] = row[x];
+        if (std::isfinite(p[2])) {
+          row[x + 1].x += p[0];
+          row[x + 1].y += p[1];
+          row[x + 1].z += p[2];
+          row[x + 1].count += 1;
+        }
+      }
+    }
+  });
+  // column prefix sums, split by column ranges so each thread walks contiguous memory
+  pool_->parallelFor(1, stride, [&](int begin, int end) {
+    for (int y = 2; y <= height; y++) {
+      const Sum *prev = &integral_[(y - 1) * stride];
+      Sum *row = &integral_[y * stride];
+      for (int x = begin; x < end; x++) {
+        row[x].x += prev[x].x;
+        row[x].y += prev[x].y;
+        row[x].z += prev[x].z;
+        row[x].count += prev[x].count;
+      }
+    }
+  });
+
+  const int r = std::max(smoothing_size_, 1);
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  pool_->parallelFor(0, height, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      const uint8_t *point = xyz + static_cast<size_t>(y) * width * point_step;
+      uint8_t *out = msg.data.data() + static_cast<size_t>(y) * width * msg.point_step;
+      for (int x = 0; x < width; x++, point += point_step, out += msg.point_step) {
+        float p[3];
+        std::memcpy(p, point, sizeof(p));
+        std::memcpy(out, p, sizeof(p));
+        float normal[3] = {nan, nan, nan};
+        float left[3], right[3], top[3], bottom[3];
+        if (std::isfinite(p[2]) && windowMean(x - r, y - r, x, y + r + 1, left) &&
+            windowMean(x + 1, y - r, x + r + 1, y + r + 1, right) &&
+            windowMean(x - r, y - r, x + r + 1, y, top) &&
+            windowMean(x - r, y + 1, x + r + 1, y + r + 1, bottom)) {
+          const float max_change = max_depth_change_factor_ * p[2];
+          if (std::fabs(right[2] - left[2]) <= max_change &&
+              std::fabs(bottom[2] - top[2]) <= max_change) {
+            const float h[3] = {right[0] - left[0], right[1] - left[1], right[2] - left[2]};
+            const float v[3] = {bottom[0] - top[0], bottom[1] - top[1], bottom[2] - top[2]};
+            float n[3] = {h[1] * v[2] - h[2] * v[1], h[2] * v[0] - h[0] * v[2],
+                          h[0] * v[1] - h[1] * v[0]};
+            const float norm = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (norm > 0) {
+              // orient towards the sensor origin
+              const float d[3] = {p[0] - viewpoint_[0], p[1] - viewpoint_[1],
+                                  p[2] - viewpoint_[2]};
+              const float sign = (n[0] * d[0] + n[1] * d[1] + n[2] * d[2]) > 0 ? -1.f : 1.f;
+              for (int i = 0; i < 3; i++) {
+                normal[i] = sign * n[i] / norm;
+              }
+            }
+          }
+        }
+        std::memcpy(out + 16, normal, sizeof(normal));
+      }
+    }
+  });
+}
+}  // namespace orbbec_camera
@@ -15,6 +15,8 @@
  *******************************************************************************/
 
 #include "orbbec_camera/ob_camera_node.h"
+#include <pthread.h>
+#include <cstring>
 #if defined(USE_RK_HW_DECODER)
 #include "orbbec_camera/rk_mpp_decoder.h"
 #elif defined(USE_NV_HW_DECODER)
@@ -23,11 +25,17 @@
 
 namespace orbbec_camera {
 OBCameraNode::OBCameraNode(ros::NodeHandle& nh, ros::NodeHandle& nh_private,
-                           std::shared_ptr<ob::Device> device)
+                           std::shared_ptr<ob::Device> device,
+                           const CameraNodeOptions& options)
     : nh_(nh),
       nh_private_(nh_private),
       device_(std::move(device)),
-      device_info_(device_->getDeviceInfo()) {
+      device_info_(device_->getDeviceInfo()),
+      device_enumerated_at_(options.enumerated_at),
+      await_first_frame_(options.connect_latency != nullptr),
+      connect_latency_(options.connect_latency),
+      warm_reconnect_(options.warm_reconnect),
+      worker_pool_(options.worker_pool) {
   stream_name_[COLOR] = "color";
   stream_name_[DEPTH] = "depth";
   stream_name_[INFRA0] = "ir";
@@ -41,19 +49,50 @@ void OBCameraNode::init() {
   std::lock_guard<decltype(device_lock_)> lock(device_lock_);
   CHECK_NOTNULL(device_.get());
   is_running_ = true;
+  // the device round trips dominate startup, time them to show what the capability cache saves
+  const auto startup_start = std::chrono::steady_clock::now();
+  auto phase_start = startup_start;
+  auto end_phase = [&phase_start](const char* phase) {
+    auto now = std::chrono::steady_clock::now();
+    ROS_INFO_STREAM("startup phase " << phase << ": "
+                                     << std::chrono::duration<double, std::milli>(now - phase_start)
+                                            .count()
+                                     << " ms");
+    phase_start = now;
+  };
   setupConfig();
   getParameters();
+  setupCapabilityCache();
+  end_phase("parameters");
   setupDevices();
+  end_phase("devices");
   selectBaseStream();
   setupProfiles();
+  end_phase("profiles");
+  setupPointCloudCrop();
+  setupHeightMap();
+  setupProximityMonitor();
   setupCameraInfo();
+  end_phase("camera info");
+  startIMUPublishThread();
   setupTopics();
   setupCameraCtrlServices();
   setupFrameCallback();
+  setupIdlePolicy();
+  end_phase("topics and services");
   readDefaultExposure();
   readDefaultGain();
   readDefaultWhiteBalance();
+  end_phase("default values");
+  if (capability_cache_ && !capability_cache_->save()) {
+    ROS_WARN_STREAM("Failed to write capability cache " << capability_cache_->path());
+  }
   setupFfmpegDecoder();
+  ROS_INFO_STREAM("startup took " << std::chrono::duration<double, std::milli>(
+                                         std::chrono::steady_clock::now() - startup_start)
+                                         .count()
+                                  << " ms"
+                                  << (capability_cache_ ? " with capability cache" : ""));
   is_initialized_ = true;
 #if defined(USE_RK_HW_DECODER)
   mjpeg_decoder_ = std::make_shared<RKMjpegDecoder>(width_[COLOR], height_[COLOR]);
@@ -73,6 +112,160 @@ void OBCameraNode::init() {
 
 bool OBCameraNode::isInitialized() const { return is_initialized_; }
 
+void OBCameraNode::detachDevice() {
+  std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+  if (device_detached_) {
+    return;
+  }
+  ROS_INFO_STREAM("Detaching device, publishers and services stay up");
+  device_detached_ = true;
+  is_initialized_ = false;
+  restart_pipeline_ = pipeline_started_;
+  restart_imu_sync_ = imu_sync_output_start_;
+  restart_streams_.clear();
+  for (const auto& item : stream_started_) {
+    restart_streams_[item.first] = item.second;
+  }
+  for (const auto& item : imu_started_) {
+    restart_streams_[item.first] = item.second;
+  }
+  // the device is gone, stopping may fail half way, the flags are cleared regardless
+  try {
+    stopStreams();
+    stopIMU();
+  } catch (const ob::Error& e) {
+    ROS_WARN_STREAM("Failed to stop the streams of the lost device: " << e.getMessage());
+  } catch (const std::exception& e) {
+    ROS_WARN_STREAM("Failed to stop the streams of the lost device: " << e.what());
+  }
+  pipeline_started_ = false;
+  imu_sync_output_start_ = false;
+  for (auto& item : stream_started_) {
+    item.second = false;
+  }
+  for (auto& item : imu_started_) {
+    item.second = false;
+  }
+  std::lock_guard<std::mutex> imu_lock(imu_publish_mutex_);
+  for (auto& item : imu_rings_) {
+    item.second->clear();
+  }
+  for (auto& item : imu_batchers_) {
+    item.second->reset();
+  }
+  if (imu_gyro_accel_batcher_) {
+    imu_gyro_accel_batcher_->reset();
+  }
+  if (imu_unifier_) {
+    imu_unifier_->reset();
+  }
+}
+
+bool OBCameraNode::attachDevice(const std::shared_ptr<ob::Device>& device,
+                                const std::chrono::steady_clock::time_point& enumerated_at) {
+  std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+  CHECK_NOTNULL(device.get());
+  try {
+    auto device_info = device->getDeviceInfo();
+    if (std::string(device_info->serialNumber()) != device_info_->serialNumber()) {
+      ROS_WARN_STREAM("Device " << device_info->serialNumber() << " can not take over from "
+                                << device_info_->serialNumber());
+      return false;
+    }
+    device_ = device;
+    device_info_ = device_info;
+    sensors_.clear();
+    imu_sensor_.clear();
+    setupDevices();
+    if (!rebindProfiles()) {
+      return false;
+    }
+  } catch (const ob::Error& e) {
+    ROS_ERROR_STREAM("Failed to attach device: " << e.getMessage());
+    return false;
+  } catch (const std::exception& e) {
+    ROS_ERROR_STREAM("Failed to attach device: " << e.what());
+    return false;
+  }
+  device_enumerated_at_ = enumerated_at;
+  reattached_ = true;
+  stream_started_at_ns_ = 0;
+  await_first_frame_ = true;
+  device_detached_ = false;
+  is_initialized_ = true;
+  try {
+    if (enable_pipeline_ && restart_pipeline_) {
+      startStreams();
+    }
+    for (const auto& stream_index : IMAGE_STREAMS) {
+      if (!enable_pipeline_ && restart_streams_[stream_index]) {
+        startStream(stream_index);
+      }
+    }
+    if (enable_sync_output_accel_gyro_) {
+      if (restart_imu_sync_) {
+        startIMU(GYRO);
+      }
+    } else {
+      for (const auto& stream_index : HID_STREAMS) {
+        if (restart_streams_[stream_index]) {
+          startIMU(stream_index);
+        }
+      }
+    }
+  } catch (const ob::Error& e) {
+    ROS_ERROR_STREAM("Failed to restart streams after reconnect: " << e.getMessage());
+  } catch (const std::exception& e) {
+    ROS_ERROR_STREAM("Failed to restart streams after reconnect: " << e.what());
+  }
+  auto attach_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                             enumerated_at)
+                       .count();
+  ROS_INFO_STREAM("Device re-attached " << attach_ms << " ms after re-enumeration");
+  return true;
+}
+
+void OBCameraNode::markStreamStart() {
+  if (!await_first_frame_) {
+    return;
+  }
+  // only the first start counts, frame callbacks of streams started before may be reading it
+  int64_t not_started = 0;
+  stream_started_at_ns_.compare_exchange_strong(
+      not_started, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count());
+}
+
+void OBCameraNode::recordFirstFrame(const stream_index_pair& stream_index) {
+  if (!await_first_frame_ || !await_first_frame_.exchange(false)) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  // covers connection_delay, selection, the readiness probe and the stream setup
+  auto enumerated_ms =
+      std::chrono::duration<double, std::milli>(now - device_enumerated_at_).count();
+  if (reattached_) {
+    reattach_latency_.record(enumerated_ms);
+  } else if (connect_latency_) {
+    connect_latency_->record(enumerated_ms);
+  }
+  // streams start with their first subscriber, the SDK part alone is kept apart
+  const int64_t started_ns = stream_started_at_ns_;
+  if (started_ns == 0) {
+    ROS_INFO_STREAM("First " << stream_name_[stream_index] << " frame " << enumerated_ms
+                             << " ms after device enumeration");
+    return;
+  }
+  auto started_ms = std::chrono::duration<double, std::milli>(
+                        now.time_since_epoch() - std::chrono::nanoseconds(started_ns))
+                        .count();
+  stream_start_latency_.record(started_ms);
+  ROS_INFO_STREAM("First " << stream_name_[stream_index] << " frame " << enumerated_ms
+                           << " ms after device enumeration, " << started_ms
+                           << " ms after stream start");
+}
+
 OBCameraNode::~OBCameraNode() {
   ROS_INFO_STREAM("OBCameraNode::~OBCameraNode() start");
   std::lock_guard<decltype(device_lock_)> lock(device_lock_);
@@ -89,6 +282,10 @@ OBCameraNode::~OBCameraNode() {
   if (diagnostics_thread_ && diagnostics_thread_->joinable()) {
     diagnostics_thread_->join();
   }
+  if (imu_publish_thread_ && imu_publish_thread_->joinable()) {
+    imu_publish_cv_.notify_all();
+    imu_publish_thread_->join();
+  }
 
   ROS_INFO_STREAM("OBCameraNode::~OBCameraNode() stop stream");
   stopStreams();
@@ -124,6 +321,10 @@ void OBCameraNode::getParameters() {
   depth_aligned_frame_id_[DEPTH] = optical_frame_id_[COLOR];
 
   use_hardware_time_ = nh_private_.param<bool>("use_hardware_time", true);
+  enable_capability_cache_ = nh_private_.param<bool>("enable_capability_cache", false);
+  capability_cache_dir_ = nh_private_.param<std::string>("capability_cache_dir", "");
+  enable_clock_sync_ = nh_private_.param<bool>("enable_clock_sync", false);
+  clock_sync_config_.window = nh_private_.param<double>("clock_sync_window", 30.0);
   publish_tf_ = nh_private_.param<bool>("publish_tf", false);
   depth_registration_ = nh_private_.param<bool>("depth_registration", false);
   enable_frame_sync_ = nh_private_.param<bool>("enable_frame_sync", false);
@@ -131,6 +332,13 @@ void OBCameraNode::getParameters() {
   color_info_uri_ = nh_private_.param<std::string>("color_info_uri", "");
   enable_d2c_viewer_ = nh_private_.param<bool>("enable_d2c_viewer", false);
   enable_pipeline_ = nh_private_.param<bool>("enable_pipeline", true);
+  auto idle_policy = nh_private_.param<std::string>("idle_policy", "");
+  // unset keeps what each mode always did: the pipeline keeps streaming, sensors stop at once
+  idle_policy_ = idle_policy.empty()
+                     ? (enable_pipeline_ ? IdlePolicy::KEEP : IdlePolicy::STOP)
+                     : idlePolicyFromString(idle_policy);
+  idle_timeout_ = nh_private_.param<double>("idle_timeout", 0.0);
+  standby_fps_ = nh_private_.param<int>("standby_fps", 5);
   enable_point_cloud_ = nh_private_.param<bool>("enable_point_cloud", true);
   enable_colored_point_cloud_ = nh_private_.param<bool>("enable_colored_point_cloud", false);
   enable_hardware_d2d_ = nh_private_.param<bool>("enable_hardware_d2d", true);
@@ -164,12 +372,126 @@ void OBCameraNode::getParameters() {
   soft_filter_speckle_size_ = nh_private_.param<int>("soft_filter_speckle_size", -1);
   depth_filter_config_ = nh_private_.param<std::string>("depth_filter_config", "");
   ordered_pc_ = nh_private_.param<bool>("ordered_pc", false);
+  auto point_cloud_encoding = nh_private_.param<std::string>("point_cloud_encoding", "float32");
+  point_cloud_encoding_ = pointCloudEncodingFromString(point_cloud_encoding);
+  auto& crop = point_cloud_crop_params_;
+  crop.min_range = nh_private_.param<double>("point_cloud_min_range", 0.02);
+  crop.max_range = nh_private_.param<double>("point_cloud_max_range", 10.0);
+  crop.roi.x = nh_private_.param<int>("point_cloud_roi_x", 0);
+  crop.roi.y = nh_private_.param<int>("point_cloud_roi_y", 0);
+  crop.roi.width = nh_private_.param<int>("point_cloud_roi_width", 0);
+  crop.roi.height = nh_private_.param<int>("point_cloud_roi_height", 0);
+  crop.use_box = nh_private_.param<bool>("enable_point_cloud_crop_box", false);
+  const char* axes[] = {"x", "y", "z"};
+  for (int i = 0; i < 3; i++) {
+    // meters on the parameter server, millimeters inside the generation loop
+    const std::string axis = axes[i];
+    crop.box_min[i] = static_cast<float>(
+        1000.0 * nh_private_.param<double>("point_cloud_crop_box_min_" + axis, 0.0));
+    crop.box_max[i] = static_cast<float>(
+        1000.0 * nh_private_.param<double>("point_cloud_crop_box_max_" + axis, 0.0));
+  }
+  point_cloud_crop_box_frame_ =
+      nh_private_.param<std::string>("point_cloud_crop_box_frame", "optical");
+  point_cloud_frame_id_ = nh_private_.param<std::string>("point_cloud_frame_id", "");
+  if (point_cloud_frame_id_ == "camera_link") {
+    point_cloud_frame_id_ = camera_link_frame_id_;
+  }
+  enable_point_cloud_normals_ = nh_private_.param<bool>("enable_point_cloud_normals", false);
+  enable_point_cloud_intensity_ =
+      nh_private_.param<bool>("enable_point_cloud_intensity", false);
+  if (enable_point_cloud_intensity_ && depth_registration_) {
+    ROS_WARN("Intensity point cloud needs depth in the IR geometry, disabling it because "
+             "depth_registration is enabled");
+    enable_point_cloud_intensity_ = false;
+  }
+  normal_smoothing_size_ = nh_private_.param<int>("normal_smoothing_size", 10);
+  normal_max_depth_change_factor_ =
+      nh_private_.param<double>("normal_max_depth_change_factor", 0.05);
+  if (enable_point_cloud_normals_ &&
+      (!ordered_pc_ || point_cloud_encoding_ != PointCloudEncoding::FLOAT32)) {
+    ROS_WARN("Point cloud normals need ordered_pc and float32 point cloud encoding, disabling");
+    enable_point_cloud_normals_ = false;
+  }
+  enable_plane_segmentation_ = nh_private_.param<bool>("enable_plane_segmentation", false);
+  auto& plane_config = plane_segmentation_config_;
+  plane_config.distance_threshold = nh_private_.param<double>("plane_distance_threshold", 0.02);
+  plane_config.max_iterations = nh_private_.param<int>("plane_max_iterations", 100);
+  plane_config.max_samples = nh_private_.param<int>("plane_max_samples", 2000);
+  plane_config.min_inlier_ratio = nh_private_.param<double>("plane_min_inlier_ratio", 0.2);
+  if (enable_plane_segmentation_ && point_cloud_encoding_ != PointCloudEncoding::FLOAT32) {
+    ROS_WARN("Plane segmentation needs float32 point cloud encoding, disabling");
+    enable_plane_segmentation_ = false;
+  }
+  enable_laser_scan_ = nh_private_.param<bool>("enable_laser_scan", false);
+  DepthToLaserScan::Config scan_config;
+  scan_config.row = nh_private_.param<int>("scan_row", -1);
+  scan_config.band_height = nh_private_.param<int>("scan_height", 1);
+  scan_config.angle_increment = nh_private_.param<double>("scan_angle_increment", 0.0);
+  scan_config.range_min = nh_private_.param<double>("scan_range_min", 0.1);
+  scan_config.range_max = nh_private_.param<double>("scan_range_max", 10.0);
+  laser_scan_projector_.setConfig(scan_config);
+  enable_height_map_ = nh_private_.param<bool>("enable_height_map", false);
+  height_map_frame_id_ =
+      nh_private_.param<std::string>("height_map_frame_id", camera_link_frame_id_);
+  height_map_config_.resolution = nh_private_.param<double>("height_map_resolution", 0.02);
+  height_map_config_.width = nh_private_.param<int>("height_map_width", 100);
+  height_map_config_.height = nh_private_.param<int>("height_map_height", 100);
+  height_map_config_.origin_x = nh_private_.param<double>("height_map_origin_x", 0.0);
+  height_map_config_.origin_y = nh_private_.param<double>("height_map_origin_y", -1.0);
+  height_map_config_.min_height = nh_private_.param<double>("height_map_min_height", 0.0);
+  height_map_config_.max_height = nh_private_.param<double>("height_map_max_height", 1.0);
+  height_map_config_.range_max = nh_private_.param<double>("height_map_range_max", 4.0);
+  tf2::Quaternion ground_rotation;
+  ground_rotation.setRPY(nh_private_.param<double>("height_map_ground_roll", 0.0),
+                         nh_private_.param<double>("height_map_ground_pitch", 0.0),
+                         nh_private_.param<double>("height_map_ground_yaw", 0.0));
+  tf2::Vector3 ground_translation(nh_private_.param<double>("height_map_ground_x", 0.0),
+                                  nh_private_.param<double>("height_map_ground_y", 0.0),
+                                  nh_private_.param<double>("height_map_ground_z", 0.0));
+  height_map_ground_transform_ = tf2::Transform(ground_rotation, ground_translation);
+  enable_depth_stats_ = nh_private_.param<bool>("enable_depth_stats", false);
+  DepthStatistics::Config depth_stats_config;
+  depth_stats_config.bin_width = nh_private_.param<double>("depth_stats_bin_width", 0.1);
+  depth_stats_config.max_range = nh_private_.param<double>("depth_stats_max_range", 10.0);
+  depth_statistics_.setConfig(depth_stats_config);
+  enable_proximity_ = nh_private_.param<bool>("enable_proximity", false);
+  proximity_regions_ = nh_private_.param<std::string>("proximity_regions", "");
+  proximity_frame_ = nh_private_.param<std::string>("proximity_frame", "camera_link");
+  worker_threads_ = nh_private_.param<int>("worker_threads", THREAD_NUM);
+  // one pool for the whole post processing, the hosting driver may pass the one of all cameras
+  if (!worker_pool_ &&
+      (enable_point_cloud_normals_ || enable_plane_segmentation_ || enable_height_map_)) {
+    worker_pool_ = std::make_shared<WorkerPool>(worker_threads_ > 1 ? worker_threads_ - 1 : 0);
+  }
+  if (enable_point_cloud_normals_) {
+    normal_estimator_ = std::make_shared<NormalEstimator>(worker_pool_);
+    normal_estimator_->setSmoothingSize(normal_smoothing_size_);
+    normal_estimator_->setMaxDepthChangeFactor(
+        static_cast<float>(normal_max_depth_change_factor_));
+  }
+  if (enable_plane_segmentation_) {
+    plane_segmenter_ = std::make_shared<PlaneSegmenter>(worker_pool_);
+    plane_segmenter_->setConfig(plane_segmentation_config_);
+  }
   max_save_images_count_ = nh_private_.param<int>("max_save_images_count", 10);
+  auto point_cloud_save_format = nh_private_.param<std::string>("point_cloud_save_format", "ply");
+  auto save_format = pointCloudFileFormatFromString(point_cloud_save_format);
+  depth_cloud_exporter_ = PointCloudExporter(save_format);
+  colored_cloud_exporter_ = PointCloudExporter(save_format);
+  point_cloud_save_count_ = std::max(nh_private_.param<int>("point_cloud_save_count", 1), 1);
   if (!depth_filter_config_.empty()) {
     enable_depth_filter_ = true;
   }
 
   enable_sync_output_accel_gyro_ = nh_private_.param<bool>("enable_sync_output_accel_gyro", false);
+  unite_imu_method_str_ = nh_private_.param<std::string>("unite_imu_method", "none");
+  enable_imu_batch_ = nh_private_.param<bool>("enable_imu_batch", false);
+  enable_imu_publish_thread_ = nh_private_.param<bool>("imu_publish_thread", false);
+  imu_publish_thread_priority_ = nh_private_.param<int>("imu_publish_thread_priority", 0);
+  imu_ring_capacity_ = std::max(nh_private_.param<int>("imu_ring_capacity", 256), 2);
+  imu_batch_config_.batch_size = nh_private_.param<int>("imu_batch_size", 10);
+  imu_batch_config_.window = nh_private_.param<double>("imu_batch_window", 0.0);
   for (const auto& stream_index : HID_STREAMS) {
     std::string param_name = "enable_" + stream_name_[stream_index];
     enable_stream_[stream_index] = nh_private_.param<bool>(param_name, false);
@@ -224,10 +546,22 @@ void OBCameraNode::getParameters() {
   enable_depth_scale_ = nh_private_.param<bool>("enable_depth_scale", true);
   retry_on_usb3_detection_failure_ =
       nh_private_.param<bool>("retry_on_usb3_detection_failure", false);
+  bandwidth_budget_ = nh_private_.param<double>("bandwidth_budget", 0.0);
+  bandwidth_share_ = nh_private_.param<double>("bandwidth_share", 1.0);
+  if (bandwidth_share_ <= 0.0 || bandwidth_share_ > 1.0) {
+    ROS_WARN_STREAM("bandwidth_share " << bandwidth_share_ << " is outside (0, 1], using 1");
+    bandwidth_share_ = 1.0;
+  }
   auto device_info = device_->getDeviceInfo();
   CHECK_NOTNULL(device_info);
   if (isOpenNIDevice(device_info->pid())) {
     use_hardware_time_ = false;
+    enable_clock_sync_ = false;
+  }
+  // proximity latency is taken from the mapped device stamp, so the estimator also runs when the
+  // stamps themselves stay on host time
+  if (enable_clock_sync_ || (enable_proximity_ && !isOpenNIDevice(device_info->pid()))) {
+    clock_offset_estimator_ = std::make_shared<ClockOffsetEstimator>(clock_sync_config_);
   }
 }
 
@@ -242,20 +576,17 @@ void OBCameraNode::startStreams() {
       pipeline_->disableFrameSync();
     }
     try {
-      setupPipelineConfig();
-      pipeline_->start(pipeline_config_, [this](const std::shared_ptr<ob::FrameSet>& frame_set) {
-        CHECK_NOTNULL(frame_set.get());
-        this->onNewFrameSetCallback(frame_set);
-      });
+      // built once, resuming after idle reuses it
+      if (!pipeline_config_) {
+        setupPipelineConfig();
+      }
+      startPipeline(pipeline_config_);
     } catch (const ob::Error& e) {
       ROS_ERROR_STREAM("failed to start pipeline: " << e.getMessage()
                                                     << " try to disable ir stream try again");
       enable_stream_[INFRA0] = false;
       setupPipelineConfig();
-      pipeline_->start(pipeline_config_, [this](const std::shared_ptr<ob::FrameSet>& frame_set) {
-        CHECK_NOTNULL(frame_set.get());
-        this->onNewFrameSetCallback(frame_set);
-      });
+      startPipeline(pipeline_config_);
     } catch (...) {
       ROS_ERROR_STREAM("failed to start pipeline");
       throw;
@@ -266,6 +597,7 @@ void OBCameraNode::startStreams() {
       colorFrameThread_ = std::make_shared<std::thread>([this]() { onNewColorFrameCallback(); });
     }
     pipeline_started_ = true;
+    pipeline_standby_ = false;
   } else {
     for (const auto& stream_index : IMAGE_STREAMS) {
       if (enable_stream_[stream_index] && !stream_started_[stream_index]) {
@@ -275,6 +607,14 @@ void OBCameraNode::startStreams() {
   }
 }
 
+void OBCameraNode::startPipeline(const std::shared_ptr<ob::Config>& config) {
+  markStreamStart();
+  pipeline_->start(config, [this](const std::shared_ptr<ob::FrameSet>& frame_set) {
+    CHECK_NOTNULL(frame_set.get());
+    this->onNewFrameSetCallback(frame_set);
+  });
+}
+
 void OBCameraNode::startIMUSyncStream() {
   if (!imuPipeline_) {
     ROS_INFO_STREAM("start IMU sync stream failed, IMU pileline is not initialized!");
@@ -299,7 +639,10 @@ void OBCameraNode::startIMUSyncStream() {
   std::shared_ptr<ob::Config> imuConfig = std::make_shared<ob::Config>();
   imuConfig->enableStream(accelProfile);
   imuConfig->enableStream(gyroProfile);
+  updateIMUInfo(ACCEL);
+  updateIMUInfo(GYRO);
   imuPipeline_->enableFrameSync();
+  markStreamStart();
   imuPipeline_->start(imuConfig, [&](std::shared_ptr<ob::Frame> frame) {
     auto frameSet = frame->as<ob::FrameSet>();
     auto aFrame = frameSet->getFrame(OB_FRAME_ACCEL);
@@ -338,6 +681,7 @@ void OBCameraNode::startAccel() {
     auto accel_rate = sampleRateFromString(imu_rate_[stream_index]);
     auto accel_range = fullAccelScaleRangeFromString(imu_range_[stream_index]);
     if (profile->fullScaleRange() == accel_range && profile->sampleRate() == accel_rate) {
+      markStreamStart();
       imu_sensor_[stream_index]->start(
           profile, [this, stream_index](const std::shared_ptr<ob::Frame>& frame) {
             onNewIMUFrameCallback(frame, stream_index);
@@ -370,6 +714,7 @@ void OBCameraNode::startGyro() {
     auto gyro_rate = sampleRateFromString(imu_rate_[stream_index]);
     auto gyro_range = fullGyroScaleRangeFromString(imu_range_[stream_index]);
     if (profile->fullScaleRange() == gyro_range && profile->sampleRate() == gyro_rate) {
+      markStreamStart();
       imu_sensor_[stream_index]->start(
           profile, [this, stream_index](const std::shared_ptr<ob::Frame>& frame) {
             onNewIMUFrameCallback(frame, stream_index);
@@ -396,6 +741,8 @@ void OBCameraNode::startIMU(const stream_index_pair& stream_index) {
       return;
     }
     auto profile = stream_profile_[stream_index];
+    updateIMUInfo(stream_index);
+    markStreamStart();
     imu_sensor_[stream_index]->start(profile,
                                      [this, stream_index](const std::shared_ptr<ob::Frame>& frame) {
                                        onNewIMUFrameCallback(frame, stream_index);
@@ -416,6 +763,7 @@ void OBCameraNode::stopStreams() {
       ROS_ERROR_STREAM("Failed to stop pipeline: " << e.getMessage());
     }
     pipeline_started_ = false;
+    pipeline_standby_ = false;
   } else {
     for (const auto& stream_index : IMAGE_STREAMS) {
       if (stream_started_[stream_index]) {
@@ -431,6 +779,18 @@ void OBCameraNode::stopIMU(const orbbec_camera::stream_index_pair& stream_index)
     ROS_INFO_STREAM("stop " << stream_name_[stream_index] << " stream");
     imu_sensor_[stream_index]->stop();
     imu_started_[stream_index] = false;
+    // the publisher thread drains the rings under this lock, holding it makes us the consumer
+    std::lock_guard<std::mutex> lock(imu_publish_mutex_);
+    if (imu_rings_.count(stream_index)) {
+      imu_rings_[stream_index]->clear();
+    }
+    if (imu_batchers_.count(stream_index)) {
+      imu_batchers_[stream_index]->reset();
+    }
+    // the unifier state belongs to the gyro callback or the publisher thread, both quiet now
+    if (stream_index == GYRO && imu_unifier_) {
+      imu_unifier_->reset();
+    }
   }
 }
 
@@ -444,6 +804,13 @@ void OBCameraNode::stopIMU() {
     } catch (const ob::Error& e) {
       ROS_ERROR_STREAM("Failed to stop imu pipeline: " << e.getMessage());
     }
+    std::lock_guard<std::mutex> lock(imu_publish_mutex_);
+    if (imu_rings_.count(GYRO)) {
+      imu_rings_[GYRO]->clear();
+    }
+    if (imu_gyro_accel_batcher_) {
+      imu_gyro_accel_batcher_->reset();
+    }
   } else {
     for (const auto& stream_index : HID_STREAMS) {
       if (imu_started_[stream_index]) {
@@ -479,6 +846,7 @@ void OBCameraNode::startStream(const stream_index_pair& stream_index) {
   auto callback = frame_callback_[stream_index];
   auto profile = stream_profile_[stream_index];
   try {
+    markStreamStart();
     sensors_[stream_index]->startStream(profile, callback);
     stream_started_[stream_index] = true;
 
@@ -505,6 +873,7 @@ void OBCameraNode::stopStream(const stream_index_pair& stream_index) {
   ROS_INFO_STREAM("Stopping stream " << stream_name_[stream_index] << "...");
   sensors_[stream_index]->stopStream();
   stream_started_[stream_index] = false;
+  stream_standby_[stream_index] = false;
   ROS_INFO_STREAM("Stream " << stream_name_[stream_index] << " stopped.");
 }
 
@@ -518,6 +887,7 @@ void OBCameraNode::publishPointCloud(const std::shared_ptr<ob::FrameSet>& frame_
 
     if (depth_frame_) {
       publishDepthPointCloud(frame_set);
+      publishIntensityPointCloud(frame_set);
     }
   } catch (const ob::Error& e) {
     ROS_ERROR_STREAM(e.getMessage());
@@ -528,8 +898,163 @@ void OBCameraNode::publishPointCloud(const std::shared_ptr<ob::FrameSet>& frame_
   }
 }
 
+template <typename Layout, typename AttributeSource>
+size_t OBCameraNode::fillPointCloud(const uint16_t* depth_data, int width, const cv::Rect& roi,
+                                    const PointCloudRayTable& table, float depth_scale,
+                                    const AttributeSource& attributes) {
+  const bool keep_invalid = ordered_pc_;
+  const uint32_t point_step = cloud_msg_.point_step;
+  const uint32_t attribute_offset = Layout::attributeOffset();
+  const auto& crop = table.crop;
+  // range gate in raw depth units, so rejected pixels are never projected
+  const float min_depth = static_cast<float>(crop.min_range * 1000.0 / depth_scale);
+  const float max_depth = static_cast<float>(crop.max_range * 1000.0 / depth_scale);
+  const float* trans = table.trans;
+  uint8_t* point = cloud_msg_.data.data();
+  size_t point_count = 0;
+  for (int y = roi.y; y < roi.y + roi.height; y++) {
+    const uint16_t* depth_row = depth_data + y * width;
+    const float* row = &table.rays->row[y * 3];
+    for (int x = roi.x; x < roi.x + roi.width; x++) {
+      const float depth = depth_row[x];
+      bool valid = depth >= min_depth && depth <= max_depth;
+      float px = 0, py = 0, pz = 0;
+      if (valid) {
+        const float zf = depth * depth_scale;
+        const float* column = &table.rays->column[x * 3];
+        px = zf * (column[0] + row[0]) + trans[0];
+        py = zf * (column[1] + row[1]) + trans[1];
+        pz = zf * (column[2] + row[2]) + trans[2];
+        valid = !crop.use_box || crop.inBox(px, py, pz);
+      }
+      if (!valid && !keep_invalid) {
+        continue;
+      }
+      if (valid) {
+        Layout::setXYZ(point, px, py, pz);
+      } else {
+        Layout::setInvalid(point);
+      }
+      attributes.template write<Layout>(point + attribute_offset,
+                                        static_cast<size_t>(y) * width + x);
+      point += point_step;
+      ++point_count;
+    }
+  }
+  return point_count;
+}
+
+template <typename AttributeSource>
+void OBCameraNode::generatePointCloud(const uint16_t* depth_data, int width, int height,
+                                      const PointCloudRayTable& table, float depth_scale,
+                                      PointAttribute attribute,
+                                      const AttributeSource& attributes) {
+  const bool compact = point_cloud_encoding_ == PointCloudEncoding::COMPACT;
+  if (compact) {
+    CompactPointLayout::setupFields(cloud_msg_, attribute);
+  } else {
+    Float32PointLayout::setupFields(cloud_msg_, attribute);
+  }
+  cv::Rect roi(0, 0, width, height);
+  if (!table.crop.roi.empty()) {
+    roi &= table.crop.roi;
+  }
+  cloud_msg_.width = roi.width;
+  cloud_msg_.height = roi.height;
+  cloud_msg_.row_step = cloud_msg_.width * cloud_msg_.point_step;
+  cloud_msg_.data.resize(cloud_msg_.height * cloud_msg_.row_step);
+  size_t valid_count =
+      compact ? fillPointCloud<CompactPointLayout>(depth_data, width, roi, table, depth_scale,
+                                                   attributes)
+              : fillPointCloud<Float32PointLayout>(depth_data, width, roi, table, depth_scale,
+                                                   attributes);
+  cloud_msg_.is_dense = !ordered_pc_;
+  if (!ordered_pc_) {
+    cloud_msg_.width = valid_count;
+    cloud_msg_.height = 1;
+    cloud_msg_.row_step = cloud_msg_.width * cloud_msg_.point_step;
+    cloud_msg_.data.resize(cloud_msg_.row_step);
+  }
+}
+
+bool OBCameraNode::getPointCloudTransform(const stream_index_pair& stream_index,
+                                          tf2::Transform& cloud_from_optical) {
+  if (point_cloud_frame_id_.empty() || point_cloud_frame_id_ == optical_frame_id_[stream_index]) {
+    cloud_from_optical = tf2::Transform::getIdentity();
+    return true;
+  }
+  if (point_cloud_frame_id_ == camera_link_frame_id_) {
+    cloud_from_optical = getOpticalToCameraLinkTransform(stream_index);
+    return true;
+  }
+  if (!tf_buffer_) {
+    return false;
+  }
+  // the target has to be static, it is looked up once and baked into the ray table
+  try {
+    auto msg = tf_buffer_->lookupTransform(point_cloud_frame_id_, optical_frame_id_[stream_index],
+                                           ros::Time(0));
+    const auto& t = msg.transform;
+    cloud_from_optical.setOrigin(tf2::Vector3(t.translation.x, t.translation.y, t.translation.z));
+    cloud_from_optical.setRotation(
+        tf2::Quaternion(t.rotation.x, t.rotation.y, t.rotation.z, t.rotation.w));
+    return true;
+  } catch (const tf2::TransformException& e) {
+    ROS_WARN_STREAM_THROTTLE(5, "Point cloud frame " << point_cloud_frame_id_
+                                                     << " not available yet: " << e.what());
+    return false;
+  }
+}
+
+const OBCameraNode::PointCloudRayTable& OBCameraNode::getPointCloudRayTable(
+    const stream_index_pair& stream_index, const OBCameraIntrinsic& intrinsic, int width,
+    int height) {
+  auto& table = point_cloud_ray_tables_[stream_index];
+  if (table.valid && table.rays &&
+      table.rays->key == RayTable::makeKey(intrinsic, width, height, table.rotation)) {
+    return table;
+  }
+  tf2::Transform cloud_from_optical;
+  table.valid = getPointCloudTransform(stream_index, cloud_from_optical);
+  if (!table.valid) {
+    // publish in the optical frame until the target frame shows up
+    cloud_from_optical = tf2::Transform::getIdentity();
+  }
+  table.frame_id = table.valid && !point_cloud_frame_id_.empty() ? point_cloud_frame_id_
+                                                                 : optical_frame_id_[stream_index];
+  const auto& basis = cloud_from_optical.getBasis();
+  const auto& origin = cloud_from_optical.getOrigin();
+  table.rotation = basis;
+  table.rays = ray_table_cache_.get(RayTable::makeKey(intrinsic, width, height, basis));
+  for (int i = 0; i < 3; i++) {
+    table.trans[i] = static_cast<float>(origin[i] * 1000.0);
+  }
+  // the crop box maps optical points into the box frame, re-express it for output points:
+  // box_from_cloud = box_from_optical * cloud_from_optical^-1
+  table.crop = point_cloud_crop_[stream_index];
+  if (table.crop.use_box) {
+    const auto& box = point_cloud_crop_[stream_index];
+    tf2::Matrix3x3 box_rot(box.box_rot[0], box.box_rot[1], box.box_rot[2], box.box_rot[3],
+                           box.box_rot[4], box.box_rot[5], box.box_rot[6], box.box_rot[7],
+                           box.box_rot[8]);
+    tf2::Vector3 box_trans(box.box_trans[0], box.box_trans[1], box.box_trans[2]);
+    tf2::Matrix3x3 rot = box_rot * basis.transpose();
+    tf2::Vector3 trans = box_trans - rot * (origin * 1000.0);
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        table.crop.box_rot[i * 3 + j] = static_cast<float>(rot[i][j]);
+      }
+      table.crop.box_trans[i] = static_cast<float>(trans[i]);
+    }
+  }
+  return table;
+}
+
 void OBCameraNode::publishDepthPointCloud(const std::shared_ptr<ob::FrameSet>& frame_set) {
-  if (!enable_point_cloud_ || depth_cloud_pub_.getNumSubscribers() == 0) {
+  if (!enable_point_cloud_ || (depth_cloud_pub_.getNumSubscribers() == 0 &&
+                               depth_normals_pub_.getNumSubscribers() == 0 &&
+                               floor_plane_pub_.getNumSubscribers() == 0 &&
+                               ground_removed_cloud_pub_.getNumSubscribers() == 0)) {
     return;
   }
   auto depth_frame = frame_set->depthFrame();
@@ -543,79 +1068,176 @@ void OBCameraNode::publishDepthPointCloud(const std::shared_ptr<ob::FrameSet>& f
   auto depth_profile = stream_profile_[DEPTH]->as<ob::VideoStreamProfile>();
   CHECK_NOTNULL(depth_profile.get());
   auto depth_intrinsics = depth_profile->getIntrinsic();
-  float fdx = depth_intrinsics.fx * ((float)(width) / static_cast<float>(depth_intrinsics.width));
-  float fdy = depth_intrinsics.fy * ((float)(height) / static_cast<float>(depth_intrinsics.height));
-  fdx = 1 / fdx;
-  fdy = 1 / fdy;
-  float u0 = depth_intrinsics.cx * ((float)(width) / static_cast<float>(depth_intrinsics.width));
-  float v0 = depth_intrinsics.cy * ((float)(height) / static_cast<float>(depth_intrinsics.height));
 
   const auto* depth_data = (uint16_t*)depth_frame->data();
-  sensor_msgs::PointCloud2Modifier modifier(cloud_msg_);
-  modifier.setPointCloud2FieldsByString(1, "xyz");
-  modifier.resize(width * height);
-  cloud_msg_.width = depth_frame->width();
-  cloud_msg_.height = depth_frame->height();
-  cloud_msg_.row_step = cloud_msg_.width * cloud_msg_.point_step;
-  cloud_msg_.data.resize(cloud_msg_.height * cloud_msg_.row_step);
-  sensor_msgs::PointCloud2Iterator<float> iter_x(cloud_msg_, "x");
-  sensor_msgs::PointCloud2Iterator<float> iter_y(cloud_msg_, "y");
-  sensor_msgs::PointCloud2Iterator<float> iter_z(cloud_msg_, "z");
-  size_t valid_count = 0;
-  const static double MIN_DISTANCE = 20.0;
-  const static double MAX_DISTANCE = 10000.0;
-  double depth_scale = depth_frame->getValueScale();
-  const static double min_depth = MIN_DISTANCE / depth_scale;
-  const static double max_depth = MAX_DISTANCE / depth_scale;
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      bool valid_point = true;
-      if (depth_data[y * width + x] < min_depth || depth_data[y * width + x] > max_depth) {
-        valid_point = false;
-      }
-      if (valid_point || ordered_pc_) {
-        float xf = (x - u0) * fdx;
-        float yf = (y - v0) * fdy;
-        float zf = depth_data[y * width + x] * depth_scale;
-        *iter_x = zf * xf / 1000.0;
-        *iter_y = zf * yf / 1000.0;
-        *iter_z = zf / 1000.0;
-        ++iter_x, ++iter_y, ++iter_z;
-        valid_count++;
-      }
-    }
-  }
-  if (!ordered_pc_) {
-    cloud_msg_.is_dense = true;
-    cloud_msg_.width = valid_count;
-    cloud_msg_.height = 1;
-    modifier.resize(valid_count);
-  }
-  auto timestamp = use_hardware_time_ ? fromUsToROSTime(depth_frame->timeStampUs())
-                                      : fromUsToROSTime(depth_frame->systemTimeStampUs());
-  std::string frame_id = depth_registration_ ? optical_frame_id_[COLOR] : optical_frame_id_[DEPTH];
+  const auto& cloud_stream = depth_registration_ ? COLOR : DEPTH;
+  const auto& table = getPointCloudRayTable(cloud_stream, depth_intrinsics, width, height);
+  generatePointCloud(depth_data, width, height, table, depth_frame->getValueScale(),
+                     PointAttribute::NONE, NoAttributeSource());
+  auto timestamp = frameTimeStamp(depth_frame);
+  std::string frame_id = table.frame_id;
   cloud_msg_.header.stamp = timestamp;
   cloud_msg_.header.frame_id = frame_id;
-  depth_cloud_pub_.publish(cloud_msg_);
-  if (save_point_cloud_) {
-    save_point_cloud_ = false;
-    auto now = std::time(nullptr);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&now), "%Y%m%d_%H%M%S");
-    auto current_path = boost::filesystem::current_path().string();
-    std::string filename = current_path + "/point_cloud/points_" + ss.str() + ".ply";
-    if (!boost::filesystem::exists(current_path + "/point_cloud")) {
-      boost::filesystem::create_directory(current_path + "/point_cloud");
-    }
-    ROS_INFO_STREAM("Saving point cloud to " << filename);
-    try {
-      saveDepthPointCloudMsgToPly(cloud_msg_, filename);
-    } catch (const std::exception& e) {
-      ROS_ERROR_STREAM("Failed to save point cloud: " << e.what());
-    } catch (...) {
-      ROS_ERROR_STREAM("Failed to save point cloud");
-    }
+  if (normal_estimator_ && depth_normals_pub_.getNumSubscribers() > 0) {
+    publishPointCloudNormals(timestamp, frame_id);
+  }
+  if (plane_segmenter_ && (floor_plane_pub_.getNumSubscribers() > 0 ||
+                           ground_removed_cloud_pub_.getNumSubscribers() > 0)) {
+    publishPlaneSegmentation(timestamp, frame_id);
+  }
+  if (depth_cloud_pub_.getNumSubscribers() > 0) {
+    depth_cloud_pub_.publish(cloud_msg_);
+  }
+  if (save_point_cloud_ > 0) {
+    savePointCloudMsg("points", depth_cloud_exporter_, save_point_cloud_);
+  }
+}
+
+void OBCameraNode::publishIntensityPointCloud(const std::shared_ptr<ob::FrameSet>& frame_set) {
+  if (!enable_point_cloud_intensity_ || intensity_cloud_pub_.getNumSubscribers() == 0) {
+    return;
+  }
+  auto depth_frame = frame_set->depthFrame();
+  if (!depth_frame) {
+    return;
+  }
+  // left IR on stereo devices, IR otherwise; both share the depth camera's geometry
+  std::shared_ptr<ob::Frame> ir_frame = frame_set->getFrame(OB_FRAME_IR_LEFT);
+  if (!ir_frame) {
+    ir_frame = frame_set->getFrame(OB_FRAME_IR);
+  }
+  if (!ir_frame) {
+    ROS_WARN_THROTTLE(5, "No IR frame in the frame set, cannot publish intensity point cloud");
+    return;
+  }
+  size_t ir_bytes_per_pixel = 0;
+  auto decoded_ir_frame = decodeIRMJPGFrame(ir_frame);
+  if (decoded_ir_frame) {
+    // decoded to 8 bit gray, the frame keeps the MJPG format
+    ir_frame = decoded_ir_frame;
+  }
+  switch (decoded_ir_frame ? OB_FORMAT_Y8 : ir_frame->format()) {
+    case OB_FORMAT_Y8:
+      ir_bytes_per_pixel = 1;
+      break;
+    case OB_FORMAT_Y16:
+    case OB_FORMAT_Y10:
+    case OB_FORMAT_Y11:
+    case OB_FORMAT_Y12:
+    case OB_FORMAT_Y14:
+      // the SDK unpacks these into one uint16_t per pixel, checked against the size below
+      ir_bytes_per_pixel = 2;
+      break;
+    default:
+      ROS_ERROR_STREAM_THROTTLE(5, "Unsupported IR format "
+                                       << ir_frame->format()
+                                       << " for the intensity point cloud, expected Y8, Y10, "
+                                          "Y11, Y12, Y14, Y16 or MJPG");
+      return;
+  }
+  auto ir_video_frame = ir_frame->as<ob::VideoFrame>();
+  int width = static_cast<int>(depth_frame->width());
+  int height = static_cast<int>(depth_frame->height());
+  if (!ir_video_frame || static_cast<int>(ir_video_frame->width()) != width ||
+      static_cast<int>(ir_video_frame->height()) != height) {
+    ROS_WARN_THROTTLE(5, "IR and depth frame size mismatch, cannot publish intensity point cloud");
+    return;
+  }
+  if (ir_frame->dataSize() < static_cast<size_t>(width) * height * ir_bytes_per_pixel) {
+    ROS_ERROR_STREAM_THROTTLE(5, "IR frame of format " << ir_frame->format() << " holds "
+                                                       << ir_frame->dataSize()
+                                                       << " bytes, too few for " << width << "x"
+                                                       << height << ", still packed?");
+    return;
   }
+  const bool ir_is_8bit = ir_bytes_per_pixel == 1;
+  std::lock_guard<decltype(cloud_mutex_)> cloud_lock(cloud_mutex_);
+  auto depth_profile = stream_profile_[DEPTH]->as<ob::VideoStreamProfile>();
+  CHECK_NOTNULL(depth_profile.get());
+  auto intrinsics = depth_profile->getIntrinsic();
+  const auto* depth_data = (uint16_t*)depth_frame->data();
+  const auto& table = getPointCloudRayTable(DEPTH, intrinsics, width, height);
+  if (ir_is_8bit) {
+    IntensityAttributeSource<uint8_t> intensities;
+    intensities.ir = static_cast<const uint8_t*>(ir_frame->data());
+    generatePointCloud(depth_data, width, height, table, depth_frame->getValueScale(),
+                       PointAttribute::INTENSITY, intensities);
+  } else {
+    IntensityAttributeSource<uint16_t> intensities;
+    intensities.ir = static_cast<const uint16_t*>(ir_frame->data());
+    generatePointCloud(depth_data, width, height, table, depth_frame->getValueScale(),
+                       PointAttribute::INTENSITY, intensities);
+  }
+  cloud_msg_.header.stamp = frameTimeStamp(depth_frame);
+  cloud_msg_.header.frame_id = table.frame_id;
+  intensity_cloud_pub_.publish(cloud_msg_);
+}
+
+void OBCameraNode::publishPointCloudNormals(const ros::Time& timestamp,
+                                            const std::string& frame_id) {
+  // cloud_msg_ holds the organized float32 depth cloud, normals are computed in one more pass
+  // over it instead of projecting the depth frame again.
+  NormalEstimator::setupFields(normals_msg_);
+  normals_msg_.width = cloud_msg_.width;
+  normals_msg_.height = cloud_msg_.height;
+  normals_msg_.is_dense = false;
+  normals_msg_.is_bigendian = false;
+  normals_msg_.row_step = normals_msg_.width * normals_msg_.point_step;
+  normals_msg_.data.resize(normals_msg_.height * normals_msg_.row_step);
+  // the sensor sits at the ray table's translation when clouds are baked into another frame
+  const auto& table = point_cloud_ray_tables_[depth_registration_ ? COLOR : DEPTH];
+  normal_estimator_->setViewpoint(table.trans[0] * 0.001f, table.trans[1] * 0.001f,
+                                  table.trans[2] * 0.001f);
+  normal_estimator_->compute(cloud_msg_.data.data(), cloud_msg_.point_step, cloud_msg_.width,
+                             cloud_msg_.height, normals_msg_);
+  normals_msg_.header.stamp = timestamp;
+  normals_msg_.header.frame_id = frame_id;
+  depth_normals_pub_.publish(normals_msg_);
+}
+
+void OBCameraNode::publishPlaneSegmentation(const ros::Time& timestamp,
+                                            const std::string& frame_id) {
+  // like the normals, this works on the xyz already in cloud_msg_: one RANSAC fit on a
+  // subsample and one classification pass over the cloud
+  const auto& table = point_cloud_ray_tables_[depth_registration_ ? COLOR : DEPTH];
+  plane_segmenter_->setViewpoint(table.trans[0] * 0.001f, table.trans[1] * 0.001f,
+                                 table.trans[2] * 0.001f);
+  const size_t count = static_cast<size_t>(cloud_msg_.width) * cloud_msg_.height;
+  bool valid = plane_segmenter_->fit(cloud_msg_.data.data(), cloud_msg_.point_step, count);
+  if (floor_plane_pub_.getNumSubscribers() > 0) {
+    floor_plane_msg_.header.stamp = timestamp;
+    floor_plane_msg_.header.frame_id = frame_id;
+    floor_plane_msg_.valid = valid;
+    for (int i = 0; i < 4; i++) {
+      floor_plane_msg_.coefficients[i] = valid ? plane_segmenter_->plane()[i] : 0.0f;
+    }
+    floor_plane_msg_.inlier_ratio = plane_segmenter_->inlierRatio();
+    floor_plane_pub_.publish(floor_plane_msg_);
+  }
+  if (ground_removed_cloud_pub_.getNumSubscribers() == 0) {
+    return;
+  }
+  if (!valid) {
+    // nothing to remove, the cloud goes out as it is
+    ground_removed_cloud_pub_.publish(cloud_msg_);
+    return;
+  }
+  bool keep_organized = cloud_msg_.height > 1;
+  ground_removed_msg_.fields = cloud_msg_.fields;
+  ground_removed_msg_.point_step = cloud_msg_.point_step;
+  ground_removed_msg_.is_bigendian = cloud_msg_.is_bigendian;
+  ground_removed_msg_.data.resize(cloud_msg_.data.size());
+  size_t kept = plane_segmenter_->removePlane(cloud_msg_.data.data(), cloud_msg_.point_step,
+                                              count, keep_organized,
+                                              ground_removed_msg_.data.data());
+  ground_removed_msg_.width = keep_organized ? cloud_msg_.width : static_cast<uint32_t>(kept);
+  ground_removed_msg_.height = keep_organized ? cloud_msg_.height : 1;
+  ground_removed_msg_.is_dense = keep_organized ? false : cloud_msg_.is_dense;
+  ground_removed_msg_.row_step = ground_removed_msg_.width * ground_removed_msg_.point_step;
+  ground_removed_msg_.data.resize(ground_removed_msg_.height * ground_removed_msg_.row_step);
+  ground_removed_msg_.header.stamp = timestamp;
+  ground_removed_msg_.header.frame_id = frame_id;
+  ground_removed_cloud_pub_.publish(ground_removed_msg_);
 }
 
 void OBCameraNode::publishColoredPointCloud(const std::shared_ptr<ob::FrameSet>& frame_set) {
@@ -653,91 +1275,45 @@ void OBCameraNode::publishColoredPointCloud(const std::shared_ptr<ob::FrameSet>&
     auto camera_params = pipeline_->getCameraParam();
     intrinsics = camera_params.rgbIntrinsic;
   }
-  float fdx = intrinsics.fx * ((float)(color_width) / intrinsics.width);
-  float fdy = intrinsics.fy * ((float)(color_height) / intrinsics.height);
-  fdx = 1 / fdx;
-  fdy = 1 / fdy;
-  float u0 = intrinsics.cx * ((float)(color_width) / intrinsics.width);
-  float v0 = intrinsics.cy * ((float)(color_height) / intrinsics.height);
   const auto* depth_data = (uint16_t*)depth_frame->data();
-  const auto* color_data = (uint8_t*)(rgb_buffer_);
-  sensor_msgs::PointCloud2Modifier modifier(cloud_msg_);
-  modifier.setPointCloud2FieldsByString(1, "xyz");
-  cloud_msg_.width = color_frame->width();
-  cloud_msg_.height = color_frame->height();
-  std::string format_str = "rgb";
-  cloud_msg_.point_step = addPointField(cloud_msg_, format_str, 1, sensor_msgs::PointField::FLOAT32,
-                                        static_cast<int>(cloud_msg_.point_step));
-  cloud_msg_.row_step = cloud_msg_.width * cloud_msg_.point_step;
-  cloud_msg_.data.resize(cloud_msg_.height * cloud_msg_.row_step);
-  sensor_msgs::PointCloud2Iterator<float> iter_x(cloud_msg_, "x");
-  sensor_msgs::PointCloud2Iterator<float> iter_y(cloud_msg_, "y");
-  sensor_msgs::PointCloud2Iterator<float> iter_z(cloud_msg_, "z");
-  sensor_msgs::PointCloud2Iterator<uint8_t> iter_r(cloud_msg_, "r");
-  sensor_msgs::PointCloud2Iterator<uint8_t> iter_g(cloud_msg_, "g");
-  sensor_msgs::PointCloud2Iterator<uint8_t> iter_b(cloud_msg_, "b");
-  size_t valid_count = 0;
-  static const float MIN_DISTANCE = 20.0;
-  static const float MAX_DISTANCE = 10000.0;
-  double depth_scale = depth_frame->getValueScale();
-  static float min_depth = MIN_DISTANCE / depth_scale;
-  static float max_depth = MAX_DISTANCE / depth_scale;
-  for (int y = 0; y < color_height; y++) {
-    for (int x = 0; x < color_width; x++) {
-      bool valid_point = true;
-      float depth = depth_data[y * depth_width + x];
-      if (depth < min_depth || depth > max_depth) {
-        valid_point = false;
-      }
-      if (valid_point || ordered_pc_) {
-        float xf = (x - u0) * fdx;
-        float yf = (y - v0) * fdy;
-        float zf = depth * depth_scale;
-        *iter_x = zf * xf / 1000.0;
-        *iter_y = zf * yf / 1000.0;
-        *iter_z = zf / 1000.0;
-        *iter_r = color_data[(y * color_width + x) * 3];
-        *iter_g = color_data[(y * color_width + x) * 3 + 1];
-        *iter_b = color_data[(y * color_width + x) * 3 + 2];
-        ++iter_x;
-        ++iter_y;
-        ++iter_z;
-        ++iter_r;
-        ++iter_g;
-        ++iter_b;
-        ++valid_count;
-      }
-    }
-  }
-  if (!ordered_pc_) {
-    cloud_msg_.is_dense = true;
-    cloud_msg_.width = valid_count;
-    cloud_msg_.height = 1;
-    modifier.resize(valid_count);
-  }
-  auto timestamp = use_hardware_time_ ? fromUsToROSTime(depth_frame->timeStampUs())
-                                      : fromUsToROSTime(depth_frame->systemTimeStampUs());
+  RGBAttributeSource colors;
+  colors.rgb = (uint8_t*)(rgb_buffer_);
+  const auto& table = getPointCloudRayTable(COLOR, intrinsics, color_width, color_height);
+  generatePointCloud(depth_data, color_width, color_height, table, depth_frame->getValueScale(),
+                     PointAttribute::RGB, colors);
+  auto timestamp = frameTimeStamp(depth_frame);
   cloud_msg_.header.stamp = timestamp;
-  cloud_msg_.header.frame_id = optical_frame_id_[COLOR];
+  cloud_msg_.header.frame_id = table.frame_id;
   depth_registered_cloud_pub_.publish(cloud_msg_);
-  if (save_colored_point_cloud_) {
-    save_colored_point_cloud_ = false;
+  if (save_colored_point_cloud_ > 0) {
+    savePointCloudMsg("colored_points", colored_cloud_exporter_, save_colored_point_cloud_);
+  }
+}
+
+void OBCameraNode::savePointCloudMsg(const std::string& name, PointCloudExporter& exporter,
+                                     std::atomic_int& remaining_saves) {
+  if (remaining_saves == point_cloud_save_count_) {
     auto now = std::time(nullptr);
     std::stringstream ss;
     ss << std::put_time(std::localtime(&now), "%Y%m%d_%H%M%S");
     auto current_path = boost::filesystem::current_path().string();
-    std::string filename = current_path + "/point_cloud/colored_points_" + ss.str() + ".ply";
     if (!boost::filesystem::exists(current_path + "/point_cloud")) {
       boost::filesystem::create_directory(current_path + "/point_cloud");
     }
-    ROS_INFO_STREAM("Saving point cloud to " << filename);
-    try {
-      saveRGBPointCloudMsgToPly(cloud_msg_, filename);
-    } catch (const std::exception& e) {
-      ROS_ERROR_STREAM("Failed to save colored point cloud: " << e.what());
-    } catch (...) {
-      ROS_ERROR_STREAM("Failed to save colored point cloud with unknown error");
-    }
+    exporter.startSequence(current_path + "/point_cloud/" + name + "_" + ss.str());
+  }
+  --remaining_saves;
+  try {
+    auto filename = exporter.exportNext(cloud_msg_);
+    ROS_INFO_STREAM("Saved point cloud to " << filename << " (" << std::fixed
+                                            << std::setprecision(1) << exporter.lastThroughput()
+                                            << " MB/s)");
+  } catch (const std::exception& e) {
+    ROS_ERROR_STREAM("Failed to save point cloud: " << e.what());
+    remaining_saves = 0;
+  } catch (...) {
+    ROS_ERROR_STREAM("Failed to save point cloud with unknown error");
+    remaining_saves = 0;
   }
 }
 
@@ -788,6 +1364,37 @@ IMUInfo OBCameraNode::createIMUInfo(const stream_index_pair& stream_index) {
   return imu_info;
 }
 
+namespace {
+bool sameIMUCalibration(const IMUInfo& a, const IMUInfo& b) {
+  return a.noise_density == b.noise_density && a.random_walk == b.random_walk &&
+         a.reference_temperature == b.reference_temperature && a.bias == b.bias &&
+         a.gravity == b.gravity && a.scale_misalignment == b.scale_misalignment &&
+         a.temperature_slope == b.temperature_slope;
+}
+}  // namespace
+
+void OBCameraNode::updateIMUInfo(const stream_index_pair& stream_index) {
+  // the sample callbacks run on SDK threads and only read imu_info_ through at(), so every entry
+  // is inserted here, from setupPublishers, before any IMU sensor is started; later calls only
+  // overwrite the entry of a stream that is not running yet
+  auto cached = imu_info_.insert(std::make_pair(stream_index, IMUInfo())).first;
+  auto profile = stream_profile_.find(stream_index);
+  if (profile == stream_profile_.end() || !profile->second) {
+    return;
+  }
+  auto imu_info = createIMUInfo(stream_index);
+  imu_info.header.frame_id = imu_optical_frame_id_;
+  if (sameIMUCalibration(cached->second, imu_info)) {
+    return;
+  }
+  cached->second = imu_info;
+  // latched, late subscribers get the last calibration without any sample traffic
+  auto publisher = imu_info_publishers_.find(stream_index);
+  if (publisher != imu_info_publishers_.end()) {
+    publisher->second.publish(imu_info);
+  }
+}
+
 void OBCameraNode::setDefaultIMUMessage(sensor_msgs::Imu& imu_msg) {
   imu_msg.header.frame_id = "imu_link";
   imu_msg.orientation.x = 0.0;
@@ -802,23 +1409,32 @@ void OBCameraNode::setDefaultIMUMessage(sensor_msgs::Imu& imu_msg) {
       angular_vel_cov_, 0.0, 0.0, 0.0, angular_vel_cov_, 0.0, 0.0, 0.0, angular_vel_cov_};
 }
 
-sensor_msgs::Imu OBCameraNode::createUnitIMUMessage(const IMUData& accel_data,
-                                                    const IMUData& gyro_data) {
-  sensor_msgs::Imu imu_msg;
-  ros::Time timestamp = ros::Time::now();
-  imu_msg.header.stamp = timestamp;
-  imu_msg.angular_velocity.x = gyro_data.data_.x();
-  imu_msg.angular_velocity.y = gyro_data.data_.y();
-  imu_msg.angular_velocity.z = gyro_data.data_.z();
-
-  imu_msg.linear_acceleration.x = accel_data.data_.x();
-  imu_msg.linear_acceleration.y = accel_data.data_.y();
-  imu_msg.linear_acceleration.z = accel_data.data_.z();
-  return imu_msg;
+void OBCameraNode::publishUnitedImu(const ImuUnifier::Sample& gyro, const double accel[3]) {
+  auto imu_msg = sensor_msgs::Imu();
+  setDefaultIMUMessage(imu_msg);
+  imu_msg.header.frame_id = imu_optical_frame_id_;
+  imu_msg.header.stamp = ros::Time(gyro.time);
+  imu_msg.angular_velocity.x = gyro.value[0];
+  imu_msg.angular_velocity.y = gyro.value[1];
+  imu_msg.angular_velocity.z = gyro.value[2];
+  imu_msg.linear_acceleration.x = accel[0];
+  imu_msg.linear_acceleration.y = accel[1];
+  imu_msg.linear_acceleration.z = accel[2];
+  if (imu_gyro_accel_publisher_.getNumSubscribers() > 0) {
+    imu_gyro_accel_publisher_.publish(imu_msg);
+  }
+  if (imu_gyro_accel_batcher_ && imu_gyro_accel_batch_publisher_.getNumSubscribers() > 0) {
+    auto batch = imu_gyro_accel_batcher_->add(imu_msg.header.stamp, &imu_msg.angular_velocity,
+                                              &imu_msg.linear_acceleration);
+    if (batch) {
+      imu_gyro_accel_batch_publisher_.publish(batch);
+    }
+  }
 }
 
 void OBCameraNode::onNewIMUFrameSyncOutputCallback(const std::shared_ptr<ob::Frame>& accel_frame,
                                                    const std::shared_ptr<ob::Frame>& gyro_frame) {
+  auto callback_start = std::chrono::steady_clock::now();
   if (!isInitialized()) {
     ROS_WARN_ONCE("IMU sync output callback called before initialization");
     return;
@@ -828,41 +1444,27 @@ void OBCameraNode::onNewIMUFrameSyncOutputCallback(const std::shared_ptr<ob::Fra
     return;
   }
   ROS_INFO_STREAM_ONCE("IMU sync output callback called");
-  auto has_subscriber = imu_gyro_accel_publisher_.getNumSubscribers() > 0;
-  has_subscriber = has_subscriber || imu_info_publishers_[ACCEL].getNumSubscribers() > 0;
-  has_subscriber = has_subscriber || imu_info_publishers_[GYRO].getNumSubscribers() > 0;
-  if (!has_subscriber) {
-    return;
-  }
-
-  auto imu_msg = sensor_msgs::Imu();
-  setDefaultIMUMessage(imu_msg);
-
-  imu_msg.header.frame_id = imu_optical_frame_id_;
-  auto timestamp = use_hardware_time_ ? fromUsToROSTime(accel_frame->timeStampUs())
-                                      : fromUsToROSTime(accel_frame->systemTimeStampUs());
-  imu_msg.header.stamp = timestamp;
-  auto gyro_cast_frame = gyro_frame->as<ob::GyroFrame>();
-  auto gyro_info = createIMUInfo(GYRO);
-  gyro_info.header = imu_msg.header;
-  gyro_info.header.frame_id = imu_optical_frame_id_;
-  imu_info_publishers_[GYRO].publish(gyro_info);
-  auto gyroData = gyro_cast_frame->value();
-  imu_msg.angular_velocity.x = gyroData.x - gyro_info.bias[0];
-  imu_msg.angular_velocity.y = gyroData.y - gyro_info.bias[1];
-  imu_msg.angular_velocity.z = gyroData.z - gyro_info.bias[2];
-  auto accel_cast_frame = accel_frame->as<ob::AccelFrame>();
-  auto accelData = accel_cast_frame->value();
-  auto accel_info = createIMUInfo(ACCEL);
-  imu_msg.linear_acceleration.x = accelData.x - accel_info.bias[0];
-  imu_msg.linear_acceleration.y = accelData.y - accel_info.bias[1];
-  imu_msg.linear_acceleration.z = accelData.z - accel_info.bias[2];
-  imu_info_publishers_[ACCEL].publish(accel_info);
-  imu_gyro_accel_publisher_.publish(imu_msg);
+  recordFirstFrame(GYRO);
+  IMURawSample sample;
+  // the sync pipeline is the only producer, it borrows the gyro ring
+  sample.stream_index = GYRO;
+  sample.synced = true;
+  sample.device_us = accel_frame->timeStampUs();
+  sample.system_us = accel_frame->systemTimeStampUs();
+  auto gyro_data = gyro_frame->as<ob::GyroFrame>()->value();
+  sample.gyro[0] = gyro_data.x;
+  sample.gyro[1] = gyro_data.y;
+  sample.gyro[2] = gyro_data.z;
+  auto accel_data = accel_frame->as<ob::AccelFrame>()->value();
+  sample.accel[0] = accel_data.x;
+  sample.accel[1] = accel_data.y;
+  sample.accel[2] = accel_data.z;
+  dispatchIMUSample(sample, callback_start);
 }
 
 void OBCameraNode::onNewIMUFrameCallback(const std::shared_ptr<ob::Frame>& frame,
                                          const stream_index_pair& stream_index) {
+  auto callback_start = std::chrono::steady_clock::now();
   if (!isInitialized()) {
     ROS_WARN_ONCE("IMU callback called before initialization");
     return;
@@ -871,38 +1473,200 @@ void OBCameraNode::onNewIMUFrameCallback(const std::shared_ptr<ob::Frame>& frame
     ROS_ERROR_STREAM("stream " << stream_name_[stream_index] << " publisher not initialized");
     return;
   }
-  auto has_subscriber = imu_publishers_[stream_index].getNumSubscribers() > 0;
-  has_subscriber = has_subscriber || imu_info_publishers_[stream_index].getNumSubscribers() > 0;
-  if (!has_subscriber) {
+  recordFirstFrame(stream_index);
+  IMURawSample sample;
+  sample.stream_index = stream_index;
+  sample.device_us = frame->timeStampUs();
+  sample.system_us = frame->systemTimeStampUs();
+  if (frame->type() == OB_FRAME_GYRO) {
+    auto data = frame->as<ob::GyroFrame>()->value();
+    sample.gyro[0] = data.x;
+    sample.gyro[1] = data.y;
+    sample.gyro[2] = data.z;
+  } else if (frame->type() == OB_FRAME_ACCEL) {
+    auto data = frame->as<ob::AccelFrame>()->value();
+    sample.accel[0] = data.x;
+    sample.accel[1] = data.y;
+    sample.accel[2] = data.z;
+  } else {
+    ROS_ERROR("Unsupported IMU frame type");
     return;
   }
+  dispatchIMUSample(sample, callback_start);
+}
+
+void OBCameraNode::dispatchIMUSample(
+    const IMURawSample& sample, const std::chrono::steady_clock::time_point& callback_start) {
+  if (imu_publish_thread_) {
+    if (imu_rings_.at(sample.stream_index)->push(sample)) {
+      imu_publish_cv_.notify_one();
+    } else {
+      imu_ring_overflows_.fetch_add(1, std::memory_order_relaxed);
+    }
+  } else {
+    publishIMUSample(sample);
+  }
+  int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - callback_start)
+                         .count();
+  int64_t max_duration = imu_callback_max_ns_.load(std::memory_order_relaxed);
+  while (duration > max_duration &&
+         !imu_callback_max_ns_.compare_exchange_weak(max_duration, duration,
+                                                     std::memory_order_relaxed)) {
+  }
+  // with the publisher thread the report is left to that thread, off the SDK callback
+  if (!imu_publish_thread_ && duration > max_duration) {
+    ROS_INFO_STREAM_THROTTLE(10, "IMU callback worst case duration " << duration / 1000.0
+                                                                     << " us");
+  }
+}
+
+void OBCameraNode::publishIMUSample(const IMURawSample& sample) {
+  if (clock_offset_estimator_) {
+    clock_offset_estimator_->addSample(sample.device_us, sample.system_us);
+  }
+  auto timestamp = frameTimeStamp(sample.device_us, sample.system_us);
+  if (sample.synced) {
+    bool publish_sample = imu_gyro_accel_publisher_.getNumSubscribers() > 0;
+    bool publish_batch =
+        imu_gyro_accel_batcher_ && imu_gyro_accel_batch_publisher_.getNumSubscribers() > 0;
+    if (!publish_sample && !publish_batch) {
+      return;
+    }
+    auto imu_msg = sensor_msgs::Imu();
+    setDefaultIMUMessage(imu_msg);
+    imu_msg.header.frame_id = imu_optical_frame_id_;
+    imu_msg.header.stamp = timestamp;
+    const auto& gyro_bias = imu_info_.at(GYRO).bias;
+    imu_msg.angular_velocity.x = sample.gyro[0] - gyro_bias[0];
+    imu_msg.angular_velocity.y = sample.gyro[1] - gyro_bias[1];
+    imu_msg.angular_velocity.z = sample.gyro[2] - gyro_bias[2];
+    const auto& accel_bias = imu_info_.at(ACCEL).bias;
+    imu_msg.linear_acceleration.x = sample.accel[0] - accel_bias[0];
+    imu_msg.linear_acceleration.y = sample.accel[1] - accel_bias[1];
+    imu_msg.linear_acceleration.z = sample.accel[2] - accel_bias[2];
+    if (publish_sample) {
+      imu_gyro_accel_publisher_.publish(imu_msg);
+    }
+    if (publish_batch) {
+      auto batch = imu_gyro_accel_batcher_->add(timestamp, &imu_msg.angular_velocity,
+                                                &imu_msg.linear_acceleration);
+      if (batch) {
+        imu_gyro_accel_batch_publisher_.publish(batch);
+      }
+    }
+    return;
+  }
+  const auto& stream_index = sample.stream_index;
+  bool publish_sample = imu_publishers_[stream_index].getNumSubscribers() > 0;
+  bool publish_batch = imu_batch_publishers_.count(stream_index) &&
+                       imu_batch_publishers_[stream_index].getNumSubscribers() > 0;
+  bool publish_united =
+      imu_unifier_ && (imu_gyro_accel_publisher_.getNumSubscribers() > 0 ||
+                       imu_gyro_accel_batch_publisher_.getNumSubscribers() > 0);
+  if (!publish_sample && !publish_batch && !publish_united) {
+    return;
+  }
+  bool is_gyro = stream_index == GYRO;
   auto imu_msg = sensor_msgs::Imu();
   setDefaultIMUMessage(imu_msg);
   imu_msg.header.frame_id = optical_frame_id_[stream_index];
-  auto timestamp = use_hardware_time_ ? fromUsToROSTime(frame->timeStampUs())
-                                      : fromUsToROSTime(frame->systemTimeStampUs());
   imu_msg.header.stamp = timestamp;
-  auto imu_info = createIMUInfo(stream_index);
-  imu_info.header = imu_msg.header;
-  imu_info.header.frame_id = imu_optical_frame_id_;
-  imu_info_publishers_[stream_index].publish(imu_info);
-  if (frame->type() == OB_FRAME_GYRO) {
-    auto gyro_frame = frame->as<ob::GyroFrame>();
-    auto data = gyro_frame->value();
-    imu_msg.angular_velocity.x = data.x - imu_info.bias[0];
-    imu_msg.angular_velocity.y = data.y - imu_info.bias[1];
-    imu_msg.angular_velocity.z = data.z - imu_info.bias[2];
-  } else if (frame->type() == OB_FRAME_ACCEL) {
-    auto accel_frame = frame->as<ob::AccelFrame>();
-    auto data = accel_frame->value();
-    imu_msg.linear_acceleration.x = data.x - imu_info.bias[0];
-    imu_msg.linear_acceleration.y = data.y - imu_info.bias[1];
-    imu_msg.linear_acceleration.z = data.z - imu_info.bias[2];
+  const auto& imu_info = imu_info_.at(stream_index);
+  if (is_gyro) {
+    imu_msg.angular_velocity.x = sample.gyro[0] - imu_info.bias[0];
+    imu_msg.angular_velocity.y = sample.gyro[1] - imu_info.bias[1];
+    imu_msg.angular_velocity.z = sample.gyro[2] - imu_info.bias[2];
   } else {
-    ROS_ERROR("Unsupported IMU frame type");
+    imu_msg.linear_acceleration.x = sample.accel[0] - imu_info.bias[0];
+    imu_msg.linear_acceleration.y = sample.accel[1] - imu_info.bias[1];
+    imu_msg.linear_acceleration.z = sample.accel[2] - imu_info.bias[2];
+  }
+  if (publish_united) {
+    ImuUnifier::Sample united_sample;
+    united_sample.time = timestamp.toSec();
+    if (is_gyro) {
+      united_sample.value[0] = imu_msg.angular_velocity.x;
+      united_sample.value[1] = imu_msg.angular_velocity.y;
+      united_sample.value[2] = imu_msg.angular_velocity.z;
+      imu_unifier_->addGyro(united_sample, united_imu_output_);
+    } else {
+      united_sample.value[0] = imu_msg.linear_acceleration.x;
+      united_sample.value[1] = imu_msg.linear_acceleration.y;
+      united_sample.value[2] = imu_msg.linear_acceleration.z;
+      imu_unifier_->addAccel(united_sample);
+    }
+  }
+  if (publish_sample) {
+    imu_publishers_[stream_index].publish(imu_msg);
+  }
+  if (publish_batch) {
+    auto batch = imu_batchers_[stream_index]->add(
+        timestamp, is_gyro ? &imu_msg.angular_velocity : nullptr,
+        is_gyro ? nullptr : &imu_msg.linear_acceleration);
+    if (batch) {
+      imu_batch_publishers_[stream_index].publish(batch);
+    }
+  }
+}
+
+void OBCameraNode::startIMUPublishThread() {
+  if (!enable_imu_publish_thread_ || (!enable_stream_[ACCEL] && !enable_stream_[GYRO])) {
     return;
   }
-  imu_publishers_[stream_index].publish(imu_msg);
+  for (const auto& stream_index : HID_STREAMS) {
+    imu_rings_[stream_index] =
+        std::make_shared<SpscRing<IMURawSample>>(static_cast<size_t>(imu_ring_capacity_));
+  }
+  imu_publish_thread_ = std::make_shared<std::thread>([this]() { imuPublishThreadLoop(); });
+}
+
+void OBCameraNode::imuPublishThreadLoop() {
+  if (imu_publish_thread_priority_ > 0) {
+    sched_param param{};
+    param.sched_priority = imu_publish_thread_priority_;
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0) {
+      ROS_WARN_STREAM("Failed to run the IMU publisher thread with SCHED_FIFO priority "
+                      << imu_publish_thread_priority_ << ": " << strerror(ret)
+                      << ", check CAP_SYS_NICE or the rtprio limit");
+    }
+  }
+  const auto report_period = std::chrono::seconds(10);
+  auto next_report = std::chrono::steady_clock::now() + report_period;
+  uint64_t reported_overflows = 0;
+  int64_t reported_max_ns = 0;
+  // accel first, so a gyro sample finds its bracketing accel samples in the unifier
+  const std::vector<stream_index_pair> drain_order = {ACCEL, GYRO};
+  IMURawSample sample;
+  std::unique_lock<std::mutex> lock(imu_publish_mutex_);
+  while (is_running_ && ros::ok()) {
+    imu_publish_cv_.wait_for(lock, std::chrono::milliseconds(1));
+    for (const auto& stream_index : drain_order) {
+      auto& ring = imu_rings_[stream_index];
+      while (ring->pop(sample)) {
+        publishIMUSample(sample);
+      }
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_report) {
+      continue;
+    }
+    next_report = now + report_period;
+    uint64_t overflows = imu_ring_overflows_.load(std::memory_order_relaxed);
+    if (overflows != reported_overflows) {
+      ROS_WARN_STREAM("IMU ring overflowed, " << overflows - reported_overflows
+                                              << " samples dropped in the last "
+                                              << report_period.count() << " s, " << overflows
+                                              << " in total");
+      reported_overflows = overflows;
+    }
+    int64_t max_ns = imu_callback_max_ns_.load(std::memory_order_relaxed);
+    if (max_ns > reported_max_ns) {
+      ROS_INFO_STREAM("IMU callback worst case duration " << max_ns / 1000.0 << " us");
+      reported_max_ns = max_ns;
+    }
+  }
 }
 
 bool OBCameraNode::decodeColorFrameToBuffer(const std::shared_ptr<ob::Frame>& frame,
@@ -1032,6 +1796,21 @@ std::shared_ptr<ob::Frame> OBCameraNode::processDepthFrameFilter(
   return frame;
 }
 
+ros::Time OBCameraNode::frameTimeStamp(uint64_t device_us, uint64_t system_us) const {
+  if (enable_clock_sync_ && clock_offset_estimator_) {
+    uint64_t host_us = 0;
+    if (clock_offset_estimator_->toHostTime(device_us, host_us)) {
+      return fromUsToROSTime(host_us);
+    }
+    return fromUsToROSTime(system_us);
+  }
+  return use_hardware_time_ ? fromUsToROSTime(device_us) : fromUsToROSTime(system_us);
+}
+
+ros::Time OBCameraNode::frameTimeStamp(const std::shared_ptr<ob::Frame>& frame) const {
+  return frameTimeStamp(frame->timeStampUs(), frame->systemTimeStampUs());
+}
+
 void OBCameraNode::onNewFrameSetCallback(const std::shared_ptr<ob::FrameSet>& frame_set) {
   if (!is_running_) {
     ROS_WARN_ONCE("Frame callback called before initialization");
@@ -1046,8 +1825,29 @@ void OBCameraNode::onNewFrameSetCallback(const std::shared_ptr<ob::FrameSet>& fr
   }
   ROS_INFO_STREAM_ONCE("Received first frame set");
   try {
+    if (clock_offset_estimator_) {
+      for (const auto& stream_index : IMAGE_STREAMS) {
+        auto frame = frame_set->getFrame(STREAM_TYPE_TO_FRAME_TYPE.at(stream_index.first));
+        if (frame) {
+          clock_offset_estimator_->addSample(frame->timeStampUs(), frame->systemTimeStampUs());
+        }
+      }
+    }
+    // ahead of the filters and the early returns below
+    if (await_first_frame_) {
+      for (const auto& stream_index : IMAGE_STREAMS) {
+        if (frame_set->getFrame(STREAM_TYPE_TO_FRAME_TYPE.at(stream_index.first))) {
+          recordFirstFrame(stream_index);
+          break;
+        }
+      }
+    }
     std::shared_ptr<ob::ColorFrame> color_frame = frame_set->colorFrame();
     depth_frame_ = frame_set->getFrame(OB_FRAME_DEPTH);
+    // evaluated on the raw frame, ahead of filtering and alignment, to keep latency down
+    if (enable_proximity_ && depth_frame_ && proximity_pub_.getNumSubscribers() > 0) {
+      publishProximity(depth_frame_);
+    }
     CHECK_NOTNULL(device_info_);
     if (isGemini335PID(device_info_->pid()) && enable_stream_[DEPTH]) {
       depth_frame_ = processDepthFrameFilter(depth_frame_);
@@ -1070,6 +1870,15 @@ void OBCameraNode::onNewFrameSetCallback(const std::shared_ptr<ob::FrameSet>& fr
         return;
       }
     }
+    if (enable_laser_scan_ && depth_frame_ && laser_scan_pub_.getNumSubscribers() > 0) {
+      publishLaserScan(depth_frame_);
+    }
+    if (height_map_projector_ && depth_frame_ && height_map_pub_.getNumSubscribers() > 0) {
+      publishHeightMap(depth_frame_);
+    }
+    if (enable_depth_stats_ && depth_frame_ && depth_stats_pub_.getNumSubscribers() > 0) {
+      publishDepthStats(depth_frame_);
+    }
     if (enable_stream_[COLOR] && color_frame) {
       std::unique_lock<std::mutex> colorLock(colorFrameMtx_);
       colorFrameQueue_.push(frame_set);
@@ -1111,6 +1920,115 @@ void OBCameraNode::onNewFrameSetCallback(const std::shared_ptr<ob::FrameSet>& fr
   }
 }
 
+void OBCameraNode::publishLaserScan(const std::shared_ptr<ob::Frame>& frame) {
+  auto depth_frame = frame->as<ob::DepthFrame>();
+  if (!depth_frame) {
+    return;
+  }
+  // an aligned depth frame is in the color camera's geometry
+  const auto& stream_index = depth_registration_ ? COLOR : DEPTH;
+  auto profile = stream_profile_[stream_index]->as<ob::VideoStreamProfile>();
+  CHECK_NOTNULL(profile.get());
+  int width = static_cast<int>(depth_frame->width());
+  int height = static_cast<int>(depth_frame->height());
+  laser_scan_projector_.updateIntrinsics(profile->getIntrinsic(), width, height);
+  if (!laser_scan_projector_.project(static_cast<const uint16_t*>(depth_frame->data()), width,
+                                     height, depth_frame->getValueScale(), laser_scan_msg_)) {
+    return;
+  }
+  laser_scan_msg_.header.stamp = frameTimeStamp(depth_frame);
+  laser_scan_msg_.header.frame_id = frame_id_[stream_index];
+  laser_scan_pub_.publish(laser_scan_msg_);
+}
+
+void OBCameraNode::publishProximity(const std::shared_ptr<ob::Frame>& frame) {
+  auto depth_frame = frame->as<ob::DepthFrame>();
+  if (!depth_frame) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto profile = stream_profile_[DEPTH]->as<ob::VideoStreamProfile>();
+  CHECK_NOTNULL(profile.get());
+  int width = static_cast<int>(depth_frame->width());
+  int height = static_cast<int>(depth_frame->height());
+  proximity_monitor_.setRayTable(ray_table_cache_.get(RayTable::makeKey(
+      profile->getIntrinsic(), width, height, proximity_monitor_.transform().getBasis())));
+  if (!proximity_monitor_.evaluate(static_cast<const uint16_t*>(depth_frame->data()), width,
+                                   height, depth_frame->getValueScale(), proximity_results_)) {
+    return;
+  }
+  for (size_t i = 0; i < proximity_results_.size(); i++) {
+    auto& region = proximity_msg_.regions[i];
+    region.occupied = proximity_results_[i].occupied;
+    region.distance = proximity_results_[i].distance;
+    region.u = proximity_results_[i].u;
+    region.v = proximity_results_[i].v;
+  }
+  proximity_msg_.header.stamp = frameTimeStamp(depth_frame);
+  proximity_msg_.header.frame_id = optical_frame_id_[DEPTH];
+  proximity_msg_.processing_time = static_cast<float>(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  // measured from the capture time, the device stamp mapped into host time; the host arrival
+  // stamp already includes the transfer and SDK queueing and is only used before a clock sample
+  uint64_t capture_us = depth_frame->systemTimeStampUs();
+  if (clock_offset_estimator_) {
+    clock_offset_estimator_->toHostTime(depth_frame->timeStampUs(), capture_us);
+  }
+  double latency = (ros::Time::now() - fromUsToROSTime(capture_us)).toSec();
+  proximity_msg_.latency = static_cast<float>(latency);
+  proximity_pub_.publish(proximity_msg_);
+  proximity_frame_count_++;
+  proximity_latency_sum_ += latency;
+  proximity_latency_max_ = std::max(proximity_latency_max_, latency);
+  ROS_DEBUG_STREAM_THROTTLE(10, "Proximity latency: mean "
+                                    << proximity_latency_sum_ / proximity_frame_count_ * 1e3
+                                    << " ms, max " << proximity_latency_max_ * 1e3 << " ms");
+}
+
+void OBCameraNode::publishDepthStats(const std::shared_ptr<ob::Frame>& frame) {
+  auto depth_frame = frame->as<ob::DepthFrame>();
+  if (!depth_frame) {
+    return;
+  }
+  const auto& stream_index = depth_registration_ ? COLOR : DEPTH;
+  depth_statistics_.compute(static_cast<const uint16_t*>(depth_frame->data()),
+                            depth_frame->width(), depth_frame->height(),
+                            depth_frame->getValueScale(), depth_stats_msg_);
+  depth_stats_msg_.header.stamp = frameTimeStamp(depth_frame);
+  depth_stats_msg_.header.frame_id = optical_frame_id_[stream_index];
+  depth_stats_pub_.publish(depth_stats_msg_);
+}
+
+void OBCameraNode::publishHeightMap(const std::shared_ptr<ob::Frame>& frame) {
+  auto depth_frame = frame->as<ob::DepthFrame>();
+  if (!depth_frame) {
+    return;
+  }
+  const auto& stream_index = depth_registration_ ? COLOR : DEPTH;
+  auto profile = stream_profile_[stream_index]->as<ob::VideoStreamProfile>();
+  CHECK_NOTNULL(profile.get());
+  int width = static_cast<int>(depth_frame->width());
+  int height = static_cast<int>(depth_frame->height());
+  auto start = std::chrono::steady_clock::now();
+  height_map_projector_->setRayTable(ray_table_cache_.get(RayTable::makeKey(
+      profile->getIntrinsic(), width, height, height_map_projector_->transform().getBasis())));
+  if (!height_map_projector_->project(static_cast<const uint16_t*>(depth_frame->data()), width,
+                                      height, depth_frame->getValueScale(), height_map_msg_)) {
+    return;
+  }
+  height_map_cell_updates_ += height_map_projector_->lastCellUpdates();
+  height_map_seconds_ +=
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double cell_updates_per_second = height_map_cell_updates_ / height_map_seconds_;
+  ROS_DEBUG_STREAM_THROTTLE(10, "Height map: " << cell_updates_per_second / 1e6
+                                               << " M cell updates/s");
+  auto timestamp = frameTimeStamp(depth_frame);
+  height_map_msg_.header.stamp = timestamp;
+  height_map_msg_.header.frame_id = height_map_frame_id_;
+  height_map_msg_.info.map_load_time = timestamp;
+  height_map_pub_.publish(height_map_msg_);
+}
+
 void OBCameraNode::onNewColorFrameCallback() {
   while (enable_stream_[COLOR] && ros::ok() && is_running_.load()) {
     std::unique_lock<std::mutex> lock(colorFrameMtx_);
@@ -1196,6 +2114,12 @@ void OBCameraNode::onNewFrameCallback(const std::shared_ptr<ob::Frame>& frame,
   if (frame == nullptr) {
     return;
   }
+  // in sensor mode this is the only place frames pass through, the pipeline feeds the estimator
+  // from onNewFrameSetCallback; sampled ahead of the subscriber check so the fit keeps up
+  if (clock_offset_estimator_ && !enable_pipeline_) {
+    clock_offset_estimator_->addSample(frame->timeStampUs(), frame->systemTimeStampUs());
+  }
+  recordFirstFrame(stream_index);
   bool has_subscriber = image_publishers_[stream_index].getNumSubscribers() > 0;
   if (camera_info_publishers_[stream_index].getNumSubscribers() > 0) {
     has_subscriber = true;
@@ -1207,6 +2131,8 @@ void OBCameraNode::onNewFrameCallback(const std::shared_ptr<ob::Frame>& frame,
   if (!has_subscriber) {
     return;
   }
+  recordResumeFrame(stream_index);
+  recordProfileSwitchFrame(stream_index);
   std::shared_ptr<ob::VideoFrame> video_frame;
   if (frame->type() == OB_FRAME_COLOR) {
     video_frame = frame->as<ob::ColorFrame>();
@@ -1225,8 +2151,7 @@ void OBCameraNode::onNewFrameCallback(const std::shared_ptr<ob::Frame>& frame,
   }
   int width = static_cast<int>(video_frame->width());
   int height = static_cast<int>(video_frame->height());
-  auto timestamp = use_hardware_time_ ? fromUsToROSTime(video_frame->timeStampUs())
-                                      : fromUsToROSTime(video_frame->systemTimeStampUs());
+  auto timestamp = frameTimeStamp(video_frame);
   std::string frame_id = (depth_registration_ && stream_index == DEPTH)
                              ? depth_aligned_frame_id_[stream_index]
                              : optical_frame_id_[stream_index];
@@ -1418,9 +2343,24 @@ void OBCameraNode::saveImageToFile(const stream_index_pair& stream_index, const
 void OBCameraNode::imageSubscribedCallback(const stream_index_pair& stream_index) {
   ROS_INFO_STREAM("Image stream " << stream_name_[stream_index] << " subscribed");
   std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+  if (image_idle_.exchange(false)) {
+    resume_requested_at_ = std::chrono::steady_clock::now();
+    await_resume_frame_ = true;
+  }
+  if (device_detached_) {
+    ROS_INFO_STREAM("Device is reconnecting, stream " << stream_name_[stream_index]
+                                                      << " starts once it is back");
+    restart_pipeline_ = true;
+    restart_streams_[stream_index] = true;
+    return;
+  }
   if (enable_pipeline_) {
     if (pipeline_started_) {
-      ROS_INFO_STREAM("pipe line already started");
+      if (pipeline_standby_) {
+        setPipelineStandby(false);
+      } else {
+        ROS_INFO_STREAM("pipe line already started");
+      }
       return;
     }
     try {
@@ -1434,7 +2374,11 @@ void OBCameraNode::imageSubscribedCallback(const stream_index_pair& stream_index
     }
   } else {
     if (stream_started_[stream_index]) {
-      ROS_INFO_STREAM("Stream " << stream_name_[stream_index] << " is already started.");
+      if (stream_standby_[stream_index]) {
+        setStreamStandby(stream_index, false);
+      } else {
+        ROS_INFO_STREAM("Stream " << stream_name_[stream_index] << " is already started.");
+      }
       return;
     }
     startStream(stream_index);
@@ -1444,6 +2388,13 @@ void OBCameraNode::imageSubscribedCallback(const stream_index_pair& stream_index
 void OBCameraNode::imuSubscribedCallback(const orbbec_camera::stream_index_pair& stream_index) {
   ROS_INFO_STREAM("IMU stream " << stream_name_[stream_index] << " subscribed");
   std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+  if (device_detached_) {
+    ROS_INFO_STREAM("Device is reconnecting, stream " << stream_name_[stream_index]
+                                                      << " starts once it is back");
+    restart_imu_sync_ = true;
+    restart_streams_[stream_index] = true;
+    return;
+  }
   try {
     if (enable_sync_output_accel_gyro_) {
       if (imu_sync_output_start_) {
@@ -1475,42 +2426,243 @@ void OBCameraNode::imageUnsubscribedCallback(const stream_index_pair& stream_ind
       ROS_INFO_STREAM("imageUnsubscribedCallback pipe line not start");
       return;
     }
-    bool all_stream_no_subscriber = true;
-    for (auto& item : image_publishers_) {
-      if (item.second.getNumSubscribers() > 0) {
-        all_stream_no_subscriber = false;
-        break;
-      }
+    if (!hasPipelineSubscribers()) {
+      scheduleIdlePolicy(stream_index);
     }
-    for (auto& item : camera_info_publishers_) {
-      if (item.second.getNumSubscribers() > 0) {
-        all_stream_no_subscriber = false;
-        break;
-      }
+  } else {
+    if (!stream_started_[stream_index]) {
+      ROS_INFO_STREAM("Stream " << stream_name_[stream_index] << " is not started.");
+      return;
     }
-    if (enable_point_cloud_) {
-      if (depth_cloud_pub_.getNumSubscribers() > 0) {
-        all_stream_no_subscriber = false;
-      }
+    if (!hasStreamSubscribers(stream_index)) {
+      scheduleIdlePolicy(stream_index);
     }
-    if (enable_colored_point_cloud_) {
-      if (depth_registered_cloud_pub_.getNumSubscribers() > 0) {
-        all_stream_no_subscriber = false;
-      }
+  }
+}
+
+bool OBCameraNode::hasPipelineSubscribers() {
+  for (const auto& stream_index : IMAGE_STREAMS) {
+    if (hasStreamSubscribers(stream_index)) {
+      return true;
     }
-    if (all_stream_no_subscriber) {
-      // stopStreams();
+  }
+  return false;
+}
+
+bool OBCameraNode::hasStreamSubscribers(const stream_index_pair& stream_index) {
+  auto image_publisher = image_publishers_.find(stream_index);
+  if (image_publisher != image_publishers_.end() &&
+      image_publisher->second.getNumSubscribers() > 0) {
+    return true;
+  }
+  auto camera_info_publisher = camera_info_publishers_.find(stream_index);
+  if (camera_info_publisher != camera_info_publishers_.end() &&
+      camera_info_publisher->second.getNumSubscribers() > 0) {
+    return true;
+  }
+  if (stream_index == DEPTH) {
+    if (enable_point_cloud_ &&
+        (depth_cloud_pub_.getNumSubscribers() > 0 || depth_normals_pub_.getNumSubscribers() > 0 ||
+         floor_plane_pub_.getNumSubscribers() > 0 ||
+         ground_removed_cloud_pub_.getNumSubscribers() > 0)) {
+      return true;
     }
-  } else {
-    if (!stream_started_[stream_index]) {
-      ROS_INFO_STREAM("Stream " << stream_name_[stream_index] << " is not started.");
+    if ((enable_laser_scan_ && laser_scan_pub_.getNumSubscribers() > 0) ||
+        (enable_height_map_ && height_map_pub_.getNumSubscribers() > 0) ||
+        (enable_depth_stats_ && depth_stats_pub_.getNumSubscribers() > 0) ||
+        (enable_proximity_ && proximity_pub_.getNumSubscribers() > 0)) {
+      return true;
+    }
+  }
+  if ((stream_index == DEPTH || stream_index == intensity_ir_stream_) &&
+      enable_point_cloud_intensity_ && intensity_cloud_pub_.getNumSubscribers() > 0) {
+    return true;
+  }
+  if ((stream_index == DEPTH || stream_index == COLOR) && enable_colored_point_cloud_ &&
+      depth_registered_cloud_pub_.getNumSubscribers() > 0) {
+    return true;
+  }
+  return false;
+}
+
+void OBCameraNode::scheduleIdlePolicy(const stream_index_pair& stream_index) {
+  if (idle_policy_ == IdlePolicy::KEEP) {
+    return;
+  }
+  idle_streams_.insert(stream_index);
+  if (idle_timeout_ <= 0.0) {
+    applyIdlePolicy();
+    return;
+  }
+  // re-armed by every unsubscribe, the policy applies idle_timeout_ after the last one
+  idle_timer_.stop();
+  idle_timer_.setPeriod(ros::WallDuration(idle_timeout_));
+  idle_timer_.start();
+}
+
+void OBCameraNode::applyIdlePolicy() {
+  std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+  // only the streams whose last subscriber left since the policy was last applied
+  std::set<stream_index_pair> idle_streams;
+  idle_streams.swap(idle_streams_);
+  if (device_detached_ || idle_policy_ == IdlePolicy::KEEP) {
+    return;
+  }
+  if (enable_pipeline_) {
+    if (!pipeline_started_ || pipeline_standby_ || hasPipelineSubscribers()) {
       return;
     }
-    auto subscriber_count = image_publishers_[stream_index].getNumSubscribers();
-    if (subscriber_count == 0) {
+    // the next subscriber measures how long resuming takes
+    image_idle_ = true;
+    if (idle_policy_ == IdlePolicy::STOP) {
+      ROS_INFO_STREAM("No subscribers, stopping the pipeline");
+      stopStreams();
+    } else {
+      setPipelineStandby(true);
+    }
+    return;
+  }
+  for (const auto& stream_index : idle_streams) {
+    // a subscriber may have come back while the timer was pending
+    if (!stream_started_[stream_index] || stream_standby_[stream_index] ||
+        hasStreamSubscribers(stream_index)) {
+      continue;
+    }
+    image_idle_ = true;
+    if (idle_policy_ == IdlePolicy::STOP) {
       stopStream(stream_index);
+    } else {
+      setStreamStandby(stream_index, true);
+    }
+  }
+}
+
+void OBCameraNode::setPipelineStandby(bool standby) {
+  std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+  if (!pipeline_started_ || pipeline_standby_ == standby || !standby_pipeline_config_) {
+    return;
+  }
+  try {
+    pipeline_->stop();
+    startPipeline(standby ? standby_pipeline_config_ : pipeline_config_);
+    pipeline_standby_ = standby;
+    if (standby) {
+      ROS_INFO_STREAM("No subscribers, pipeline in standby near " << standby_fps_ << " fps");
+    } else {
+      ROS_INFO_STREAM("Pipeline resumed from standby");
     }
+  } catch (const ob::Error& e) {
+    ROS_ERROR_STREAM("Failed to switch pipeline standby: " << e.getMessage());
+    // stopped or half started, the next subscriber starts it from scratch
+    pipeline_started_ = false;
+    pipeline_standby_ = false;
+  }
+}
+
+void OBCameraNode::setStreamStandby(const stream_index_pair& stream_index, bool standby) {
+  std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+  if (!stream_started_[stream_index] || stream_standby_[stream_index] == standby) {
+    return;
+  }
+  auto profile = standby ? standbyProfile(stream_index) : stream_profile_[stream_index];
+  try {
+    sensors_[stream_index]->stopStream();
+    sensors_[stream_index]->startStream(profile, frame_callback_[stream_index]);
+    stream_standby_[stream_index] = standby;
+    ROS_INFO_STREAM("Stream " << stream_name_[stream_index]
+                              << (standby ? " in standby at " : " resumed at ")
+                              << profile->as<ob::VideoStreamProfile>()->fps() << " fps");
+  } catch (const ob::Error& e) {
+    ROS_ERROR_STREAM("Failed to switch stream " << stream_name_[stream_index]
+                                                << " standby: " << e.getMessage());
+    stream_started_[stream_index] = false;
+    stream_standby_[stream_index] = false;
+  }
+}
+
+void OBCameraNode::recordResumeFrame(const stream_index_pair& stream_index) {
+  if (!await_resume_frame_ || !await_resume_frame_.exchange(false)) {
+    return;
   }
+  auto elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              resume_requested_at_)
+                        .count();
+  ROS_INFO_STREAM("Idle policy " << idlePolicyToString(idle_policy_) << ": first "
+                                 << stream_name_[stream_index] << " frame " << elapsed_ms
+                                 << " ms after subscribe");
+  resume_latency_.record(elapsed_ms);
+}
+
+void OBCameraNode::recordProfileSwitchFrame(const stream_index_pair& stream_index) {
+  if (!profile_switch_armed_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(profile_switch_mutex_);
+  if (stream_index != profile_switch_stream_) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (!profile_switch_restarted_) {
+    profile_switch_last_frame_ = now;
+    profile_switch_has_last_frame_ = true;
+    return;
+  }
+  profile_switch_armed_ = false;
+  // a stream that was quiet before the switch is measured from the stop
+  auto gap_from =
+      profile_switch_has_last_frame_ ? profile_switch_last_frame_ : profile_switch_started_at_;
+  double gap_ms = std::chrono::duration<double, std::milli>(now - gap_from).count();
+  double period_ms = 1000.0 / std::max(profile_switch_fps_, 1);
+  profile_switch_missed_frames_ =
+      std::max(0, static_cast<int>(std::lround(gap_ms / period_ms)) - 1);
+  profile_switch_gap_.record(gap_ms);
+  ROS_INFO_STREAM("Stream " << stream_name_[stream_index] << " profile switch gap " << gap_ms
+                            << " ms (" << profile_switch_missed_frames_ << " frames missed)");
+}
+
+void OBCameraNode::applyStreamProfile(const stream_index_pair& stream_index,
+                                      const std::shared_ptr<ob::VideoStreamProfile>& profile) {
+  bool resized = width_[stream_index] != static_cast<int>(profile->width()) ||
+                 height_[stream_index] != static_cast<int>(profile->height());
+  stream_profile_[stream_index] = profile;
+  width_[stream_index] = static_cast<int>(profile->width());
+  height_[stream_index] = static_cast<int>(profile->height());
+  fps_[stream_index] = static_cast<int>(profile->fps());
+  format_[stream_index] = profile->format();
+  // updateImageConfig only overrides the 8 bit cases, start again from the setupConfig defaults
+  if (stream_index == COLOR) {
+    image_format_[stream_index] = CV_8UC3;
+    unit_step_size_[stream_index] = 3;
+    if (!ffmpeg_decoder_) {
+      // encoded color keeps the BGR8 of the ffmpeg decoder, its format never changes here
+      encoding_[stream_index] = sensor_msgs::image_encodings::RGB8;
+    }
+  } else {
+    image_format_[stream_index] = CV_16UC1;
+    encoding_[stream_index] = stream_index == DEPTH ? sensor_msgs::image_encodings::TYPE_16UC1
+                                                    : sensor_msgs::image_encodings::MONO16;
+    unit_step_size_[stream_index] = sizeof(uint16_t);
+  }
+  updateImageConfig(stream_index, profile);
+  if (stream_index == COLOR && resized) {
+    // the color thread decodes into rgb_buffer_ while holding this lock
+    std::lock_guard<std::mutex> lock(colorFrameMtx_);
+    std::queue<std::shared_ptr<ob::FrameSet>>().swap(colorFrameQueue_);
+    delete[] rgb_buffer_;
+    rgb_buffer_ = new uint8_t[width_[COLOR] * height_[COLOR] * 3];
+    rgb_is_decoded_ = false;
+#if defined(USE_RK_HW_DECODER)
+    mjpeg_decoder_ = std::make_shared<RKMjpegDecoder>(width_[COLOR], height_[COLOR]);
+#elif defined(USE_NV_HW_DECODER)
+    mjpeg_decoder_ = std::make_shared<JetsonNvJPEGDecoder>(width_[COLOR], height_[COLOR]);
+#endif
+  }
+  // camera info follows width_ and height_, point cloud ray tables rebuild on the next frame
+  updateCameraInfos();
+  // hardware D2C in sensor mode is bound to the calibration of the current aspect ratios
+  setupHardwareAlignment();
+  pipeline_config_.reset();
+  standby_pipeline_config_.reset();
 }
 
 void OBCameraNode::imuUnsubscribedCallback(const stream_index_pair& stream_index) {
@@ -1526,18 +2678,27 @@ void OBCameraNode::imuUnsubscribedCallback(const stream_index_pair& stream_index
       return;
     }
   }
-  if (imu_gyro_accel_publisher_.getNumSubscribers() > 0) {
+  if (imu_batch_publishers_.count(stream_index) > 0 &&
+      imu_batch_publishers_[stream_index].getNumSubscribers() > 0) {
     return;
   }
-  if (imu_info_publishers_.count(stream_index) > 0) {
-    auto subscriber_count = imu_info_publishers_[stream_index].getNumSubscribers();
-    if (subscriber_count > 0) {
-      return;
-    }
+  if (imu_gyro_accel_publisher_.getNumSubscribers() > 0 ||
+      imu_gyro_accel_batch_publisher_.getNumSubscribers() > 0) {
+    return;
   }
   stopIMU(stream_index);
 }
 
+void OBCameraNode::unitedImuSubscribedCallback() {
+  imuSubscribedCallback(ACCEL);
+  imuSubscribedCallback(GYRO);
+}
+
+void OBCameraNode::unitedImuUnsubscribedCallback() {
+  imuUnsubscribedCallback(ACCEL);
+  imuUnsubscribedCallback(GYRO);
+}
+
 void OBCameraNode::pointCloudSubscribedCallback() {
   ROS_INFO_STREAM("point cloud subscribed");
   imageSubscribedCallback(DEPTH);
@@ -1545,7 +2706,38 @@ void OBCameraNode::pointCloudSubscribedCallback() {
 
 void OBCameraNode::pointCloudUnsubscribedCallback() {
   ROS_INFO_STREAM("point cloud unsubscribed");
-  if (depth_cloud_pub_.getNumSubscribers() > 0) {
+  if (depth_cloud_pub_.getNumSubscribers() > 0 || depth_normals_pub_.getNumSubscribers() > 0 ||
+      floor_plane_pub_.getNumSubscribers() > 0 ||
+      ground_removed_cloud_pub_.getNumSubscribers() > 0) {
+    return;
+  }
+  imageUnsubscribedCallback(DEPTH);
+}
+
+void OBCameraNode::intensityPointCloudSubscribedCallback() {
+  ROS_INFO_STREAM("intensity point cloud subscribed");
+  imageSubscribedCallback(DEPTH);
+  imageSubscribedCallback(intensity_ir_stream_);
+}
+
+void OBCameraNode::intensityPointCloudUnsubscribedCallback() {
+  ROS_INFO_STREAM("intensity point cloud unsubscribed");
+  if (intensity_cloud_pub_.getNumSubscribers() > 0) {
+    return;
+  }
+  imageUnsubscribedCallback(DEPTH);
+  imageUnsubscribedCallback(intensity_ir_stream_);
+}
+
+void OBCameraNode::depthOutputSubscribedCallback() {
+  ROS_INFO_STREAM("depth output subscribed");
+  imageSubscribedCallback(DEPTH);
+}
+
+void OBCameraNode::depthOutputUnsubscribedCallback() {
+  ROS_INFO_STREAM("depth output unsubscribed");
+  if (laser_scan_pub_.getNumSubscribers() > 0 || height_map_pub_.getNumSubscribers() > 0 ||
+      depth_stats_pub_.getNumSubscribers() > 0 || proximity_pub_.getNumSubscribers() > 0) {
     return;
   }
   imageUnsubscribedCallback(DEPTH);
@@ -1566,10 +2758,28 @@ void OBCameraNode::coloredPointCloudUnsubscribedCallback() {
   imageUnsubscribedCallback(COLOR);
 }
 
+const std::vector<OBCameraParam>& OBCameraNode::getCalibrationCameraParams() {
+  if (calibration_params_loaded_) {
+    return calibration_params_;
+  }
+  if (!capability_cache_ || !capability_cache_->cameraParams(calibration_params_)) {
+    auto camera_params = device_->getCalibrationCameraParamList();
+    calibration_params_.clear();
+    for (size_t i = 0; i < camera_params->count(); i++) {
+      calibration_params_.push_back(camera_params->getCameraParam(i));
+    }
+    if (capability_cache_) {
+      capability_cache_->setCameraParams(calibration_params_);
+    }
+  }
+  calibration_params_loaded_ = true;
+  return calibration_params_;
+}
+
 boost::optional<OBCameraParam> OBCameraNode::getCameraParam() {
-  auto camera_params = device_->getCalibrationCameraParamList();
-  for (size_t i = 0; i < camera_params->count(); i++) {
-    auto param = camera_params->getCameraParam(i);
+  const auto& camera_params = getCalibrationCameraParams();
+  for (size_t i = 0; i < camera_params.size(); i++) {
+    const auto& param = camera_params[i];
     int depth_w = param.depthIntrinsic.width;
     int depth_h = param.depthIntrinsic.height;
     int color_w = param.rgbIntrinsic.width;
@@ -1583,9 +2793,9 @@ boost::optional<OBCameraParam> OBCameraNode::getCameraParam() {
 }
 
 boost::optional<OBCameraParam> OBCameraNode::getCameraDepthParam() {
-  auto camera_params = device_->getCalibrationCameraParamList();
-  for (size_t i = 0; i < camera_params->count(); i++) {
-    auto param = camera_params->getCameraParam(i);
+  const auto& camera_params = getCalibrationCameraParams();
+  for (size_t i = 0; i < camera_params.size(); i++) {
+    const auto& param = camera_params[i];
     int depth_w = param.depthIntrinsic.width;
     int depth_h = param.depthIntrinsic.height;
     if (depth_w == width_[DEPTH] && depth_h == height_[DEPTH]) {
@@ -1594,8 +2804,8 @@ boost::optional<OBCameraParam> OBCameraNode::getCameraDepthParam() {
     }
   }
 
-  for (size_t i = 0; i < camera_params->count(); i++) {
-    auto param = camera_params->getCameraParam(i);
+  for (size_t i = 0; i < camera_params.size(); i++) {
+    const auto& param = camera_params[i];
     int depth_w = param.depthIntrinsic.width;
     int depth_h = param.depthIntrinsic.height;
     if (depth_w * height_[DEPTH] == depth_h * width_[DEPTH]) {
@@ -1607,9 +2817,9 @@ boost::optional<OBCameraParam> OBCameraNode::getCameraDepthParam() {
 }
 
 boost::optional<OBCameraParam> OBCameraNode::getCameraColorParam() {
-  auto camera_params = device_->getCalibrationCameraParamList();
-  for (size_t i = 0; i < camera_params->count(); i++) {
-    auto param = camera_params->getCameraParam(i);
+  const auto& camera_params = getCalibrationCameraParams();
+  for (size_t i = 0; i < camera_params.size(); i++) {
+    const auto& param = camera_params[i];
     int color_w = param.rgbIntrinsic.width;
     int color_h = param.rgbIntrinsic.height;
     if (color_w == width_[COLOR] && color_h == height_[COLOR]) {
@@ -1618,8 +2828,8 @@ boost::optional<OBCameraParam> OBCameraNode::getCameraColorParam() {
     }
   }
 
-  for (size_t i = 0; i < camera_params->count(); i++) {
-    auto param = camera_params->getCameraParam(i);
+  for (size_t i = 0; i < camera_params.size(); i++) {
+    const auto& param = camera_params[i];
     int color_w = param.rgbIntrinsic.width;
     int color_h = param.rgbIntrinsic.height;
     if (color_w * height_[COLOR] == color_h * width_[COLOR]) {
@@ -1631,9 +2841,9 @@ boost::optional<OBCameraParam> OBCameraNode::getCameraColorParam() {
 }
 
 int OBCameraNode::getCameraParamIndex() {
-  auto camera_params = device_->getCalibrationCameraParamList();
-  for (size_t i = 0; i < camera_params->count(); i++) {
-    auto param = camera_params->getCameraParam(i);
+  const auto& camera_params = getCalibrationCameraParams();
+  for (size_t i = 0; i < camera_params.size(); i++) {
+    const auto& param = camera_params[i];
     int depth_w = param.depthIntrinsic.width;
     int depth_h = param.depthIntrinsic.height;
     int color_w = param.rgbIntrinsic.width;
@@ -1663,6 +2873,29 @@ void OBCameraNode::publishStaticTF(const ros::Time& t, const tf2::Vector3& trans
   static_tf_msgs_.push_back(msg);
 }
 
+tf2::Transform OBCameraNode::getOpticalToCameraLinkTransform(
+    const stream_index_pair& stream_index) {
+  // Same chain as calcAndPublishStaticTransform: camera_link -> frame -> optical frame.
+  tf2::Quaternion quaternion_optical;
+  quaternion_optical.setRPY(-M_PI / 2, 0.0, -M_PI / 2);
+  OBExtrinsic ex({{1, 0, 0, 0, 1, 0, 0, 0, 1}, {0, 0, 0}});
+  if (stream_profile_.count(stream_index) && stream_profile_.count(base_stream_) &&
+      stream_profile_[stream_index] && stream_profile_[base_stream_]) {
+    try {
+      ex = stream_profile_[stream_index]->getExtrinsicTo(stream_profile_[base_stream_]);
+    } catch (const ob::Error& e) {
+      ROS_ERROR_STREAM("Failed to get " << stream_name_[stream_index]
+                                        << " extrinsic: " << e.getMessage());
+    }
+  }
+  auto Q = rotationMatrixToQuaternion(ex.rot);
+  Q = quaternion_optical * Q * quaternion_optical.inverse();
+  tf2::Vector3 trans(ex.trans[2] / 1000.0, -ex.trans[0] / 1000.0, -ex.trans[1] / 1000.0);
+  tf2::Transform link_to_frame(Q, trans);
+  tf2::Transform frame_to_optical(quaternion_optical, tf2::Vector3(0, 0, 0));
+  return link_to_frame * frame_to_optical;
+}
+
 void OBCameraNode::calcAndPublishStaticTransform() {
   tf2::Quaternion quaternion_optical, zero_rot;
   zero_rot.setRPY(0.0, 0.0, 0.0);
@@ -17,11 +17,14 @@
 #include "orbbec_camera/ob_camera_node_driver.h"
 #include <fcntl.h>
 #include <unistd.h>
-#include <semaphore.h>
-#include <sys/shm.h>
+#include <sys/file.h>
+#include <sys/stat.h>
 #include <ros/package.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
 #include <regex>
-#include <sys/mman.h>
 
 namespace orbbec_camera {
 OBCameraNodeDriver::OBCameraNodeDriver(ros::NodeHandle &nh, ros::NodeHandle &nh_private)
@@ -32,6 +35,18 @@ OBCameraNodeDriver::OBCameraNodeDriver(ros::NodeHandle &nh, ros::NodeHandle &nh_
   init();
 }
 
+OBCameraNodeDriver::OBCameraNodeDriver(ros::NodeHandle &nh, ros::NodeHandle &nh_private,
+                                       const SharedDriverResources &shared)
+    : nh_(nh),
+      nh_private_(nh_private),
+      ctx_(shared.ctx),
+      device_num_(shared.device_num),
+      hosted_(true),
+      select_lock_(shared.select_lock),
+      worker_pool_(shared.worker_pool) {
+  init();
+}
+
 OBCameraNodeDriver::~OBCameraNodeDriver() {
   is_alive_ = false;
   if (reset_device_thread_ && reset_device_thread_->joinable()) {
@@ -45,33 +60,19 @@ OBCameraNodeDriver::~OBCameraNodeDriver() {
 
 void OBCameraNodeDriver::init() {
   is_alive_ = true;
+  serial_number_ = nh_private_.param<std::string>("serial_number", "");
+  usb_port_ = nh_private_.param<std::string>("usb_port", "");
+  connection_delay_ = nh_private_.param<int>("connection_delay", 0);
+  device_ready_timeout_ = nh_private_.param<int>("device_ready_timeout", 5000);
+  warm_reconnect_ = nh_private_.param<bool>("warm_reconnect", false);
+  if (hosted_) {
+    // the owning OBMultiCameraDriver configures the shared context and forwards its events
+    reset_device_thread_ = std::make_shared<std::thread>([this]() { resetDeviceThread(); });
+    return;
+  }
   auto log_level = nh_private_.param<std::string>("log_level", "info");
   auto ob_log_level = obLogSeverityFromString(log_level);
   ctx_->setLoggerToConsole(ob_log_level);
-  orb_device_lock_shm_fd_ = shm_open(ORB_DEFAULT_LOCK_NAME.c_str(), O_CREAT | O_RDWR, 0666);
-  if (orb_device_lock_shm_fd_ < 0) {
-    ROS_ERROR_STREAM("Failed to open shared memory " << ORB_DEFAULT_LOCK_NAME);
-    return;
-  }
-  int ret = ftruncate(orb_device_lock_shm_fd_, sizeof(pthread_mutex_t));
-  if (ret < 0) {
-    ROS_ERROR_STREAM("Failed to truncate shared memory " << ORB_DEFAULT_LOCK_NAME);
-    return;
-  }
-  orb_device_lock_shm_addr_ =
-      static_cast<uint8_t *>(mmap(NULL, sizeof(pthread_mutex_t), PROT_READ | PROT_WRITE, MAP_SHARED,
-                                  orb_device_lock_shm_fd_, 0));
-  if (orb_device_lock_shm_addr_ == MAP_FAILED) {
-    ROS_ERROR_STREAM("Failed to map shared memory " << ORB_DEFAULT_LOCK_NAME);
-    return;
-  }
-  pthread_mutexattr_init(&orb_device_lock_attr_);
-  pthread_mutexattr_setpshared(&orb_device_lock_attr_, PTHREAD_PROCESS_SHARED);
-  orb_device_lock_ = (pthread_mutex_t *)orb_device_lock_shm_addr_;
-  pthread_mutex_init(orb_device_lock_, &orb_device_lock_attr_);
-  serial_number_ = nh_private_.param<std::string>("serial_number", "");
-  usb_port_ = nh_private_.param<std::string>("usb_port", "");
-  connection_delay_ = nh_private_.param<int>("connection_delay", 100);
   device_num_ = static_cast<int>(nh_private_.param<int>("device_num", 1));
   auto enumerate_net_device_ =
       static_cast<int>(nh_private_.param<bool>("enumerate_net_device", false));
@@ -116,14 +117,37 @@ std::shared_ptr<ob::Device> OBCameraNodeDriver::selectDevice(
 
 std::shared_ptr<ob::Device> OBCameraNodeDriver::selectDeviceBySerialNumber(
     const std::shared_ptr<ob::DeviceList> &list, const std::string &serial_number) {
-  for (size_t i = 0; i < list->deviceCount(); i++) {
+  const auto start = std::chrono::steady_clock::now();
+  size_t opened = 0;
+  auto log_selection = [&]() {
+    ROS_INFO_STREAM("Selection by serial number took "
+                    << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                 start)
+                           .count()
+                    << " ms, opened " << opened << " of " << list->deviceCount() << " device(s)");
+  };
+  // UIDs whose cached serial number belongs to another device, only opened when nothing matched
+  std::vector<size_t> skipped;
+  std::vector<std::string> skipped_uids;
+  auto try_device = [&](size_t i, bool trust_cache) -> std::shared_ptr<ob::Device> {
     std::lock_guard<decltype(device_lock_)> lock(device_lock_);
     try {
       auto pid = list->pid(i);
       if (isOpenNIDevice(pid)) {
-        // openNI device
+        // openNI devices only report their serial number once opened, skip the ones known to
+        // be someone else's
+        std::string uid = list->uid(i);
+        std::string cached_serial_number;
+        if (trust_cache && serial_cache_.lookup(uid, cached_serial_number) &&
+            cached_serial_number != serial_number) {
+          skipped.push_back(i);
+          skipped_uids.push_back(uid);
+          return nullptr;
+        }
         auto dev = list->getDevice(i);
+        opened++;
         auto device_info = dev->getDeviceInfo();
+        serial_cache_.store(uid, device_info->serialNumber());
         if (device_info->serialNumber() == serial_number) {
           ROS_INFO_STREAM("Device serial number " << device_info->serialNumber() << " matched");
           return dev;
@@ -143,7 +167,43 @@ std::shared_ptr<ob::Device> OBCameraNodeDriver::selectDeviceBySerialNumber(
     } catch (...) {
       ROS_ERROR_STREAM("Failed to get device info");
     }
+    return nullptr;
+  };
+  for (size_t i = 0; i < list->deviceCount(); i++) {
+    auto device = try_device(i, true);
+    if (device) {
+      log_selection();
+      return device;
+    }
+  }
+  // a stale entry, e.g. devices swapped between ports, would hide the device for good. Each
+  // skipped UID is checked once per device change, not on every retry while the wanted device
+  // is unplugged, those opens would contend with the nodes owning them.
+  std::vector<size_t> unverified;
+  std::vector<std::string> unverified_uids;
+  {
+    std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+    for (size_t k = 0; k < skipped.size(); k++) {
+      if (verified_uids_.insert(skipped_uids[k]).second) {
+        unverified.push_back(skipped[k]);
+        unverified_uids.push_back(skipped_uids[k]);
+      }
+    }
+  }
+  if (!unverified.empty()) {
+    ROS_WARN_STREAM("Device serial number " << serial_number << " not found, opening "
+                                            << unverified.size()
+                                            << " device(s) skipped by the serial cache");
+    serial_cache_.erase(unverified_uids);
+    for (size_t i : unverified) {
+      auto device = try_device(i, false);
+      if (device) {
+        log_selection();
+        return device;
+      }
+    }
   }
+  log_selection();
   return nullptr;
 }
 
@@ -167,6 +227,48 @@ std::shared_ptr<ob::Device> OBCameraNodeDriver::selectDeviceByUSBPort(
   return nullptr;
 }
 
+std::shared_ptr<ob::Device> OBCameraNodeDriver::waitForDevice(
+    const std::shared_ptr<ob::DeviceList> &list) {
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + std::chrono::milliseconds(device_ready_timeout_);
+  int backoff_ms = 5;
+  for (int attempt = 1;; attempt++) {
+    try {
+      std::shared_ptr<ob::Device> device;
+      {
+        std::unique_lock<std::mutex> select_guard;
+        if (hosted_) {
+          // cameras of one process also take turns on the device list they share
+          select_guard = std::unique_lock<std::mutex>(*select_lock_);
+        }
+        device = selectDevice(list);
+      }
+      if (device == nullptr) {
+        return nullptr;
+      }
+      // a freshly enumerated device answers once its info and sensor list can be read
+      device->getDeviceInfo();
+      device->getSensorList();
+      ROS_INFO_STREAM("Device ready after "
+                      << attempt << " attempt(s), "
+                      << std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count()
+                      << " ms");
+      return device;
+    } catch (ob::Error &e) {
+      if (std::chrono::steady_clock::now() + std::chrono::milliseconds(backoff_ms) > deadline) {
+        ROS_ERROR_STREAM("Device not ready after " << attempt << " attempt(s)");
+        throw;
+      }
+      ROS_DEBUG_STREAM("Device not ready: " << e.getMessage() << ", retrying in " << backoff_ms
+                                            << " ms");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+    backoff_ms = std::min(backoff_ms * 2, 200);
+  }
+}
+
 void OBCameraNodeDriver::initializeDevice(const std::shared_ptr<ob::Device> &device) {
   std::lock_guard<decltype(device_lock_)> lock(device_lock_);
   if (device_) {
@@ -176,11 +278,26 @@ void OBCameraNodeDriver::initializeDevice(const std::shared_ptr<ob::Device> &dev
   device_ = device;
   device_info_ = device_->getDeviceInfo();
   device_uid_ = device_info_->uid();
+  serial_cache_.store(device_uid_, device_info_->serialNumber());
   CHECK_NOTNULL(device_.get());
-  if (ob_camera_node_) {
-    ob_camera_node_.reset();
+  bool attached = false;
+  if (ob_camera_node_ && warm_reconnect_) {
+    attached = ob_camera_node_->attachDevice(device_, device_enumerated_at_);
+    if (!attached) {
+      ROS_WARN_STREAM("Warm reconnect failed, rebuilding the camera node");
+    }
+  }
+  if (!attached) {
+    if (ob_camera_node_) {
+      ob_camera_node_.reset();
+    }
+    CameraNodeOptions options;
+    options.worker_pool = worker_pool_;
+    options.connect_latency = connect_latency_;
+    options.enumerated_at = device_enumerated_at_;
+    options.warm_reconnect = warm_reconnect_;
+    ob_camera_node_ = std::make_shared<OBCameraNode>(nh_, nh_private_, device_, options);
   }
-  ob_camera_node_ = std::make_shared<OBCameraNode>(nh_, nh_private_, device_);
   if (ob_camera_node_ && ob_camera_node_->isInitialized()) {
     device_connected_ = true;
   } else {
@@ -211,15 +328,16 @@ void OBCameraNodeDriver::deviceConnectCallback(const std::shared_ptr<ob::DeviceL
     return;
   }
   bool start_device_failed = false;
+  device_enumerated_at_ = std::chrono::steady_clock::now();
   try {
-    std::this_thread::sleep_for(std::chrono::milliseconds(connection_delay_));
-    ROS_INFO_STREAM("deviceConnectCallback : Before process lock lock");
-    pthread_mutex_lock(orb_device_lock_);
-    ROS_INFO_STREAM("deviceConnectCallback : After process lock lock");
-    std::shared_ptr<int> lock_guard(nullptr,
-                                    [this](int *) { pthread_mutex_unlock(orb_device_lock_); });
+    if (connection_delay_ > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(connection_delay_));
+    }
+    ROS_INFO_STREAM("deviceConnectCallback : Before device lock file lock");
+    auto lock_guard = lockDevice();
+    ROS_INFO_STREAM("deviceConnectCallback : After device lock file lock");
     ROS_INFO_STREAM("deviceConnectCallback : selectDevice start");
-    auto device = selectDevice(list);
+    auto device = waitForDevice(list);
     ROS_INFO_STREAM("deviceConnectCallback : selectDevice end");
     if (device == nullptr) {
       if (!serial_number_.empty()) {
@@ -256,6 +374,7 @@ void OBCameraNodeDriver::connectNetDevice(const std::string &ip_address, int por
     return;
   }
   ROS_INFO_STREAM("Connecting to net device " << ip_address << ":" << port);
+  device_enumerated_at_ = std::chrono::steady_clock::now();
   auto device = ctx_->createNetDevice(ip_address.c_str(), port);
   if (device == nullptr) {
     ROS_ERROR_STREAM("Failed to create net device");
@@ -280,6 +399,15 @@ void OBCameraNodeDriver::deviceDisconnectCallback(
     return;
   }
   ROS_INFO("Device disconnected");
+  std::vector<std::string> removed_uids;
+  for (size_t i = 0; i < device_list->deviceCount(); i++) {
+    removed_uids.emplace_back(device_list->uid(i));
+  }
+  serial_cache_.erase(removed_uids);
+  {
+    std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+    verified_uids_.clear();
+  }
   if (device_info_ != nullptr) {
     ROS_INFO_STREAM("current node serial " << device_info_->serialNumber());
   }
@@ -342,7 +470,12 @@ void OBCameraNodeDriver::resetDeviceThread() {
     ROS_INFO_STREAM("resetDeviceThread: device is disconnected, reset device start");
     {
       std::lock_guard<decltype(device_lock_)> device_lock(device_lock_);
-      ob_camera_node_.reset();
+      if (warm_reconnect_ && ob_camera_node_) {
+        // keep the ROS side alive, initializeDevice() re-attaches the device once it is back
+        ob_camera_node_->detachDevice();
+      } else {
+        ob_camera_node_.reset();
+      }
       ROS_INFO_STREAM("resetDeviceThread: device is disconnected, reset device");
       device_.reset();
       device_info_.reset();
@@ -354,6 +487,50 @@ void OBCameraNodeDriver::resetDeviceThread() {
   }
 }
 
+std::string OBCameraNodeDriver::deviceLockPath() const {
+  std::string key = serial_number_.empty() ? usb_port_ : serial_number_;
+  if (device_num_ == 1 || key.empty()) {
+    // selectDevice() takes the first device
+    key = "default";
+  }
+  for (auto &c : key) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '.' && c != '_') {
+      c = '_';
+    }
+  }
+  return ORB_DEVICE_LOCK_PREFIX + key + ".lock";
+}
+
+std::shared_ptr<int> OBCameraNodeDriver::lockDevice() {
+  // one lock file per device: nodes that start different cameras no longer wait for each other,
+  // and the kernel drops an flock() when its holder dies, so a crashed node blocks nobody
+  const auto path = deviceLockPath();
+  int fd = open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0666);
+  if (fd < 0) {
+    ROS_WARN_STREAM("Failed to open device lock " << path << ": " << strerror(errno));
+    return nullptr;
+  }
+  // nodes of other users have to be able to open it as well, umask may have dropped the bits
+  (void)fchmod(fd, 0666);
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    ROS_INFO_STREAM("Device lock " << path << " is held by another node, waiting");
+    int ret = 0;
+    do {
+      ret = flock(fd, LOCK_EX);
+    } while (ret != 0 && errno == EINTR);
+    if (ret != 0) {
+      ROS_WARN_STREAM("Failed to lock " << path << ": " << strerror(errno));
+      close(fd);
+      return nullptr;
+    }
+  }
+  return std::shared_ptr<int>(new int(fd), [](int *lock_fd) {
+    flock(*lock_fd, LOCK_UN);
+    close(*lock_fd);
+    delete lock_fd;
+  });
+}
+
 std::string OBCameraNodeDriver::parseUsbPort(const std::string &line) {
   std::string port_id;
   std::regex self_regex("(?:[^ ]+/usb[0-9]+[0-9./-]*/){0,1}([0-9.-]+)(:){0,1}[^ ]*",
@@ -0,0 +1,176 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/ob_multi_camera_driver.h"
+#include <ros/package.h>
+#include <algorithm>
+#include <map>
+
+namespace orbbec_camera {
+OBMultiCameraDriver::OBMultiCameraDriver(ros::NodeHandle &nh, ros::NodeHandle &nh_private)
+    : nh_(nh),
+      nh_private_(nh_private),
+      config_path_(ros::package::getPath("orbbec_camera") + "/config/OrbbecSDKConfig_v1.0.xml") {
+  shared_.ctx = std::make_shared<ob::Context>(config_path_.c_str());
+  init();
+}
+
+OBMultiCameraDriver::~OBMultiCameraDriver() {
+  {
+    std::lock_guard<std::mutex> lock(query_lock_);
+    is_alive_ = false;
+  }
+  query_cv_.notify_all();
+  if (query_thread_ && query_thread_->joinable()) {
+    query_thread_->join();
+  }
+  std::lock_guard<std::mutex> lock(connect_lock_);
+  drivers_.clear();
+}
+
+bool OBMultiCameraDriver::isConfigured(const ros::NodeHandle &nh_private) {
+  std::vector<std::string> cameras;
+  return nh_private.getParam("cameras", cameras) && !cameras.empty();
+}
+
+void OBMultiCameraDriver::init() {
+  is_alive_ = true;
+  auto log_level = nh_private_.param<std::string>("log_level", "info");
+  shared_.ctx->setLoggerToConsole(OBCameraNodeDriver::obLogSeverityFromString(log_level));
+  nh_private_.getParam("cameras", camera_names_);
+  int worker_threads = nh_private_.param<int>("worker_threads", THREAD_NUM);
+  shared_.select_lock = std::make_shared<std::mutex>();
+  shared_.worker_pool = std::make_shared<WorkerPool>(worker_threads > 1 ? worker_threads - 1 : 0);
+  shared_.device_num = static_cast<int>(camera_names_.size());
+  shareLinkBudget();
+  for (const auto &name : camera_names_) {
+    ros::NodeHandle camera_nh(nh_, name);
+    ros::NodeHandle camera_nh_private(nh_private_, name);
+    if (camera_names_.size() > 1 && !camera_nh_private.hasParam("serial_number") &&
+        !camera_nh_private.hasParam("usb_port")) {
+      ROS_ERROR_STREAM("Camera " << name << " has neither " << camera_nh_private.getNamespace()
+                                 << "/serial_number nor usb_port set, skipping it");
+      continue;
+    }
+    // frame ids are derived from camera_name, keep them apart by default
+    if (!camera_nh_private.hasParam("camera_name")) {
+      camera_nh_private.setParam("camera_name", name);
+    }
+    drivers_.push_back(
+        std::make_shared<OBCameraNodeDriver>(camera_nh, camera_nh_private, shared_));
+  }
+  ROS_INFO_STREAM("Hosting " << drivers_.size() << " camera(s) on one context, "
+                             << shared_.worker_pool->size() << " shared worker thread(s)");
+  shared_.ctx->setDeviceChangedCallback([this](const std::shared_ptr<ob::DeviceList> &removed_list,
+                                               const std::shared_ptr<ob::DeviceList> &added_list) {
+    if (!is_alive_) {
+      return;
+    }
+    connectCameras(added_list);
+    std::lock_guard<std::mutex> lock(connect_lock_);
+    for (const auto &driver : drivers_) {
+      driver->deviceDisconnectCallback(removed_list);
+    }
+  });
+  query_thread_ = std::make_shared<std::thread>([this]() { queryDevices(); });
+}
+
+void OBMultiCameraDriver::shareLinkBudget() {
+  // the bus of 2-1.2.1 is 2, a camera picked by serial number may sit on any bus
+  std::map<std::string, std::string> bus_of;
+  std::map<std::string, int> cameras_on_bus;
+  int unknown_bus = 0;
+  for (const auto &name : camera_names_) {
+    ros::NodeHandle camera_nh_private(nh_private_, name);
+    std::string usb_port;
+    if (camera_nh_private.hasParam("serial_number") ||
+        !camera_nh_private.getParam("usb_port", usb_port) || usb_port.empty()) {
+      unknown_bus++;
+      continue;
+    }
+    bus_of[name] = usb_port.substr(0, usb_port.find('-'));
+    cameras_on_bus[bus_of[name]]++;
+  }
+  for (const auto &name : camera_names_) {
+    ros::NodeHandle camera_nh_private(nh_private_, name);
+    if (camera_nh_private.hasParam("bandwidth_budget")) {
+      continue;
+    }
+    auto it = bus_of.find(name);
+    int sharing = it == bus_of.end() ? static_cast<int>(camera_names_.size())
+                                     : cameras_on_bus[it->second] + unknown_bus;
+    // always written, a share left on the parameter server by an earlier launch is replaced
+    camera_nh_private.setParam("bandwidth_share", 1.0 / std::max(sharing, 1));
+    if (sharing > 1) {
+      ROS_INFO_STREAM("Camera " << name << " gets 1/" << sharing << " of its link budget");
+    }
+  }
+}
+
+void OBMultiCameraDriver::connectCameras(const std::shared_ptr<ob::DeviceList> &list) {
+  CHECK_NOTNULL(list.get());
+  if (list->deviceCount() == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(connect_lock_);
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (const auto &driver : drivers_) {
+    if (driver->isDeviceConnected()) {
+      continue;
+    }
+    threads.emplace_back([driver, list]() { driver->deviceConnectCallback(list); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  if (threads.empty()) {
+    return;
+  }
+  auto connected = std::count_if(drivers_.begin(), drivers_.end(),
+                                 [](const std::shared_ptr<OBCameraNodeDriver> &driver) {
+                                   return driver->isDeviceConnected();
+                                 });
+  ROS_INFO_STREAM("Started " << threads.size() << " camera(s) in parallel in "
+                             << std::chrono::duration<double, std::milli>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count()
+                             << " ms, " << connected << "/" << drivers_.size() << " connected");
+}
+
+bool OBMultiCameraDriver::allConnected() const {
+  return std::all_of(drivers_.begin(), drivers_.end(),
+                     [](const std::shared_ptr<OBCameraNodeDriver> &driver) {
+                       return driver->isDeviceConnected();
+                     });
+}
+
+void OBMultiCameraDriver::queryDevices() {
+  // hot plugged devices arrive through the device callback, this only covers devices that were
+  // already present and retries the ones that failed to start
+  while (is_alive_ && ros::ok() && !allConnected()) {
+    auto list = shared_.ctx->queryDeviceList();
+    CHECK_NOTNULL(list.get());
+    if (list->deviceCount() == 0) {
+      ROS_WARN_STREAM("No device found, using callback to wait for devices");
+      return;
+    }
+    connectCameras(list);
+    std::unique_lock<std::mutex> lock(query_lock_);
+    query_cv_.wait_for(lock, std::chrono::seconds(1), [this]() { return !is_alive_; });
+  }
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,209 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/plane_segmenter.h"
+
+#include <eigen3/Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace orbbec_camera {
+namespace {
+inline void readPoint(const uint8_t *point, float xyz[3]) { std::memcpy(xyz, point, 3 * 4); }
+
+inline float planeDistance(const float plane[4], const float xyz[3]) {
+  return plane[0] * xyz[0] + plane[1] * xyz[1] + plane[2] * xyz[2] + plane[3];
+}
+}  // namespace
+
+PlaneSegmenter::PlaneSegmenter(int num_threads)
+    : PlaneSegmenter(std::make_shared<WorkerPool>(num_threads > 1 ? num_threads - 1 : 0)) {}
+
+PlaneSegmenter::PlaneSegmenter(std::shared_ptr<WorkerPool> pool)
+    : random_(5489u), pool_(std::move(pool)) {
+  chunk_counts_.resize(pool_->size());
+}
+
+void PlaneSegmenter::setConfig(const Config &config) {
+  config_ = config;
+  config_.distance_threshold = std::max(config_.distance_threshold, 1e-4);
+  config_.max_iterations = std::max(config_.max_iterations, 1);
+  config_.max_samples = std::max(config_.max_samples, 3);
+  has_previous_ = false;
+}
+
+size_t PlaneSegmenter::countInliers(const float plane[4]) const {
+  const float threshold = static_cast<float>(config_.distance_threshold);
+  size_t inliers = 0;
+  for (size_t i = 0; i < samples_.size(); i += 3) {
+    inliers += std::fabs(planeDistance(plane, &samples_[i])) <= threshold;
+  }
+  return inliers;
+}
+
+bool PlaneSegmenter::refine(float plane[4]) const {
+  // least squares plane through the inliers: normal of least variance around their centroid
+  const float threshold = static_cast<float>(config_.distance_threshold);
+  Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d products = Eigen::Matrix3d::Zero();
+  size_t count = 0;
+  for (size_t i = 0; i < samples_.size(); i += 3) {
+    const float *p = &samples_[i];
+    if (std::fabs(planeDistance(plane, p)) > threshold) {
+      continue;
+    }
+    Eigen::Vector3d point(p[0], p[1], p[2]);
+    sum += point;
+    products += point * point.transpose();
+    count++;
+  }
+  if (count < 3) {
+    return false;
+  }
+  Eigen::Vector3d centroid = sum / static_cast<double>(count);
+  Eigen::Matrix3d covariance =
+      products / static_cast<double>(count) - centroid * centroid.transpose();
+  // eigenvalues come sorted in increasing order
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+  if (solver.info() != Eigen::Success) {
+    return false;
+  }
+  Eigen::Vector3d normal = solver.eigenvectors().col(0).normalized();
+  for (int j = 0; j < 3; j++) {
+    plane[j] = static_cast<float>(normal[j]);
+  }
+  plane[3] = static_cast<float>(-normal.dot(centroid));
+  return true;
+}
+
+bool PlaneSegmenter::fit(const uint8_t *points, uint32_t point_step, size_t count) {
+  samples_.clear();
+  if (points == nullptr || count == 0) {
+    has_previous_ = false;
+    return false;
+  }
+  const size_t stride = std::max<size_t>(1, count / static_cast<size_t>(config_.max_samples));
+  samples_.reserve(static_cast<size_t>(config_.max_samples) * 3 + 3);
+  for (size_t i = 0; i < count; i += stride) {
+    float xyz[3];
+    readPoint(points + i * point_step, xyz);
+    if (std::isfinite(xyz[0]) && std::isfinite(xyz[1]) && std::isfinite(xyz[2])) {
+      samples_.insert(samples_.end(), xyz, xyz + 3);
+    }
+  }
+  const size_t sample_count = samples_.size() / 3;
+  if (sample_count < 3) {
+    has_previous_ = false;
+    return false;
+  }
+
+  float best[4] = {0, 0, 0, 0};
+  size_t best_inliers = 0;
+  int iterations = config_.max_iterations;
+  if (has_previous_) {
+    std::copy(plane_, plane_ + 4, best);
+    best_inliers = countInliers(best);
+    // the floor rarely moves between frames, a plane that still holds needs little searching
+    if (best_inliers >= config_.min_inlier_ratio * sample_count) {
+      iterations = std::max(1, iterations / 4);
+    }
+  }
+  std::uniform_int_distribution<size_t> pick(0, sample_count - 1);
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    const float *a = &samples_[pick(random_) * 3];
+    const float *b = &samples_[pick(random_) * 3];
+    const float *c = &samples_[pick(random_) * 3];
+    const float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    float candidate[4] = {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2],
+                          ab[0] * ac[1] - ab[1] * ac[0], 0};
+    const float norm = std::sqrt(candidate[0] * candidate[0] + candidate[1] * candidate[1] +
+                                 candidate[2] * candidate[2]);
+    if (norm < 1e-9f) {
+      continue;  // collinear or repeated samples
+    }
+    for (int j = 0; j < 3; j++) {
+      candidate[j] /= norm;
+    }
+    candidate[3] = -(candidate[0] * a[0] + candidate[1] * a[1] + candidate[2] * a[2]);
+    const size_t inliers = countInliers(candidate);
+    if (inliers > best_inliers) {
+      best_inliers = inliers;
+      std::copy(candidate, candidate + 4, best);
+    }
+  }
+  if (best_inliers < config_.min_inlier_ratio * sample_count || !refine(best)) {
+    has_previous_ = false;
+    inlier_ratio_ = static_cast<float>(best_inliers) / sample_count;
+    return false;
+  }
+  if (planeDistance(best, viewpoint_) < 0) {
+    for (float &value : best) {
+      value = -value;
+    }
+  }
+  std::copy(best, best + 4, plane_);
+  inlier_ratio_ = static_cast<float>(countInliers(plane_)) / sample_count;
+  has_previous_ = true;
+  return true;
+}
+
+size_t PlaneSegmenter::removePlane(const uint8_t *points, uint32_t point_step, size_t count,
+                                  bool keep_organized, uint8_t *output) {
+  const float threshold = static_cast<float>(config_.distance_threshold);
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float invalid[3] = {nan, nan, nan};
+  const int chunk_count = static_cast<int>(chunk_counts_.size());
+  const size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+  // every chunk writes from its own start, unorganized output is compacted afterwards
+  pool_->parallelFor(0, chunk_count, [&](int chunk_begin, int chunk_end) {
+    for (int chunk = chunk_begin; chunk < chunk_end; chunk++) {
+      const size_t begin = std::min(count, chunk * chunk_size);
+      const size_t end = std::min(count, begin + chunk_size);
+      uint8_t *dest = output + begin * point_step;
+      for (size_t i = begin; i < end; i++) {
+        const uint8_t *point = points + i * point_step;
+        float xyz[3];
+        readPoint(point, xyz);
+        // NaN points fail the test too, so they are only kept in an organized cloud
+        const bool off_plane = std::fabs(planeDistance(plane_, xyz)) > threshold;
+        if (off_plane) {
+          std::memcpy(dest, point, point_step);
+          dest += point_step;
+        } else if (keep_organized) {
+          std::memcpy(dest, point, point_step);
+          std::memcpy(dest, invalid, sizeof(invalid));
+          dest += point_step;
+        }
+      }
+      chunk_counts_[chunk] = (dest - (output + begin * point_step)) / point_step;
+    }
+  });
+  if (keep_organized) {
+    return count;
+  }
+  size_t written = chunk_counts_[0];
+  for (int chunk = 1; chunk < chunk_count; chunk++) {
+    const size_t begin = std::min(count, chunk * chunk_size);
+    std::memmove(output + written * point_step, output + begin * point_step,
+                 chunk_counts_[chunk] * point_step);
+    written += chunk_counts_[chunk];
+  }
+  return written;
+}
+}  // namespace orbbec_camera
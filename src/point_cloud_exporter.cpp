@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/point_cloud_exporter.h"
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include "ros/ros.h"
+
+namespace orbbec_camera {
+namespace {
+struct CloudFields {
+  int x = -1, y = -1, z = -1, rgb = -1;
+  uint8_t xyz_type = 0;
+};
+
+CloudFields findCloudFields(const sensor_msgs::PointCloud2 &msg) {
+  CloudFields fields;
+  for (const auto &field : msg.fields) {
+    const int offset = static_cast<int>(field.offset);
+    if (field.name == "x") {
+      fields.x = offset;
+      fields.xyz_type = field.datatype;
+    } else if (field.name == "y") {
+      fields.y = offset;
+    } else if (field.name == "z") {
+      fields.z = offset;
+    } else if (field.name == "rgb" || field.name == "rgba") {
+      fields.rgb = offset;
+    }
+  }
+  if (fields.x < 0 || fields.y < 0 || fields.z < 0) {
+    throw std::runtime_error("point cloud has no x/y/z fields");
+  }
+  if (fields.xyz_type != sensor_msgs::PointField::FLOAT32 &&
+      fields.xyz_type != sensor_msgs::PointField::INT16) {
+    throw std::runtime_error("unsupported point cloud x/y/z datatype");
+  }
+  return fields;
+}
+}  // namespace
+
+PointCloudFileFormat pointCloudFileFormatFromString(const std::string &format) {
+  std::string lower_format;
+  std::transform(format.begin(), format.end(), std::back_inserter(lower_format),
+                 [](const char ch) { return std::tolower(ch); });
+  if (lower_format == "pcd") {
+    return PointCloudFileFormat::PCD;
+  } else if (lower_format != "ply" && !lower_format.empty()) {
+    ROS_ERROR_STREAM("Unknown point cloud file format " << format << ", using ply");
+  }
+  return PointCloudFileFormat::PLY;
+}
+
+PointCloudExporter::PointCloudExporter(PointCloudFileFormat format) : format_(format) {}
+
+std::string PointCloudExporter::extension() const {
+  return format_ == PointCloudFileFormat::PCD ? ".pcd" : ".ply";
+}
+
+double PointCloudExporter::averageThroughput() const {
+  return total_seconds_ > 0 ? total_bytes_ / (1024.0 * 1024.0) / total_seconds_ : 0.0;
+}
+
+std::string PointCloudExporter::header(size_t valid_count, bool with_color) const {
+  std::ostringstream ss;
+  if (format_ == PointCloudFileFormat::PCD) {
+    ss << "# .PCD v0.7 - Point Cloud Data file format\n";
+    ss << "VERSION 0.7\n";
+    ss << (with_color ? "FIELDS x y z rgb\n" : "FIELDS x y z\n");
+    ss << (with_color ? "SIZE 4 4 4 4\n" : "SIZE 4 4 4\n");
+    ss << (with_color ? "TYPE F F F F\n" : "TYPE F F F\n");
+    ss << (with_color ? "COUNT 1 1 1 1\n" : "COUNT 1 1 1\n");
+    ss << "WIDTH " << valid_count << "\n";
+    ss << "HEIGHT 1\n";
+    ss << "VIEWPOINT 0 0 0 1 0 0 0\n";
+    ss << "POINTS " << valid_count << "\n";
+    ss << "DATA binary\n";
+  } else {
+    ss << "ply\n";
+    ss << "format binary_little_endian 1.0\n";
+    ss << "element vertex " << valid_count << "\n";
+    ss << "property float x\n";
+    ss << "property float y\n";
+    ss << "property float z\n";
+    if (with_color) {
+      ss << "property uchar red\n";
+      ss << "property uchar green\n";
+      ss << "property uchar blue\n";
+    }
+    ss << "end_header\n";
+  }
+  return ss.str();
+}
+
+template <typename Getter>
+size_t PointCloudExporter::write(size_t count, bool with_color, Getter get_point,
+                                 const std::string &filename) {
+  const auto start = std::chrono::steady_clock::now();
+  const bool pcd = format_ == PointCloudFileFormat::PCD;
+  // PLY stores red/green/blue as three uchars, PCD as one packed float "rgb"
+  const size_t record_size = 3 * sizeof(float) + (with_color ? (pcd ? 4 : 3) : 0);
+  body_.resize(count * record_size);
+  uint8_t *out = body_.data();
+  size_t valid_count = 0;
+  float xyz[3];
+  uint8_t rgb[3] = {0, 0, 0};
+  for (size_t i = 0; i < count; i++) {
+    if (!get_point(i, xyz, rgb)) {
+      continue;
+    }
+    std::memcpy(out, xyz, sizeof(xyz));
+    out += sizeof(xyz);
+    if (with_color && pcd) {
+      const uint32_t packed = (static_cast<uint32_t>(rgb[0]) << 16) |
+                              (static_cast<uint32_t>(rgb[1]) << 8) | rgb[2];
+      std::memcpy(out, &packed, sizeof(packed));
+      out += sizeof(packed);
+    } else if (with_color) {
+      std::memcpy(out, rgb, sizeof(rgb));
+      out += sizeof(rgb);
+    }
+    ++valid_count;
+  }
+  const std::string file_header = header(valid_count, with_color);
+  const size_t body_size = valid_count * record_size;
+  writeFile(filename, file_header, body_size);
+
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const size_t bytes = file_header.size() + body_size;
+  last_throughput_ = seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+  total_bytes_ += bytes;
+  total_seconds_ += seconds;
+  return valid_count;
+}
+
+void PointCloudExporter::writeFile(const std::string &filename, const std::string &header,
+                                   size_t body_size) {
+  int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("failed to open " + filename + ": " + std::strerror(errno));
+  }
+  struct iovec iov[2];
+  iov[0].iov_base = const_cast<char *>(header.data());
+  iov[0].iov_len = header.size();
+  iov[1].iov_base = body_.data();
+  iov[1].iov_len = body_size;
+  int iov_index = 0;
+  while (iov_index < 2) {
+    ssize_t written = ::writev(fd, iov + iov_index, 2 - iov_index);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      const std::string error = std::strerror(errno);
+      ::close(fd);
+      throw std::runtime_error("failed to write " + filename + ": " + error);
+    }
+    // short write, advance the iovecs past what the kernel took
+    auto remaining = static_cast<size_t>(written);
+    while (iov_index < 2 && remaining >= iov[iov_index].iov_len) {
+      remaining -= iov[iov_index].iov_len;
+      ++iov_index;
+    }
+    if (iov_index < 2) {
+      iov[iov_index].iov_base = static_cast<uint8_t *>(iov[iov_index].iov_base) + remaining;
+      iov[iov_index].iov_len -= remaining;
+    }
+  }
+  if (::close(fd) != 0) {
+    throw std::runtime_error("failed to close " + filename + ": " + std::strerror(errno));
+  }
+}
+
+size_t PointCloudExporter::exportCloud(const sensor_msgs::PointCloud2 &msg,
+                                       const std::string &filename) {
+  const CloudFields fields = findCloudFields(msg);
+  const bool with_color = fields.rgb >= 0;
+  const size_t count = static_cast<size_t>(msg.width) * msg.height;
+  const uint32_t point_step = msg.point_step;
+  const uint8_t *data = msg.data.data();
+  if (msg.data.size() < count * point_step) {
+    throw std::runtime_error("point cloud data is smaller than width * height * point_step");
+  }
+  auto read_rgb = [&](const uint8_t *point, uint8_t rgb[3]) {
+    if (with_color) {
+      uint32_t packed;
+      std::memcpy(&packed, point + fields.rgb, sizeof(packed));
+      rgb[0] = static_cast<uint8_t>(packed >> 16);
+      rgb[1] = static_cast<uint8_t>(packed >> 8);
+      rgb[2] = static_cast<uint8_t>(packed);
+    }
+  };
+  if (fields.xyz_type == sensor_msgs::PointField::INT16) {
+    return write(
+        count, with_color,
+        [&](size_t i, float xyz[3], uint8_t rgb[3]) {
+          const uint8_t *point = data + i * point_step;
+          int16_t x, y, z;
+          std::memcpy(&x, point + fields.x, sizeof(x));
+          std::memcpy(&y, point + fields.y, sizeof(y));
+          std::memcpy(&z, point + fields.z, sizeof(z));
+          if (x == 0 && y == 0 && z == 0) {
+            return false;
+          }
+          xyz[0] = x * 0.001f;
+          xyz[1] = y * 0.001f;
+          xyz[2] = z * 0.001f;
+          read_rgb(point, rgb);
+          return true;
+        },
+        filename);
+  }
+  return write(
+      count, with_color,
+      [&](size_t i, float xyz[3], uint8_t rgb[3]) {
+        const uint8_t *point = data + i * point_step;
+        std::memcpy(&xyz[0], point + fields.x, sizeof(float));
+        std::memcpy(&xyz[1], point + fields.y, sizeof(float));
+        std::memcpy(&xyz[2], point + fields.z, sizeof(float));
+        if (std::isnan(xyz[0]) || std::isnan(xyz[1]) || std::isnan(xyz[2])) {
+          return false;
+        }
+        read_rgb(point, rgb);
+        return true;
+      },
+      filename);
+}
+
+size_t PointCloudExporter::exportPoints(const OBPoint *points, size_t count,
+                                        const std::string &filename) {
+  return write(
+      count, false,
+      [&](size_t i, float xyz[3], uint8_t *) {
+        xyz[0] = points[i].x;
+        xyz[1] = points[i].y;
+        xyz[2] = points[i].z;
+        return true;
+      },
+      filename);
+}
+
+size_t PointCloudExporter::exportPoints(const OBColorPoint *points, size_t count,
+                                        const std::string &filename) {
+  return write(
+      count, true,
+      [&](size_t i, float xyz[3], uint8_t rgb[3]) {
+        xyz[0] = points[i].x;
+        xyz[1] = points[i].y;
+        xyz[2] = points[i].z;
+        rgb[0] = static_cast<uint8_t>(points[i].r);
+        rgb[1] = static_cast<uint8_t>(points[i].g);
+        rgb[2] = static_cast<uint8_t>(points[i].b);
+        return true;
+      },
+      filename);
+}
+
+void PointCloudExporter::startSequence(const std::string &prefix) {
+  sequence_prefix_ = prefix;
+  sequence_ = 0;
+}
+
+std::string PointCloudExporter::exportNext(const sensor_msgs::PointCloud2 &msg) {
+  std::ostringstream ss;
+  ss << sequence_prefix_ << "_" << std::setw(6) << std::setfill('0') << sequence_++
+     << extension();
+  exportCloud(msg, ss.str());
+  return ss.str();
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,238 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/profile_planner.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace orbbec_camera {
+namespace {
+struct Option {
+  int candidate;
+  double mb_per_s;
+};
+
+bool matches(const ProfilePlanner::Profile &requested, const ProfilePlanner::Profile &candidate) {
+  return (requested.width == 0 || requested.width == candidate.width) &&
+         (requested.height == 0 || requested.height == candidate.height) &&
+         (requested.fps == 0 || requested.fps == candidate.fps) &&
+         (requested.format == OB_FORMAT_UNKNOWN || requested.format == candidate.format);
+}
+
+uint64_t pixels(const ProfilePlanner::Profile &profile) {
+  return static_cast<uint64_t>(profile.width) * profile.height;
+}
+
+// The stream's candidates in fidelity order, best match first. Options above the requested
+// resolution or rate only follow when nothing at or below it is offered.
+std::vector<Option> rankOptions(const ProfilePlanner::Stream &stream, bool &exact) {
+  const auto &candidates = stream.candidates;
+  // wildcards take the first candidate matching the given fields, like the SDK lookup does
+  int first_match = -1;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (matches(stream.requested, candidates[i])) {
+      first_match = static_cast<int>(i);
+      break;
+    }
+  }
+  exact = first_match >= 0;
+  const auto &base = candidates[exact ? first_match : 0];
+  ProfilePlanner::Profile reference = stream.requested;
+  reference.width = reference.width ? reference.width : base.width;
+  reference.height = reference.height ? reference.height : base.height;
+  reference.fps = reference.fps ? reference.fps : base.fps;
+  reference.format = reference.format != OB_FORMAT_UNKNOWN ? reference.format : base.format;
+
+  auto format_rank = [&](OBFormat format) {
+    if (format == reference.format) {
+      return 0;
+    }
+    auto it = std::find(stream.fallback_formats.begin(), stream.fallback_formats.end(), format);
+    return it == stream.fallback_formats.end()
+               ? -1
+               : 1 + static_cast<int>(it - stream.fallback_formats.begin());
+  };
+  auto same_aspect = [&](const ProfilePlanner::Profile &profile) {
+    return static_cast<uint64_t>(profile.width) * reference.height ==
+           static_cast<uint64_t>(profile.height) * reference.width;
+  };
+  bool any_format = std::none_of(
+      candidates.begin(), candidates.end(),
+      [&](const ProfilePlanner::Profile &profile) { return format_rank(profile.format) >= 0; });
+  auto allowed = [&](const ProfilePlanner::Profile &profile) {
+    return any_format || format_rank(profile.format) >= 0;
+  };
+  // alignment and calibration lookup go by aspect ratio, only change it when there is no choice
+  bool keep_aspect = false;
+  for (const auto &profile : candidates) {
+    keep_aspect = keep_aspect || (allowed(profile) && same_aspect(profile));
+  }
+
+  std::vector<int> indices;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (allowed(candidates[i]) && (!keep_aspect || same_aspect(candidates[i]))) {
+      indices.push_back(static_cast<int>(i));
+    }
+  }
+  auto rank = [&](OBFormat format) {
+    int value = format_rank(format);
+    return value < 0 ? static_cast<int>(stream.fallback_formats.size()) + 1 : value;
+  };
+  auto over = [&](const ProfilePlanner::Profile &profile) {
+    return pixels(profile) > pixels(reference) || profile.fps > reference.fps;
+  };
+  std::stable_sort(indices.begin(), indices.end(), [&](int lhs, int rhs) {
+    const auto &a = candidates[lhs];
+    const auto &b = candidates[rhs];
+    if (over(a) != over(b)) {
+      return !over(a);
+    }
+    if (pixels(a) != pixels(b)) {
+      return over(a) ? pixels(a) < pixels(b) : pixels(a) > pixels(b);
+    }
+    if (a.fps != b.fps) {
+      return over(a) ? a.fps < b.fps : a.fps > b.fps;
+    }
+    return rank(a.format) < rank(b.format);
+  });
+  std::vector<Option> options;
+  options.reserve(indices.size());
+  for (int index : indices) {
+    options.push_back(Option{index, ProfilePlanner::bandwidth(candidates[index])});
+  }
+  return options;
+}
+}  // namespace
+
+double ProfilePlanner::bytesPerPixel(OBFormat format) {
+  switch (format) {
+    case OB_FORMAT_Y8:
+    case OB_FORMAT_BA81:
+      return 1.0;
+    case OB_FORMAT_Y10:
+      return 1.25;
+    case OB_FORMAT_Y11:
+      return 1.375;
+    case OB_FORMAT_Y12:
+    case OB_FORMAT_YV12:
+    case OB_FORMAT_NV12:
+    case OB_FORMAT_NV21:
+    case OB_FORMAT_I420:
+      return 1.5;
+    case OB_FORMAT_Y14:
+      return 1.75;
+    case OB_FORMAT_RGB:
+    case OB_FORMAT_BGR:
+      return 3.0;
+    case OB_FORMAT_RGBA:
+    case OB_FORMAT_BGRA:
+      return 4.0;
+    case OB_FORMAT_MJPG:
+      return 0.5;  // roughly a quarter of YUYV for camera images
+    case OB_FORMAT_H264:
+    case OB_FORMAT_H265:
+    case OB_FORMAT_HEVC:
+      return 0.1;
+    case OB_FORMAT_RLE:
+    case OB_FORMAT_RVL:
+    case OB_FORMAT_COMPRESSED:
+      return 1.0;
+    default:
+      return 2.0;  // YUYV, UYVY, Y16 and the other 16 bit formats
+  }
+}
+
+double ProfilePlanner::bandwidth(const Profile &profile) {
+  return static_cast<double>(pixels(profile)) * bytesPerPixel(profile.format) * profile.fps /
+         1e6;
+}
+
+double ProfilePlanner::linkBudget(const std::string &connection_type) {
+  std::string type;
+  for (char ch : connection_type) {
+    if (std::isalnum(static_cast<unsigned char>(ch))) {
+      type.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
+    }
+  }
+  // what a UVC camera gets in practice, well below the signalling rate
+  if (type.compare(0, 4, "USB1") == 0) {
+    return 1.0;
+  } else if (type.compare(0, 4, "USB2") == 0) {
+    return 35.0;
+  } else if (type.compare(0, 4, "USB3") == 0) {
+    return 400.0;
+  } else if (type == "ETHERNET") {
+    return 110.0;
+  }
+  return 0.0;
+}
+
+ProfilePlanner::Plan ProfilePlanner::plan(const std::vector<Stream> &streams,
+                                          double budget_mb_per_s) {
+  Plan plan;
+  plan.budget_mb_per_s = budget_mb_per_s;
+  plan.choices.resize(streams.size());
+  std::vector<std::vector<Option>> options(streams.size());
+  std::vector<size_t> position(streams.size(), 0);
+  for (size_t i = 0; i < streams.size(); i++) {
+    if (streams[i].candidates.empty()) {
+      continue;
+    }
+    options[i] = rankOptions(streams[i], plan.choices[i].exact);
+    if (streams[i].counted && !options[i].empty()) {
+      plan.total_mb_per_s += options[i][0].mb_per_s;
+    }
+  }
+  while (budget_mb_per_s > 0.0 && plan.total_mb_per_s > budget_mb_per_s) {
+    int heaviest = -1;
+    size_t next = 0;
+    for (size_t i = 0; i < streams.size(); i++) {
+      if (!streams[i].counted || options[i].empty()) {
+        continue;
+      }
+      double current = options[i][position[i]].mb_per_s;
+      if (heaviest >= 0 && current <= options[heaviest][position[heaviest]].mb_per_s) {
+        continue;
+      }
+      for (size_t j = position[i] + 1; j < options[i].size(); j++) {
+        if (options[i][j].mb_per_s < current) {
+          heaviest = static_cast<int>(i);
+          next = j;
+          break;
+        }
+      }
+    }
+    if (heaviest < 0) {
+      break;
+    }
+    plan.total_mb_per_s += options[heaviest][next].mb_per_s -
+                           options[heaviest][position[heaviest]].mb_per_s;
+    position[heaviest] = next;
+  }
+  for (size_t i = 0; i < streams.size(); i++) {
+    if (options[i].empty()) {
+      continue;
+    }
+    auto &choice = plan.choices[i];
+    choice.candidate = options[i][position[i]].candidate;
+    choice.degraded = position[i] > 0;
+    choice.mb_per_s = options[i][position[i]].mb_per_s;
+  }
+  plan.fits = budget_mb_per_s <= 0.0 || plan.total_mb_per_s <= budget_mb_per_s;
+  return plan;
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/proximity_monitor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+namespace orbbec_camera {
+bool ProximityMonitor::parseRegions(const std::string &spec, std::vector<Region> &regions,
+                                    std::string &error) {
+  regions.clear();
+  std::stringstream entries(spec);
+  std::string entry;
+  while (std::getline(entries, entry, ';')) {
+    entry.erase(std::remove_if(entry.begin(), entry.end(), ::isspace), entry.end());
+    if (entry.empty()) {
+      continue;
+    }
+    auto colon = entry.find(':');
+    if (colon == std::string::npos || colon == 0) {
+      error = "missing region name in \"" + entry + "\"";
+      return false;
+    }
+    Region region;
+    region.name = entry.substr(0, colon);
+    std::stringstream values(entry.substr(colon + 1));
+    std::string value;
+    float bounds[6];
+    int count = 0;
+    while (std::getline(values, value, ',')) {
+      if (count == 6) {
+        count++;
+        break;
+      }
+      char *end = nullptr;
+      bounds[count] = std::strtof(value.c_str(), &end);
+      if (value.empty() || *end != '\0') {
+        error = "invalid number \"" + value + "\" in region " + region.name;
+        return false;
+      }
+      count++;
+    }
+    if (count != 6) {
+      error = "region " + region.name + " needs 6 values";
+      return false;
+    }
+    for (int i = 0; i < 3; i++) {
+      region.min[i] = std::min(bounds[i], bounds[i + 3]);
+      region.max[i] = std::max(bounds[i], bounds[i + 3]);
+    }
+    regions.push_back(region);
+  }
+  return true;
+}
+
+void ProximityMonitor::setRegions(const std::vector<Region> &regions) {
+  regions_ = regions;
+  updateMaxDistance();
+}
+
+void ProximityMonitor::setTransform(const tf2::Transform &region_from_optical) {
+  region_from_optical_ = region_from_optical;
+  const auto &origin = region_from_optical_.getOrigin();
+  for (int i = 0; i < 3; i++) {
+    translation_[i] = static_cast<float>(origin[i]);
+  }
+  updateMaxDistance();
+  // built for the previous rotation
+  rays_.reset();
+}
+
+void ProximityMonitor::updateMaxDistance() {
+  max_distance_ = 0.0f;
+  for (const auto &region : regions_) {
+    for (int corner = 0; corner < 8; corner++) {
+      float squared = 0.0f;
+      for (int i = 0; i < 3; i++) {
+        const float bound = (corner >> i) & 1 ? region.max[i] : region.min[i];
+        squared += (bound - translation_[i]) * (bound - translation_[i]);
+      }
+      max_distance_ = std::max(max_distance_, std::sqrt(squared));
+    }
+  }
+}
+
+bool ProximityMonitor::evaluate(const uint16_t *depth_data, int width, int height,
+                                float depth_scale, std::vector<Result> &results) const {
+  results.assign(regions_.size(), Result());
+  if (!rays_ || width != rays_->key.width || height != rays_->key.height ||
+      depth_data == nullptr) {
+    return false;
+  }
+  const RayTable &rays = *rays_;
+  const size_t region_count = regions_.size();
+  std::vector<float> best(region_count, std::numeric_limits<float>::max());
+  const float meters_per_unit = depth_scale * 0.001f;
+  // z never exceeds the distance along the ray, so this bound is conservative
+  const float max_raw = std::min(max_distance_ / meters_per_unit, 65535.0f);
+  const auto raw_limit = static_cast<uint16_t>(max_raw);
+  for (int v = 0; v < height; v++) {
+    const uint16_t *row = depth_data + static_cast<size_t>(v) * width;
+    const float *row_ray = &rays.row[v * 3];
+    for (int u = 0; u < width; u++) {
+      const uint16_t raw = row[u];
+      if (raw == 0 || raw > raw_limit) {
+        continue;
+      }
+      const float z = raw * meters_per_unit;
+      const float *column_ray = &rays.column[u * 3];
+      const float x = z * (column_ray[0] + row_ray[0]) + translation_[0];
+      const float y = z * (column_ray[1] + row_ray[1]) + translation_[1];
+      const float w = z * (column_ray[2] + row_ray[2]) + translation_[2];
+      for (size_t i = 0; i < region_count; i++) {
+        const auto &region = regions_[i];
+        if (x < region.min[0] || x > region.max[0] || y < region.min[1] || y > region.max[1] ||
+            w < region.min[2] || w > region.max[2]) {
+          continue;
+        }
+        const float squared = z * z * (rays.column_squared[u] + rays.row_squared[v] + 1.0f);
+        if (squared < best[i]) {
+          best[i] = squared;
+          results[i].u = u;
+          results[i].v = v;
+        }
+      }
+    }
+  }
+  for (size_t i = 0; i < region_count; i++) {
+    if (results[i].u >= 0) {
+      results[i].occupied = true;
+      results[i].distance = std::sqrt(best[i]);
+    }
+  }
+  return true;
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/ray_table.h"
+
+#include <algorithm>
+
+namespace orbbec_camera {
+namespace {
+// every consumer asks for one table per stream, a few geometries are plenty
+const size_t kMaxTables = 8;
+}  // namespace
+
+bool RayTable::Key::operator==(const Key &other) const {
+  return width == other.width && height == other.height && fx == other.fx && fy == other.fy &&
+         cx == other.cx && cy == other.cy &&
+         std::equal(rotation, rotation + 9, other.rotation);
+}
+
+RayTable::Key RayTable::makeKey(const OBCameraIntrinsic &intrinsic, int width, int height,
+                                const tf2::Matrix3x3 &rotation) {
+  Key key;
+  key.width = width;
+  key.height = height;
+  key.fx = intrinsic.fx * (static_cast<float>(width) / intrinsic.width);
+  key.fy = intrinsic.fy * (static_cast<float>(height) / intrinsic.height);
+  key.cx = intrinsic.cx * (static_cast<float>(width) / intrinsic.width);
+  key.cy = intrinsic.cy * (static_cast<float>(height) / intrinsic.height);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      key.rotation[i * 3 + j] = static_cast<float>(rotation[i][j]);
+    }
+  }
+  return key;
+}
+
+RayTable::RayTable(const Key &key) : key(key) {
+  const float *r = key.rotation;
+  column.resize(static_cast<size_t>(key.width) * 3);
+  row.resize(static_cast<size_t>(key.height) * 3);
+  column_squared.resize(key.width);
+  row_squared.resize(key.height);
+  for (int u = 0; u < key.width; u++) {
+    const float ray_x = (u - key.cx) / key.fx;
+    for (int i = 0; i < 3; i++) {
+      // x term plus the constant z = 1 term of the ray
+      column[u * 3 + i] = r[i * 3] * ray_x + r[i * 3 + 2];
+    }
+    column_squared[u] = ray_x * ray_x;
+  }
+  for (int v = 0; v < key.height; v++) {
+    const float ray_y = (v - key.cy) / key.fy;
+    for (int i = 0; i < 3; i++) {
+      row[v * 3 + i] = r[i * 3 + 1] * ray_y;
+    }
+    row_squared[v] = ray_y * ray_y;
+  }
+}
+
+std::shared_ptr<const RayTable> RayTableCache::get(const RayTable::Key &key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::find_if(tables_.begin(), tables_.end(),
+                         [&key](const std::shared_ptr<const RayTable> &table) {
+                           return table->key == key;
+                         });
+  std::shared_ptr<const RayTable> table;
+  if (it != tables_.end()) {
+    table = *it;
+    tables_.erase(it);
+  } else {
+    table = std::make_shared<RayTable>(key);
+    if (tables_.size() >= kMaxTables) {
+      // consumers still holding an evicted table keep it alive
+      tables_.erase(tables_.begin());
+    }
+  }
+  tables_.push_back(table);
+  return table;
+}
+
+void RayTableCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tables_.clear();
+}
+}  // namespace orbbec_camera
@@ -15,6 +15,7 @@
  *******************************************************************************/
 #include "ros/ros.h"
 #include "orbbec_camera/ob_camera_node_driver.h"
+#include "orbbec_camera/ob_multi_camera_driver.h"
 #include "nodelet/nodelet.h"
 #include <pluginlib/class_list_macros.h>
 
@@ -29,10 +30,15 @@ class OBCameraNodelet : public nodelet::Nodelet {
   void onInit() override {
     ros::NodeHandle nh = getNodeHandle();
     ros::NodeHandle nh_private = getPrivateNodeHandle();
-    ob_camera_node_driver_.reset(new OBCameraNodeDriver(nh, nh_private));
+    if (OBMultiCameraDriver::isConfigured(nh_private)) {
+      multi_camera_driver_.reset(new OBMultiCameraDriver(nh, nh_private));
+    } else {
+      ob_camera_node_driver_.reset(new OBCameraNodeDriver(nh, nh_private));
+    }
   }
 
   boost::shared_ptr<OBCameraNodeDriver> ob_camera_node_driver_;
+  boost::shared_ptr<OBMultiCameraDriver> multi_camera_driver_;
 };
 }  // namespace orbbec_camera
 
@@ -14,6 +14,9 @@
  * limitations under the License.
  *******************************************************************************/
 #include "orbbec_camera/ob_camera_node.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
 
 namespace orbbec_camera {
 
@@ -93,6 +96,14 @@ void OBCameraNode::setupCameraCtrlServices() {
               response.success = this->toggleSensorCallback(request, response, stream_index);
               return response.success;
             });
+    service_name = "set_" + stream_name + "_profile";
+    set_stream_profile_srv_[stream_index] =
+        nh_.advertiseService<SetStreamProfileRequest, SetStreamProfileResponse>(
+            service_name, [this, stream_index](SetStreamProfileRequest& request,
+                                               SetStreamProfileResponse& response) {
+              response.success = this->setStreamProfileCallback(request, response, stream_index);
+              return response.success;
+            });
     service_name = "get_" + stream_name + "_camera_info";
     get_camera_info_srv_[stream_index] =
         nh_.advertiseService<GetCameraInfoRequest, GetCameraInfoResponse>(
@@ -585,10 +596,147 @@ bool OBCameraNode::toggleSensor(const stream_index_pair& stream_index, bool enab
   (void)msg;
   stopStreams();
   enable_stream_[stream_index] = enabled;
+  pipeline_config_.reset();
   startStreams();
   return true;
 }
 
+bool OBCameraNode::setStreamProfileCallback(SetStreamProfileRequest& request,
+                                            SetStreamProfileResponse& response,
+                                            const stream_index_pair& stream_index) {
+  std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+  if (device_detached_ || !enable_stream_[stream_index] || !stream_profile_[stream_index] ||
+      !supported_profiles_[stream_index]) {
+    response.message = "Stream " + stream_name_[stream_index] + " is not enabled";
+    ROS_ERROR_STREAM(response.message);
+    return false;
+  }
+  auto current = stream_profile_[stream_index]->as<ob::VideoStreamProfile>();
+  int width = request.width > 0 ? request.width : static_cast<int>(current->width());
+  int height = request.height > 0 ? request.height : static_cast<int>(current->height());
+  int fps = request.fps > 0 ? request.fps : static_cast<int>(current->fps());
+  OBFormat format =
+      request.format.empty() ? current->format() : OBFormatFromString(request.format);
+  std::shared_ptr<ob::VideoStreamProfile> profile = nullptr;
+  if (format != OB_FORMAT_UNKNOWN) {
+    try {
+      // the list read at startup, no device round trip
+      auto profile_list = supported_profiles_[stream_index];
+      profile = profile_list->getVideoStreamProfile(width, height, format, fps);
+    } catch (const ob::Error& e) {
+      ROS_DEBUG_STREAM("No matching profile: " << e.getMessage());
+    }
+  }
+  if (!profile) {
+    std::ostringstream message;
+    message << "Stream " << stream_name_[stream_index] << " does not support " << width << "x"
+            << height << " " << fps << "fps " << (request.format.empty() ? "" : request.format);
+    response.message = message.str();
+    ROS_ERROR_STREAM(response.message);
+    printProfiles(sensors_[stream_index]->getSensor());
+    return false;
+  }
+  if (profile->width() == current->width() && profile->height() == current->height() &&
+      profile->fps() == current->fps() && profile->format() == current->format()) {
+    response.message = "Profile unchanged";
+    return true;
+  }
+  auto is_encoded = [](OBFormat value) {
+    return value == OB_FORMAT_H264 || value == OB_FORMAT_H265 || value == OB_FORMAT_HEVC;
+  };
+  if (stream_index == COLOR && (is_encoded(format) || is_encoded(current->format())) &&
+      (format != current->format() || profile->width() != current->width() ||
+       profile->height() != current->height())) {
+    response.message = "Changing the encoded color format or resolution needs a node restart";
+    ROS_ERROR_STREAM(response.message);
+    return false;
+  }
+  auto is_aligned = [](const stream_index_pair& value) { return value == DEPTH || value == COLOR; };
+  if ((depth_registration_ || enable_colored_point_cloud_) && is_aligned(stream_index) &&
+      profile->width() * current->height() != profile->height() * current->width()) {
+    // D2C picks its calibration by the aspect ratios of depth and color
+    const auto& other = stream_index == DEPTH ? COLOR : DEPTH;
+    bool calibrated = false;
+    for (const auto& param : getCalibrationCameraParams()) {
+      const auto& intrinsic = stream_index == DEPTH ? param.depthIntrinsic : param.rgbIntrinsic;
+      const auto& other_intrinsic =
+          stream_index == DEPTH ? param.rgbIntrinsic : param.depthIntrinsic;
+      if (intrinsic.width * static_cast<int>(profile->height()) ==
+              intrinsic.height * static_cast<int>(profile->width()) &&
+          other_intrinsic.width * height_[other] == other_intrinsic.height * width_[other]) {
+        calibrated = true;
+        break;
+      }
+    }
+    if (!calibrated) {
+      std::ostringstream message;
+      message << "No depth to color calibration for " << stream_name_[stream_index] << " at "
+              << profile->width() << "x" << profile->height() << " with "
+              << stream_name_[other] << " at " << width_[other] << "x" << height_[other];
+      response.message = message.str();
+      ROS_ERROR_STREAM(response.message);
+      return false;
+    }
+  }
+  bool restart = enable_pipeline_ ? pipeline_started_ : stream_started_[stream_index];
+  if (!restart) {
+    applyStreamProfile(stream_index, profile);
+    response.message = "Profile applies when the stream starts";
+    return true;
+  }
+  auto stop_streams = [&]() {
+    if (enable_pipeline_) {
+      stopStreams();
+    } else {
+      stopStream(stream_index);
+    }
+  };
+  auto start_streams = [&]() {
+    try {
+      if (enable_pipeline_) {
+        startStreams();
+      } else {
+        startStream(stream_index);
+      }
+    } catch (const ob::Error& e) {
+      ROS_ERROR_STREAM("Failed to start " << stream_name_[stream_index] << ": " << e.getMessage());
+    }
+    return enable_pipeline_ ? static_cast<bool>(pipeline_started_)
+                            : static_cast<bool>(stream_started_[stream_index]);
+  };
+  {
+    std::lock_guard<std::mutex> lock(profile_switch_mutex_);
+    profile_switch_stream_ = stream_index;
+    profile_switch_fps_ = static_cast<int>(profile->fps());
+    profile_switch_restarted_ = false;
+    profile_switch_has_last_frame_ = false;
+    profile_switch_started_at_ = std::chrono::steady_clock::now();
+    profile_switch_armed_ = true;
+  }
+  stop_streams();
+  {
+    std::lock_guard<std::mutex> lock(profile_switch_mutex_);
+    profile_switch_restarted_ = true;
+  }
+  applyStreamProfile(stream_index, profile);
+  if (!start_streams()) {
+    profile_switch_armed_ = false;
+    ROS_ERROR_STREAM("Restoring the previous " << stream_name_[stream_index] << " profile");
+    applyStreamProfile(stream_index, current);
+    start_streams();
+    response.message = "Device rejected the new profile, the previous one is restored";
+    return false;
+  }
+  // the service thread is the only spinner, the frame gap is reported by
+  // recordProfileSwitchFrame() once the first frame of the new profile arrives
+  std::ostringstream message;
+  message << "Stream " << stream_name_[stream_index] << " switched to " << profile->width() << "x"
+          << profile->height() << " " << profile->fps() << "fps " << profile->format();
+  response.message = message.str();
+  ROS_INFO_STREAM(response.message);
+  return true;
+}
+
 bool OBCameraNode::saveImagesCallback(std_srvs::EmptyRequest& request,
                                       std_srvs::EmptyResponse& response) {
   (void)request;
@@ -608,8 +756,8 @@ bool OBCameraNode::savePointCloudCallback(std_srvs::EmptyRequest& request,
                                           std_srvs::EmptyResponse& response) {
   (void)request;
   (void)response;
-  save_point_cloud_ = true;
-  save_colored_point_cloud_ = true;
+  save_point_cloud_ = point_cloud_save_count_;
+  save_colored_point_cloud_ = point_cloud_save_count_;
   return true;
 }
 
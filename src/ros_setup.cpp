@@ -16,7 +16,12 @@
 
 #include "orbbec_camera/ob_camera_node.h"
 #include "orbbec_camera/utils.h"
+#include "orbbec_camera/profile_planner.h"
 #include <std_msgs/String.h>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <sstream>
 
 namespace orbbec_camera {
 
@@ -73,14 +78,77 @@ void OBCameraNode::selectBaseStream() {
   }
 }
 
+void OBCameraNode::setupCapabilityCache() {
+  if (!enable_capability_cache_) {
+    return;
+  }
+  std::string directory = capability_cache_dir_;
+  if (directory.empty()) {
+    const char* ros_home = std::getenv("ROS_HOME");
+    const char* home = std::getenv("HOME");
+    directory = ros_home ? std::string(ros_home) : std::string(home ? home : ".") + "/.ros";
+    directory += "/orbbec_camera";
+  }
+  CHECK_NOTNULL(device_info_.get());
+  capability_cache_ = std::make_shared<CapabilityCache>(
+      directory, device_info_->serialNumber(), device_info_->firmwareVersion());
+  if (capability_cache_->load()) {
+    ROS_INFO_STREAM("Using capability cache " << capability_cache_->path());
+  } else {
+    ROS_INFO_STREAM("No valid capability cache for this device and firmware, creating "
+                    << capability_cache_->path());
+  }
+}
+
+bool OBCameraNode::isPropertySupported(OBPropertyID property, OBPermissionType permission) {
+  bool supported = false;
+  if (capability_cache_ && capability_cache_->propertySupported(property, permission, supported)) {
+    return supported;
+  }
+  supported = device_->isPropertySupported(property, permission);
+  if (capability_cache_) {
+    capability_cache_->setPropertySupported(property, permission, supported);
+  }
+  return supported;
+}
+
+std::string OBCameraNode::deviceSettingsFingerprint() const {
+  std::ostringstream settings;
+  settings << device_preset_ << "/" << enable_color_auto_exposure_ << "/" << color_exposure_
+           << "/" << color_gain_ << "/" << enable_ir_auto_exposure_ << "/" << ir_exposure_ << "/"
+           << enable_ir_long_exposure_;
+  return settings.str();
+}
+
+bool OBCameraNode::isAutoExposureEnabled(const stream_index_pair& stream_index) const {
+  return stream_index == COLOR ? enable_color_auto_exposure_ : enable_ir_auto_exposure_;
+}
+
 void OBCameraNode::setupDevices() {
   auto sensor_list = device_->getSensorList();
+  // stream types served by each sensor, walking every profile list is the slow part
+  std::vector<std::vector<int>> sensor_streams;
+  if (!capability_cache_ || !capability_cache_->sensorStreams(sensor_streams) ||
+      sensor_streams.size() != sensor_list->count()) {
+    sensor_streams.assign(sensor_list->count(), std::vector<int>());
+    for (size_t i = 0; i < sensor_list->count(); i++) {
+      auto profiles = sensor_list->getSensor(i)->getStreamProfileList();
+      for (size_t j = 0; j < profiles->count(); j++) {
+        int type = static_cast<int>(profiles->getProfile(j)->type());
+        auto& types = sensor_streams[i];
+        if (std::find(types.begin(), types.end(), type) == types.end()) {
+          types.push_back(type);
+        }
+      }
+    }
+    if (capability_cache_) {
+      capability_cache_->setSensorStreams(sensor_streams);
+    }
+  }
   for (size_t i = 0; i < sensor_list->count(); i++) {
     auto sensor = sensor_list->getSensor(i);
-    auto profiles = sensor->getStreamProfileList();
-    for (size_t j = 0; j < profiles->count(); j++) {
-      auto profile = profiles->getProfile(j);
-      stream_index_pair sip{profile->type(), 0};
+    for (int type : sensor_streams[i]) {
+      stream_index_pair sip{static_cast<OBStreamType>(type), 0};
       if (sensors_.find(sip) == sensors_.end()) {
         sensors_[sip] = std::make_shared<ROSOBSensor>(device_, sensor, stream_name_[sip]);
       }
@@ -98,7 +166,7 @@ void OBCameraNode::setupDevices() {
       enable_stream_[stream_index] = false;
     }
   }
-  if (enable_d2c_viewer_) {
+  if (enable_d2c_viewer_ && !d2c_viewer_) {
     d2c_viewer_ = std::make_shared<D2CViewer>(nh_, nh_private_);
   }
   CHECK_NOTNULL(device_info_.get());
@@ -110,13 +178,12 @@ void OBCameraNode::setupDevices() {
   }
 
   try {
-    if (device_->isPropertySupported(OB_PROP_DEVICE_USB3_REPEAT_IDENTIFY_BOOL,
-                                     OB_PERMISSION_READ_WRITE)) {
+    if (isPropertySupported(OB_PROP_DEVICE_USB3_REPEAT_IDENTIFY_BOOL, OB_PERMISSION_READ_WRITE)) {
       device_->setBoolProperty(OB_PROP_DEVICE_USB3_REPEAT_IDENTIFY_BOOL,
                                retry_on_usb3_detection_failure_);
     }
     if (enable_hardware_d2d_ &&
-        device_->isPropertySupported(OB_PROP_DISPARITY_TO_DEPTH_BOOL, OB_PERMISSION_READ_WRITE)) {
+        isPropertySupported(OB_PROP_DISPARITY_TO_DEPTH_BOOL, OB_PERMISSION_READ_WRITE)) {
       device_->setBoolProperty(OB_PROP_DISPARITY_TO_DEPTH_BOOL, true);
       bool is_hardware_d2d = device_->getBoolProperty(OB_PROP_DISPARITY_TO_DEPTH_BOOL);
       std::string d2d_mode = is_hardware_d2d ? "HW D2D" : "SW D2D";
@@ -126,8 +193,7 @@ void OBCameraNode::setupDevices() {
       device_->loadPreset(device_preset_.c_str());
     }
     if (!sync_mode_str_.empty() &&
-        device_->isPropertySupported(OB_PROP_SYNC_SIGNAL_TRIGGER_OUT_BOOL,
-                                     OB_PERMISSION_READ_WRITE)) {
+        isPropertySupported(OB_PROP_SYNC_SIGNAL_TRIGGER_OUT_BOOL, OB_PERMISSION_READ_WRITE)) {
       auto sync_config = device_->getMultiDeviceSyncConfig();
       ROS_INFO_STREAM("current sync mode: " << sync_config.syncMode);
       std::transform(sync_mode_str_.begin(), sync_mode_str_.end(), sync_mode_str_.begin(),
@@ -145,7 +211,7 @@ void OBCameraNode::setupDevices() {
     }
 
     auto depth_sensor = device_->getSensor(OB_SENSOR_DEPTH);
-    if (device_->isPropertySupported(OB_PROP_DEPTH_AUTO_EXPOSURE_BOOL, OB_PERMISSION_READ_WRITE)) {
+    if (isPropertySupported(OB_PROP_DEPTH_AUTO_EXPOSURE_BOOL, OB_PERMISSION_READ_WRITE)) {
       device_->setBoolProperty(OB_PROP_DEPTH_AUTO_EXPOSURE_BOOL, enable_ir_auto_exposure_);
     }
     device_->setBoolProperty(OB_PROP_COLOR_AUTO_EXPOSURE_BOOL, enable_color_auto_exposure_);
@@ -158,15 +224,15 @@ void OBCameraNode::setupDevices() {
     if (ir_exposure_ != -1) {
       device_->setIntProperty(OB_PROP_DEPTH_EXPOSURE_INT, ir_exposure_);
     }
-    if (device_->isPropertySupported(OB_PROP_LASER_CONTROL_INT, OB_PERMISSION_READ_WRITE)) {
+    if (isPropertySupported(OB_PROP_LASER_CONTROL_INT, OB_PERMISSION_READ_WRITE)) {
       device_->setIntProperty(OB_PROP_LASER_CONTROL_INT, enable_laser_);
     }
-    if (device_->isPropertySupported(OB_PROP_LASER_ON_OFF_MODE_INT, OB_PERMISSION_READ_WRITE)) {
+    if (isPropertySupported(OB_PROP_LASER_ON_OFF_MODE_INT, OB_PERMISSION_READ_WRITE)) {
       device_->setIntProperty(OB_PROP_LASER_ON_OFF_MODE_INT, laser_on_off_mode_);
     }
 
     if (!depth_precision_str_.empty() &&
-        device_->isPropertySupported(OB_PROP_DEPTH_PRECISION_LEVEL_INT, OB_PERMISSION_READ_WRITE)) {
+        isPropertySupported(OB_PROP_DEPTH_PRECISION_LEVEL_INT, OB_PERMISSION_READ_WRITE)) {
       auto default_precision_level = device_->getIntProperty(OB_PROP_DEPTH_PRECISION_LEVEL_INT);
       if (default_precision_level != depth_precision_level_) {
         device_->setIntProperty(OB_PROP_DEPTH_PRECISION_LEVEL_INT, depth_precision_level_);
@@ -174,8 +240,8 @@ void OBCameraNode::setupDevices() {
       }
     }
     if (!depth_precision_str_.empty() &&
-        device_->isPropertySupported(OB_PROP_DEPTH_UNIT_FLEXIBLE_ADJUSTMENT_FLOAT,
-                                     OB_PERMISSION_READ_WRITE)) {
+        isPropertySupported(OB_PROP_DEPTH_UNIT_FLEXIBLE_ADJUSTMENT_FLOAT,
+                            OB_PERMISSION_READ_WRITE)) {
       auto depth_unit_flexible_adjustment = depthPrecisionFromString(depth_precision_str_);
       auto range = device_->getFloatPropertyRange(OB_PROP_DEPTH_UNIT_FLEXIBLE_ADJUSTMENT_FLOAT);
       ROS_INFO_STREAM("Depth unit flexible adjustment range: " << range.min << " - " << range.max);
@@ -280,15 +346,15 @@ void OBCameraNode::setupDevices() {
         ROS_INFO_STREAM("Skip setting " << filter_name);
       }
     }
-    if (device_->isPropertySupported(OB_PROP_COLOR_AUTO_EXPOSURE_BOOL, OB_PERMISSION_WRITE)) {
+    if (isPropertySupported(OB_PROP_COLOR_AUTO_EXPOSURE_BOOL, OB_PERMISSION_WRITE)) {
       device_->setBoolProperty(OB_PROP_COLOR_AUTO_EXPOSURE_BOOL, enable_color_auto_exposure_);
     }
 
-    if (device_->isPropertySupported(OB_PROP_IR_AUTO_EXPOSURE_BOOL, OB_PERMISSION_WRITE)) {
+    if (isPropertySupported(OB_PROP_IR_AUTO_EXPOSURE_BOOL, OB_PERMISSION_WRITE)) {
       device_->setBoolProperty(OB_PROP_IR_AUTO_EXPOSURE_BOOL, enable_ir_auto_exposure_);
     }
 
-    if (device_->isPropertySupported(OB_PROP_IR_LONG_EXPOSURE_BOOL, OB_PERMISSION_WRITE)) {
+    if (isPropertySupported(OB_PROP_IR_LONG_EXPOSURE_BOOL, OB_PERMISSION_WRITE)) {
       device_->setBoolProperty(OB_PROP_IR_LONG_EXPOSURE_BOOL, enable_ir_long_exposure_);
     }
   } catch (const ob::Error& e) {
@@ -371,41 +437,98 @@ void OBCameraNode::printProfiles(const std::shared_ptr<ob::Sensor>& sensor) {
 }
 
 void OBCameraNode::setupProfiles() {
+  std::vector<stream_index_pair> planned_streams;
+  std::vector<ProfilePlanner::Stream> plan_streams;
   for (const auto& stream_index : IMAGE_STREAMS) {
     if (!enable_stream_[stream_index] && stream_index != base_stream_) {
       continue;
     }
+    ProfilePlanner::Stream stream;
     try {
       auto profile_list = sensors_[stream_index]->getStreamProfileList();
       supported_profiles_[stream_index] = profile_list;
-      std::shared_ptr<ob::VideoStreamProfile> selected_profile = nullptr;
-      if (width_[stream_index] == 0 && height_[stream_index] == 0 && fps_[stream_index] == 0 &&
-          format_[stream_index] == OB_FORMAT_UNKNOWN) {
-        selected_profile = profile_list->getProfile(0)->as<ob::VideoStreamProfile>();
-      } else {
-        selected_profile = profile_list->getVideoStreamProfile(
-            width_[stream_index], height_[stream_index], format_[stream_index], fps_[stream_index]);
+      for (size_t i = 0; i < profile_list->count(); i++) {
+        auto profile = profile_list->getProfile(i)->as<ob::VideoStreamProfile>();
+        ProfilePlanner::Profile candidate;
+        candidate.width = profile->width();
+        candidate.height = profile->height();
+        candidate.fps = profile->fps();
+        candidate.format = profile->format();
+        stream.candidates.push_back(candidate);
       }
-
-      auto default_profile = profile_list->getProfile(0)->as<ob::VideoStreamProfile>();
-      if (!selected_profile) {
+    } catch (const ob::Error& e) {
+      ROS_ERROR_STREAM("Failed to read " << stream_name_[stream_index]
+                                         << " profiles, stream disabled: " << e.getMessage());
+      enable_stream_[stream_index] = false;
+      continue;
+    }
+    stream.name = stream_name_[stream_index];
+    stream.requested.width = static_cast<uint32_t>(std::max(width_[stream_index], 0));
+    stream.requested.height = static_cast<uint32_t>(std::max(height_[stream_index], 0));
+    stream.requested.fps = static_cast<uint32_t>(std::max(fps_[stream_index], 0));
+    stream.requested.format = format_[stream_index];
+    // formats the node decodes the same way, depth stays Y16 for point clouds and filters
+    if (stream_index == COLOR) {
+      stream.fallback_formats = {OB_FORMAT_MJPG};
+    } else if (stream_index.first != OB_STREAM_DEPTH) {
+      stream.fallback_formats = {OB_FORMAT_Y8};
+    }
+    stream.counted = enable_stream_[stream_index];
+    planned_streams.push_back(stream_index);
+    plan_streams.push_back(stream);
+  }
+  double budget = bandwidth_budget_;
+  std::string connection_type = "unknown";
+  try {
+    connection_type = device_info_->connectionType();
+  } catch (const ob::Error& e) {
+    ROS_WARN_STREAM("Failed to read the connection type: " << e.getMessage());
+  }
+  if (budget == 0.0) {
+    budget = ProfilePlanner::linkBudget(connection_type);
+    // the share splits a USB bus, network cameras have a link each
+    if (connection_type.find("USB") != std::string::npos) {
+      budget *= bandwidth_share_;
+    }
+  }
+  auto plan = ProfilePlanner::plan(plan_streams, budget);
+  if (budget > 0.0) {
+    ROS_INFO_STREAM("Profile plan on " << connection_type << " link: about "
+                                       << plan.total_mb_per_s << " MB/s of a " << budget
+                                       << " MB/s budget");
+  } else {
+    ROS_INFO_STREAM("Profile plan on " << connection_type << " link: about "
+                                       << plan.total_mb_per_s << " MB/s, no budget");
+  }
+  if (!plan.fits) {
+    ROS_WARN_STREAM("Even the lowest profiles exceed the bandwidth budget, expect dropped frames");
+  }
+  for (size_t i = 0; i < planned_streams.size(); i++) {
+    const auto& stream_index = planned_streams[i];
+    const auto& choice = plan.choices[i];
+    if (choice.candidate < 0) {
+      ROS_WARN_STREAM("No profile offered for stream " << stream_name_[stream_index]
+                                                       << ", it will be disabled");
+      enable_stream_[stream_index] = false;
+      continue;
+    }
+    try {
+      auto selected_profile = supported_profiles_[stream_index]
+                                  ->getProfile(static_cast<uint32_t>(choice.candidate))
+                                  ->as<ob::VideoStreamProfile>();
+      CHECK_NOTNULL(selected_profile.get());
+      if (!choice.exact) {
         ROS_WARN_STREAM("Given stream configuration is not supported by the device! "
                         << " Stream: " << stream_name_[stream_index]
                         << ", Width: " << width_[stream_index]
                         << ", Height: " << height_[stream_index] << ", FPS: " << fps_[stream_index]
-                        << ", Format: " << format_[stream_index]);
-        if (default_profile) {
-          ROS_WARN_STREAM("Using default profile instead.");
-          ROS_WARN_STREAM("default FPS " << default_profile->fps());
-          selected_profile = default_profile;
-        } else {
-          ROS_WARN_STREAM(" NO default_profile found , Stream: " << stream_index.first
-                                                                 << " will be disable");
-          enable_stream_[stream_index] = false;
-          continue;
-        }
+                        << ", Format: " << format_[stream_index]
+                        << ". Using the closest profile instead.");
+      }
+      if (choice.degraded) {
+        ROS_WARN_STREAM(" stream " << stream_name_[stream_index]
+                                   << " lowered to fit the link bandwidth budget");
       }
-      CHECK_NOTNULL(selected_profile.get());
       stream_profile_[stream_index] = selected_profile;
       int width = static_cast<int>(selected_profile->width());
       int height = static_cast<int>(selected_profile->height());
@@ -414,22 +537,19 @@ void OBCameraNode::setupProfiles() {
       width_[stream_index] = width;
       height_[stream_index] = height;
       fps_[stream_index] = fps;
+      format_[stream_index] = selected_profile->format();
       images_[stream_index] =
           cv::Mat(height, width, image_format_[stream_index], cv::Scalar(0, 0, 0));
       ROS_INFO_STREAM(" stream " << stream_name_[stream_index] << " is enabled - width: " << width
                                  << ", height: " << height << ", fps: " << fps << ", "
-                                 << "Format: " << selected_profile->format());
+                                 << "Format: " << selected_profile->format() << ", about "
+                                 << choice.mb_per_s << " MB/s");
     } catch (const ob::Error& e) {
-      ROS_ERROR_STREAM("Failed to setup  "
-                       << stream_name_[stream_index] << " profile: " << width_[stream_index] << "x"
-                       << height_[stream_index] << " " << fps_[stream_index] << "fps "
-                       << OBFormatToString(format_[stream_index]) << " ERROR:" << e.getMessage());
+      ROS_ERROR_STREAM("Failed to setup " << stream_name_[stream_index]
+                                          << " profile, stream disabled: " << e.getMessage());
       printProfiles(sensors_[stream_index]->getSensor());
-      ROS_ERROR(
-          "Error: The device might be connected via USB 2.0. Please verify your launch file "
-          "configuration and "
-          "try again. The current process will now exit.");
-      exit(1);
+      enable_stream_[stream_index] = false;
+      stream_profile_[stream_index] = nullptr;
     }
   }
   // IMU
@@ -461,6 +581,13 @@ void OBCameraNode::setupProfiles() {
       stream_profile_[stream_index] = nullptr;
     }
   }
+  setupHardwareAlignment();
+  if (depth_registration_ || enable_colored_point_cloud_) {
+    align_filter_ = std::make_shared<ob::Align>(align_target_stream_);
+  }
+}
+
+void OBCameraNode::setupHardwareAlignment() {
   if (!enable_pipeline_ && (depth_registration_ || enable_colored_point_cloud_)) {
     int index = getCameraParamIndex();
     try {
@@ -470,9 +597,47 @@ void OBCameraNode::setupProfiles() {
       ROS_ERROR_STREAM("set d2c error " << e.getMessage());
     }
   }
-  if (depth_registration_ || enable_colored_point_cloud_) {
-    align_filter_ = std::make_shared<ob::Align>(align_target_stream_);
+}
+
+bool OBCameraNode::rebindProfiles() {
+  for (const auto& stream_index : IMAGE_STREAMS) {
+    if (!stream_profile_.count(stream_index) || !stream_profile_[stream_index]) {
+      continue;
+    }
+    // the old profile object outlives its device, it still describes the selected mode
+    auto selected = stream_profile_[stream_index]->as<ob::VideoStreamProfile>();
+    auto profile_list = sensors_[stream_index]->getStreamProfileList();
+    auto profile = profile_list->getVideoStreamProfile(selected->width(), selected->height(),
+                                                       selected->format(), selected->fps());
+    if (!profile) {
+      ROS_WARN_STREAM("stream " << stream_name_[stream_index]
+                                << " profile is no longer offered by the device");
+      return false;
+    }
+    supported_profiles_[stream_index] = profile_list;
+    stream_profile_[stream_index] = profile;
+  }
+  for (const auto& stream_index : HID_STREAMS) {
+    if (!enable_stream_[stream_index] || !stream_profile_.count(stream_index) ||
+        !stream_profile_[stream_index]) {
+      continue;
+    }
+    auto profile_list = sensors_[stream_index]->getStreamProfileList();
+    auto sample_rate = sampleRateFromString(imu_rate_[stream_index]);
+    if (stream_index == ACCEL) {
+      stream_profile_[stream_index] = profile_list->getAccelStreamProfile(
+          fullAccelScaleRangeFromString(imu_range_[stream_index]), sample_rate);
+    } else {
+      stream_profile_[stream_index] = profile_list->getGyroStreamProfile(
+          fullGyroScaleRangeFromString(imu_range_[stream_index]), sample_rate);
+    }
+    supported_profiles_[stream_index] = profile_list;
   }
+  setupHardwareAlignment();
+  // the cached pipeline configs hold profiles of the old device
+  pipeline_config_.reset();
+  standby_pipeline_config_.reset();
+  return true;
 }
 void OBCameraNode::updateImageConfig(
     const stream_index_pair& stream_index,
@@ -544,6 +709,61 @@ void OBCameraNode::setupPublishers() {
         boost::bind(&OBCameraNode::pointCloudUnsubscribedCallback, this);
     depth_cloud_pub_ = nh_.advertise<sensor_msgs::PointCloud2>(
         "depth/points", 1, depth_cloud_subscribed_cb, depth_cloud_unsubscribed_cb);
+    if (enable_point_cloud_normals_) {
+      depth_normals_pub_ = nh_.advertise<sensor_msgs::PointCloud2>(
+          "depth/points_normals", 1, depth_cloud_subscribed_cb, depth_cloud_unsubscribed_cb);
+    }
+    if (enable_plane_segmentation_) {
+      floor_plane_pub_ = nh_.advertise<Plane>("depth/floor_plane", 1, depth_cloud_subscribed_cb,
+                                              depth_cloud_unsubscribed_cb);
+      ground_removed_cloud_pub_ = nh_.advertise<sensor_msgs::PointCloud2>(
+          "depth/points_no_ground", 1, depth_cloud_subscribed_cb, depth_cloud_unsubscribed_cb);
+    }
+  }
+  if (enable_point_cloud_intensity_ && enable_stream_[DEPTH]) {
+    intensity_ir_stream_ = enable_stream_[INFRA1] ? INFRA1 : INFRA0;
+    if (!enable_stream_[intensity_ir_stream_]) {
+      ROS_WARN("Intensity point cloud needs an IR stream, enable_ir or enable_left_ir is off");
+    }
+    ros::SubscriberStatusCallback intensity_cloud_subscribed_cb =
+        boost::bind(&OBCameraNode::intensityPointCloudSubscribedCallback, this);
+    ros::SubscriberStatusCallback intensity_cloud_unsubscribed_cb =
+        boost::bind(&OBCameraNode::intensityPointCloudUnsubscribedCallback, this);
+    intensity_cloud_pub_ = nh_.advertise<sensor_msgs::PointCloud2>(
+        "depth/points_intensity", 1, intensity_cloud_subscribed_cb,
+        intensity_cloud_unsubscribed_cb);
+  }
+  if (enable_laser_scan_ && enable_stream_[DEPTH]) {
+    ros::SubscriberStatusCallback laser_scan_subscribed_cb =
+        boost::bind(&OBCameraNode::depthOutputSubscribedCallback, this);
+    ros::SubscriberStatusCallback laser_scan_unsubscribed_cb =
+        boost::bind(&OBCameraNode::depthOutputUnsubscribedCallback, this);
+    laser_scan_pub_ = nh_.advertise<sensor_msgs::LaserScan>(
+        "depth/scan", 1, laser_scan_subscribed_cb, laser_scan_unsubscribed_cb);
+  }
+  if (enable_height_map_ && enable_stream_[DEPTH]) {
+    ros::SubscriberStatusCallback height_map_subscribed_cb =
+        boost::bind(&OBCameraNode::depthOutputSubscribedCallback, this);
+    ros::SubscriberStatusCallback height_map_unsubscribed_cb =
+        boost::bind(&OBCameraNode::depthOutputUnsubscribedCallback, this);
+    height_map_pub_ = nh_.advertise<nav_msgs::OccupancyGrid>(
+        "depth/height_map", 1, height_map_subscribed_cb, height_map_unsubscribed_cb);
+  }
+  if (enable_proximity_) {
+    ros::SubscriberStatusCallback proximity_subscribed_cb =
+        boost::bind(&OBCameraNode::depthOutputSubscribedCallback, this);
+    ros::SubscriberStatusCallback proximity_unsubscribed_cb =
+        boost::bind(&OBCameraNode::depthOutputUnsubscribedCallback, this);
+    proximity_pub_ = nh_.advertise<Proximity>("depth/proximity", 1, proximity_subscribed_cb,
+                                              proximity_unsubscribed_cb);
+  }
+  if (enable_depth_stats_ && enable_stream_[DEPTH]) {
+    ros::SubscriberStatusCallback depth_stats_subscribed_cb =
+        boost::bind(&OBCameraNode::depthOutputSubscribedCallback, this);
+    ros::SubscriberStatusCallback depth_stats_unsubscribed_cb =
+        boost::bind(&OBCameraNode::depthOutputUnsubscribedCallback, this);
+    depth_stats_pub_ = nh_.advertise<DepthStats>("depth/stats", 1, depth_stats_subscribed_cb,
+                                                 depth_stats_unsubscribed_cb);
   }
   if (enable_colored_point_cloud_ && enable_stream_[DEPTH] && enable_stream_[COLOR]) {
     ros::SubscriberStatusCallback depth_registered_cloud_subscribed_cb =
@@ -563,13 +783,44 @@ void OBCameraNode::setupPublishers() {
         boost::bind(&OBCameraNode::imuUnsubscribedCallback, this, GYRO);
     imu_gyro_accel_publisher_ =
         nh_.advertise<sensor_msgs::Imu>(topic_name, 1, imu_subscribed_cb, imu_unsubscribed_cb);
+    if (enable_imu_batch_) {
+      imu_gyro_accel_batcher_ =
+          std::make_shared<ImuBatcher>(imu_batch_config_, imu_optical_frame_id_);
+      imu_gyro_accel_batch_publisher_ = nh_.advertise<ImuBatch>(
+          topic_name + "_batch", 10, imu_subscribed_cb, imu_unsubscribed_cb);
+    }
+    // calibration topics are latched and do not start the IMU
     topic_name = stream_name_[GYRO] + "/imu_info";
-    imu_info_publishers_[GYRO] = nh_.advertise<orbbec_camera::IMUInfo>(
-        topic_name, 1, imu_subscribed_cb, imu_unsubscribed_cb);
+    imu_info_publishers_[GYRO] = nh_.advertise<orbbec_camera::IMUInfo>(topic_name, 1, true);
     topic_name = stream_name_[ACCEL] + "/imu_info";
-    imu_info_publishers_[ACCEL] = nh_.advertise<orbbec_camera::IMUInfo>(
-        topic_name, 1, imu_subscribed_cb, imu_unsubscribed_cb);
+    imu_info_publishers_[ACCEL] = nh_.advertise<orbbec_camera::IMUInfo>(topic_name, 1, true);
   } else {
+    ImuUnifier::Method unite_imu_method = ImuUnifier::Method::NONE;
+    if (!imuUnifierMethodFromString(unite_imu_method_str_, unite_imu_method)) {
+      ROS_ERROR_STREAM("Unknown unite_imu_method "
+                       << unite_imu_method_str_ << ", expected none, copy or linear_interpolation");
+    } else if (unite_imu_method != ImuUnifier::Method::NONE &&
+               (!enable_stream_[ACCEL] || !enable_stream_[GYRO])) {
+      ROS_WARN("unite_imu_method needs both accel and gyro enabled, disabling");
+    } else if (unite_imu_method != ImuUnifier::Method::NONE) {
+      imu_unifier_ = std::make_shared<ImuUnifier>(unite_imu_method);
+      united_imu_output_ = [this](const ImuUnifier::Sample& gyro, const double accel[3]) {
+        publishUnitedImu(gyro, accel);
+      };
+      std::string topic_name = stream_name_[GYRO] + "_" + stream_name_[ACCEL] + "/sample";
+      ros::SubscriberStatusCallback united_imu_subscribed_cb =
+          boost::bind(&OBCameraNode::unitedImuSubscribedCallback, this);
+      ros::SubscriberStatusCallback united_imu_unsubscribed_cb =
+          boost::bind(&OBCameraNode::unitedImuUnsubscribedCallback, this);
+      imu_gyro_accel_publisher_ = nh_.advertise<sensor_msgs::Imu>(
+          topic_name, 1, united_imu_subscribed_cb, united_imu_unsubscribed_cb);
+      if (enable_imu_batch_) {
+        imu_gyro_accel_batcher_ =
+            std::make_shared<ImuBatcher>(imu_batch_config_, imu_optical_frame_id_);
+        imu_gyro_accel_batch_publisher_ = nh_.advertise<ImuBatch>(
+            topic_name + "_batch", 10, united_imu_subscribed_cb, united_imu_unsubscribed_cb);
+      }
+    }
     for (const auto& stream_index : HID_STREAMS) {
       if (!enable_stream_[stream_index]) {
         continue;
@@ -581,11 +832,20 @@ void OBCameraNode::setupPublishers() {
           boost::bind(&OBCameraNode::imuUnsubscribedCallback, this, stream_index);
       imu_publishers_[stream_index] =
           nh_.advertise<sensor_msgs::Imu>(topic_name, 1, imu_subscribed_cb, imu_unsubscribed_cb);
+      if (enable_imu_batch_) {
+        imu_batchers_[stream_index] =
+            std::make_shared<ImuBatcher>(imu_batch_config_, optical_frame_id_[stream_index]);
+        imu_batch_publishers_[stream_index] = nh_.advertise<ImuBatch>(
+            topic_name + "_batch", 10, imu_subscribed_cb, imu_unsubscribed_cb);
+      }
       topic_name = stream_name_[stream_index] + "/imu_info";
-      imu_info_publishers_[stream_index] = nh_.advertise<orbbec_camera::IMUInfo>(
-          topic_name, 1, imu_subscribed_cb, imu_unsubscribed_cb);
+      imu_info_publishers_[stream_index] =
+          nh_.advertise<orbbec_camera::IMUInfo>(topic_name, 1, true);
     }
   }
+  for (const auto& stream_index : HID_STREAMS) {
+    updateIMUInfo(stream_index);
+  }
   if (enable_stream_[DEPTH] && enable_stream_[INFRA0]) {
     depth_to_other_extrinsics_publishers_[INFRA0] =
         nh_.advertise<orbbec_camera::Extrinsics>("depth_to_ir", 1, true);
@@ -617,11 +877,112 @@ void OBCameraNode::setupPublishers() {
   filter_status_pub_.publish(msg);
 }
 
+void OBCameraNode::setupPointCloudCrop() {
+  point_cloud_crop_.clear();
+  point_cloud_ray_tables_.clear();
+  if (!point_cloud_frame_id_.empty() && point_cloud_frame_id_ != camera_link_frame_id_ &&
+      !tf_buffer_) {
+    tf_buffer_ = std::make_shared<tf2_ros::Buffer>();
+    tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
+  }
+  const auto& params = point_cloud_crop_params_;
+  if (params.min_range < 0 || params.max_range <= params.min_range) {
+    ROS_WARN_STREAM("Invalid point cloud range [" << params.min_range << ", " << params.max_range
+                                                  << "], using [0.02, 10.0]");
+  }
+  if (params.use_box) {
+    ROS_INFO_STREAM("Point cloud crop box [" << params.box_min[0] << ", " << params.box_min[1]
+                                             << ", " << params.box_min[2] << "] - ["
+                                             << params.box_max[0] << ", " << params.box_max[1]
+                                             << ", " << params.box_max[2] << "] mm in "
+                                             << point_cloud_crop_box_frame_ << " frame");
+  }
+  for (const auto& stream_index : {DEPTH, COLOR}) {
+    auto crop = params;
+    if (crop.min_range < 0 || crop.max_range <= crop.min_range) {
+      crop.min_range = 0.02;
+      crop.max_range = 10.0;
+    }
+    if (crop.use_box && point_cloud_crop_box_frame_ == "camera_link") {
+      auto transform = getOpticalToCameraLinkTransform(stream_index);
+      const auto& basis = transform.getBasis();
+      const auto& origin = transform.getOrigin();
+      for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+          crop.box_rot[i * 3 + j] = static_cast<float>(basis[i][j]);
+        }
+        crop.box_trans[i] = static_cast<float>(origin[i] * 1000.0);
+      }
+    } else if (crop.use_box && point_cloud_crop_box_frame_ != "optical") {
+      ROS_WARN_STREAM("Unknown point cloud crop box frame " << point_cloud_crop_box_frame_
+                                                            << ", using optical frame");
+    }
+    point_cloud_crop_[stream_index] = crop;
+  }
+}
+
+void OBCameraNode::setupHeightMap() {
+  if (!enable_height_map_) {
+    return;
+  }
+  if (!enable_stream_[DEPTH]) {
+    ROS_WARN("Height map needs the depth stream, disabling");
+    enable_height_map_ = false;
+    return;
+  }
+  const auto& stream_index = depth_registration_ ? COLOR : DEPTH;
+  height_map_projector_ = std::make_shared<HeightMapProjector>(worker_pool_);
+  height_map_projector_->setConfig(height_map_config_);
+  height_map_projector_->setTransform(height_map_ground_transform_ *
+                                      getOpticalToCameraLinkTransform(stream_index));
+}
+
+void OBCameraNode::setupProximityMonitor() {
+  if (!enable_proximity_) {
+    return;
+  }
+  if (!enable_stream_[DEPTH]) {
+    ROS_WARN("Proximity regions need the depth stream, disabling");
+    enable_proximity_ = false;
+    return;
+  }
+  std::vector<ProximityMonitor::Region> regions;
+  std::string error;
+  if (!ProximityMonitor::parseRegions(proximity_regions_, regions, error) || regions.empty()) {
+    ROS_ERROR_STREAM("Invalid proximity_regions \"" << proximity_regions_ << "\": "
+                                                     << (error.empty() ? "no region" : error)
+                                                     << ", disabling");
+    enable_proximity_ = false;
+    return;
+  }
+  proximity_monitor_.setRegions(regions);
+  if (proximity_frame_ == "camera_link") {
+    proximity_monitor_.setTransform(getOpticalToCameraLinkTransform(DEPTH));
+  } else if (proximity_frame_ != "optical") {
+    ROS_WARN_STREAM("Unknown proximity frame " << proximity_frame_ << ", using optical frame");
+  }
+  for (const auto& region : regions) {
+    ROS_INFO_STREAM("Proximity region " << region.name << " [" << region.min[0] << ", "
+                                        << region.min[1] << ", " << region.min[2] << "] - ["
+                                        << region.max[0] << ", " << region.max[1] << ", "
+                                        << region.max[2] << "] m in " << proximity_frame_
+                                        << " frame");
+  }
+  proximity_msg_.regions.resize(regions.size());
+  for (size_t i = 0; i < regions.size(); i++) {
+    proximity_msg_.regions[i].name = regions[i].name;
+  }
+}
+
 void OBCameraNode::setupCameraInfo() {
   color_camera_info_manager_ = std::make_shared<camera_info_manager::CameraInfoManager>(
       ros::NodeHandle(nh_, stream_name_[COLOR]), stream_name_[COLOR], color_info_uri_);
   ir_camera_info_manager_ = std::make_shared<camera_info_manager::CameraInfoManager>(
       ros::NodeHandle(nh_, stream_name_[INFRA0]), stream_name_[INFRA0], ir_info_uri_);
+  updateCameraInfos();
+}
+
+void OBCameraNode::updateCameraInfos() {
   auto param = getCameraParam();
   if (param) {
     camera_infos_[DEPTH] = convertToCameraInfo(param->depthIntrinsic, param->depthDistortion,
@@ -636,26 +997,79 @@ void OBCameraNode::setupCameraInfo() {
 }
 
 void OBCameraNode::setupPipelineConfig() {
-  if (pipeline_config_) {
-    pipeline_config_.reset();
-  }
-  pipeline_config_ = std::make_shared<ob::Config>();
   auto pid = device_info_->pid();
-  if (!isGemini335PID(pid) && depth_registration_ && enable_stream_[COLOR] &&
-      enable_stream_[DEPTH]) {
-    OBAlignMode align_mode = align_mode_ == "HW" ? ALIGN_D2C_HW_MODE : ALIGN_D2C_SW_MODE;
+  bool align = !isGemini335PID(pid) && depth_registration_ && enable_stream_[COLOR] &&
+               enable_stream_[DEPTH];
+  OBAlignMode align_mode = align_mode_ == "HW" ? ALIGN_D2C_HW_MODE : ALIGN_D2C_SW_MODE;
+  if (align) {
     ROS_INFO_STREAM("set align mode to " << align_mode_);
-    pipeline_config_->setAlignMode(align_mode);
-    pipeline_config_->setDepthScaleRequire(enable_depth_scale_);
   }
-  for (const auto& stream_index : IMAGE_STREAMS) {
-    if (enable_stream_[stream_index]) {
-      pipeline_config_->enableStream(stream_profile_[stream_index]);
+  auto make_config = [&](bool standby) {
+    auto config = std::make_shared<ob::Config>();
+    if (align) {
+      config->setAlignMode(align_mode);
+      config->setDepthScaleRequire(enable_depth_scale_);
+    }
+    for (const auto& stream_index : IMAGE_STREAMS) {
+      if (enable_stream_[stream_index]) {
+        config->enableStream(standby ? standbyProfile(stream_index)
+                                     : stream_profile_[stream_index]);
+      }
     }
+    return config;
+  };
+  pipeline_config_ = make_config(false);
+  standby_pipeline_config_ = idle_policy_ == IdlePolicy::STANDBY ? make_config(true) : nullptr;
+}
+
+std::shared_ptr<ob::StreamProfile> OBCameraNode::standbyProfile(
+    const stream_index_pair& stream_index) {
+  auto selected_profile = stream_profile_[stream_index];
+  if (!selected_profile || !supported_profiles_[stream_index]) {
+    return selected_profile;
+  }
+  auto selected = selected_profile->as<ob::VideoStreamProfile>();
+  auto profile_list = supported_profiles_[stream_index];
+  auto standby_profile = selected_profile;
+  int standby_distance = std::abs(static_cast<int>(selected->fps()) - standby_fps_);
+  for (size_t i = 0; i < profile_list->count(); i++) {
+    auto profile = profile_list->getProfile(i);
+    if (!profile->is<ob::VideoStreamProfile>()) {
+      continue;
+    }
+    auto video_profile = profile->as<ob::VideoStreamProfile>();
+    // same mode so the camera info, alignment and decoders stay valid, only the rate drops
+    if (video_profile->width() != selected->width() ||
+        video_profile->height() != selected->height() ||
+        video_profile->format() != selected->format() || video_profile->fps() > selected->fps()) {
+      continue;
+    }
+    int distance = std::abs(static_cast<int>(video_profile->fps()) - standby_fps_);
+    if (distance < standby_distance) {
+      standby_profile = profile;
+      standby_distance = distance;
+    }
+  }
+  return standby_profile;
+}
+
+void OBCameraNode::setupIdlePolicy() {
+  ROS_INFO_STREAM("Idle policy " << idlePolicyToString(idle_policy_) << " after "
+                                 << idle_timeout_ << " s without subscribers");
+  if (idle_policy_ == IdlePolicy::KEEP) {
+    return;
   }
+  idle_timer_ = nh_.createWallTimer(
+      ros::WallDuration(std::max(idle_timeout_, 0.001)),
+      [this](const ros::WallTimerEvent&) { applyIdlePolicy(); }, true, false);
 }
 
 void OBCameraNode::diagnosticTemperature(diagnostic_updater::DiagnosticStatusWrapper& stat) {
+  std::lock_guard<decltype(device_lock_)> lock(device_lock_);
+  if (device_detached_) {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::WARN, "Device disconnected, reconnecting");
+    return;
+  }
   try {
     OBDeviceTemperature temperature;
     uint32_t data_size = sizeof(OBDeviceTemperature);
@@ -676,9 +1090,99 @@ void OBCameraNode::diagnosticTemperature(diagnostic_updater::DiagnosticStatusWra
     stat.summary(diagnostic_msgs::DiagnosticStatus::ERROR, e.getMessage());
   }
 }
+
+void OBCameraNode::diagnosticClockSync(diagnostic_updater::DiagnosticStatusWrapper& stat) {
+  auto state = clock_offset_estimator_->state();
+  stat.add("Offset (s)", state.offset);
+  stat.add("Skew (ppm)", state.skew);
+  stat.add("Jitter (us)", state.jitter * 1e6);
+  stat.add("Latency above envelope (us)", state.latency * 1e6);
+  stat.add("Samples", state.samples);
+  stat.add("Clock resets", state.resets);
+  if (state.valid) {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Device clock model is tracking");
+  } else {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::WARN, "Device clock model is converging");
+  }
+}
+
+namespace {
+void addLatencyHistogram(diagnostic_updater::DiagnosticStatusWrapper& stat,
+                         const LatencyHistogram::Snapshot& histogram) {
+  stat.add("Last (ms)", histogram.last_ms);
+  stat.add("Min (ms)", histogram.min_ms);
+  stat.add("Mean (ms)", histogram.mean_ms);
+  stat.add("Max (ms)", histogram.max_ms);
+  for (size_t i = 0; i < histogram.counts.size(); i++) {
+    std::ostringstream bucket;
+    if (i < histogram.edges_ms.size()) {
+      bucket << "<= " << histogram.edges_ms[i] << " ms";
+    } else {
+      bucket << "> " << histogram.edges_ms.back() << " ms";
+    }
+    stat.add(bucket.str(), histogram.counts[i]);
+  }
+}
+}  // namespace
+
+void OBCameraNode::diagnosticConnectLatency(diagnostic_updater::DiagnosticStatusWrapper& stat) {
+  auto histogram = connect_latency_->snapshot();
+  stat.add("Connects", histogram.count);
+  addLatencyHistogram(stat, histogram);
+  if (histogram.count > 0) {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Device enumeration to first frame");
+  } else {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "No frame published since connect");
+  }
+}
+
+void OBCameraNode::diagnosticReattachLatency(diagnostic_updater::DiagnosticStatusWrapper& stat) {
+  auto histogram = reattach_latency_.snapshot();
+  stat.add("Reattaches", histogram.count);
+  addLatencyHistogram(stat, histogram);
+  stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Device re-enumeration to first frame");
+}
+
+void OBCameraNode::diagnosticStreamStartLatency(diagnostic_updater::DiagnosticStatusWrapper& stat) {
+  auto histogram = stream_start_latency_.snapshot();
+  stat.add("Starts", histogram.count);
+  addLatencyHistogram(stat, histogram);
+  stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Stream start to first frame");
+}
+
+void OBCameraNode::diagnosticProfileSwitch(diagnostic_updater::DiagnosticStatusWrapper& stat) {
+  auto histogram = profile_switch_gap_.snapshot();
+  stat.add("Switches", histogram.count);
+  addLatencyHistogram(stat, histogram);
+  std::lock_guard<std::mutex> lock(profile_switch_mutex_);
+  stat.add("Last missed frames", profile_switch_missed_frames_);
+  if (profile_switch_armed_ && profile_switch_restarted_ &&
+      std::chrono::steady_clock::now() - profile_switch_started_at_ > std::chrono::seconds(5)) {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::WARN,
+                 "No " + stream_name_[profile_switch_stream_] + " frame since the profile switch");
+  } else {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Frame gap of runtime profile switches");
+  }
+}
+
+void OBCameraNode::diagnosticResumeLatency(diagnostic_updater::DiagnosticStatusWrapper& stat) {
+  auto histogram = resume_latency_.snapshot();
+  stat.add("Idle policy", idlePolicyToString(idle_policy_));
+  stat.add("Resumes", histogram.count);
+  addLatencyHistogram(stat, histogram);
+  stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Subscribe to first frame after idle");
+}
+
 void OBCameraNode::setupDiagnosticUpdater() {
-  if (!device_->isPropertySupported(OB_STRUCT_DEVICE_TEMPERATURE, OB_PERMISSION_READ)) {
+  bool has_temperature =
+      isPropertySupported(OB_STRUCT_DEVICE_TEMPERATURE, OB_PERMISSION_READ);
+  if (!has_temperature) {
     ROS_WARN_STREAM("Device does not support temperature reading");
+  }
+  const bool has_resume = idle_policy_ != IdlePolicy::KEEP;
+  // Profile Switch rides along but alone does not keep the thread up, its gaps are logged anyway
+  if (!has_temperature && !clock_offset_estimator_ && !connect_latency_ && !warm_reconnect_ &&
+      !has_resume) {
     return;
   }
   std::string serial_number = device_info_->serialNumber();
@@ -686,7 +1190,24 @@ void OBCameraNode::setupDiagnosticUpdater() {
       std::make_shared<diagnostic_updater::Updater>(nh_, nh_private_, "ob_camera_" + serial_number);
   diagnostic_updater_->setHardwareID(serial_number);
   ros::WallRate rate(diagnostics_frequency_);
-  diagnostic_updater_->add("Temperature", this, &OBCameraNode::diagnosticTemperature);
+  if (has_temperature) {
+    diagnostic_updater_->add("Temperature", this, &OBCameraNode::diagnosticTemperature);
+  }
+  if (clock_offset_estimator_) {
+    diagnostic_updater_->add("Clock Sync", this, &OBCameraNode::diagnosticClockSync);
+  }
+  if (connect_latency_) {
+    diagnostic_updater_->add("Connect Latency", this, &OBCameraNode::diagnosticConnectLatency);
+    diagnostic_updater_->add("Stream Start Latency", this,
+                             &OBCameraNode::diagnosticStreamStartLatency);
+  }
+  if (warm_reconnect_) {
+    diagnostic_updater_->add("Reattach Latency", this, &OBCameraNode::diagnosticReattachLatency);
+  }
+  if (has_resume) {
+    diagnostic_updater_->add("Resume Latency", this, &OBCameraNode::diagnosticResumeLatency);
+  }
+  diagnostic_updater_->add("Profile Switch", this, &OBCameraNode::diagnosticProfileSwitch);
   while (is_running_ && ros::ok()) {
     diagnostic_updater_->force_update();
     rate.sleep();
@@ -698,12 +1219,24 @@ void OBCameraNode::readDefaultGain() {
     if (!enable_stream_[stream_index]) {
       continue;
     }
+    // under auto exposure the read back follows the scene and is not worth caching
+    const bool cacheable = capability_cache_ && !isAutoExposureEnabled(stream_index);
+    const std::string cache_key =
+        "gain/" + stream_name_[stream_index] + "/" + deviceSettingsFingerprint();
+    int gain = 0;
+    if (cacheable && capability_cache_->value(cache_key, gain)) {
+      default_gain_[stream_index] = gain;
+      continue;
+    }
     try {
       auto sensor = sensors_[stream_index];
       CHECK_NOTNULL(sensor.get());
-      auto gain = sensor->getGain();
+      gain = sensor->getGain();
       ROS_INFO_STREAM("stream " << stream_name_[stream_index] << " gain " << gain);
       default_gain_[stream_index] = gain;
+      if (cacheable) {
+        capability_cache_->setValue(cache_key, gain);
+      }
     } catch (ob::Error& e) {
       default_gain_[stream_index] = 0;
       ROS_DEBUG_STREAM("get gain error " << e.getMessage());
@@ -716,12 +1249,23 @@ void OBCameraNode::readDefaultExposure() {
     if (!enable_stream_[stream_index]) {
       continue;
     }
+    const bool cacheable = capability_cache_ && !isAutoExposureEnabled(stream_index);
+    const std::string cache_key =
+        "exposure/" + stream_name_[stream_index] + "/" + deviceSettingsFingerprint();
+    int exposure = 0;
+    if (cacheable && capability_cache_->value(cache_key, exposure)) {
+      default_exposure_[stream_index] = exposure;
+      continue;
+    }
     try {
       auto sensor = sensors_[stream_index];
       CHECK_NOTNULL(sensor.get());
-      auto exposure = sensor->getExposure();
+      exposure = sensor->getExposure();
       ROS_INFO_STREAM("stream " << stream_name_[stream_index] << " exposure " << exposure);
       default_exposure_[stream_index] = exposure;
+      if (cacheable) {
+        capability_cache_->setValue(cache_key, exposure);
+      }
     } catch (ob::Error& e) {
       default_exposure_[stream_index] = 0;
       ROS_DEBUG_STREAM("get " << stream_name_[stream_index] << " exposure error "
@@ -731,6 +1275,7 @@ void OBCameraNode::readDefaultExposure() {
 }
 
 void OBCameraNode::readDefaultWhiteBalance() {
+  // not cached, auto white balance is device state no launch setting pins down
   try {
     auto sensor = sensors_[COLOR];
     if (!sensor) {
@@ -15,6 +15,7 @@
  *******************************************************************************/
 
 #include "orbbec_camera/utils.h"
+#include "orbbec_camera/point_cloud_exporter.h"
 #include <tf2/LinearMath/Quaternion.h>
 #include "sensor_msgs/PointCloud2.h"
 #include "sensor_msgs/PointCloud.h"
@@ -229,136 +230,29 @@ sensor_msgs::CameraInfo convertToCameraInfo(OBCameraIntrinsic intrinsic,
 void saveRGBPointsToPly(std::shared_ptr<ob::Frame> frame, const std::string &fileName) {
   CHECK_NOTNULL(frame.get());
   size_t point_size = frame->dataSize() / sizeof(OBColorPoint);
-  FILE *fp = fopen(fileName.c_str(), "wb+");
-  fprintf(fp, "ply\n");
-  CHECK_NOTNULL(fp);
-  fprintf(fp, "format ascii 1.0\n");
-  fprintf(fp, "element vertex %zu\n", point_size);
-  fprintf(fp, "property float x\n");
-  fprintf(fp, "property float y\n");
-  fprintf(fp, "property float z\n");
-  fprintf(fp, "property uchar red\n");
-  fprintf(fp, "property uchar green\n");
-  fprintf(fp, "property uchar blue\n");
-  fprintf(fp, "end_header\n");
-
-  auto *point = (OBColorPoint *)frame->data();
-  CHECK_NOTNULL(point);
-  for (size_t i = 0; i < point_size; i++) {
-    fprintf(fp, "%.3f %.3f %.3f %d %d %d\n", point->x, point->y, point->z, (int)point->r,
-            (int)point->g, (int)point->b);
-    point++;
-  }
-
-  fflush(fp);
-  fclose(fp);
+  auto *points = (OBColorPoint *)frame->data();
+  CHECK_NOTNULL(points);
+  PointCloudExporter exporter(PointCloudFileFormat::PLY);
+  exporter.exportPoints(points, point_size, fileName);
 }
 
 void saveRGBPointCloudMsgToPly(const sensor_msgs::PointCloud2 &msg, const std::string &fileName) {
-  FILE *fp = fopen(fileName.c_str(), "wb+");
-  CHECK_NOTNULL(fp);
-
-  sensor_msgs::PointCloud2ConstIterator<float> iter_x(msg, "x");
-  sensor_msgs::PointCloud2ConstIterator<float> iter_y(msg, "y");
-  sensor_msgs::PointCloud2ConstIterator<float> iter_z(msg, "z");
-
-  // First, count the actual number of valid points
-  size_t valid_points = 0;
-  for (; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z) {
-    if (!std::isnan(*iter_x) && !std::isnan(*iter_y) && !std::isnan(*iter_z)) {
-      ++valid_points;
-    }
-  }
-
-  // Reset the iterators
-  iter_x = sensor_msgs::PointCloud2ConstIterator<float>(msg, "x");
-  iter_y = sensor_msgs::PointCloud2ConstIterator<float>(msg, "y");
-  iter_z = sensor_msgs::PointCloud2ConstIterator<float>(msg, "z");
-  sensor_msgs::PointCloud2ConstIterator<uint8_t> iter_r(msg, "r");
-  sensor_msgs::PointCloud2ConstIterator<uint8_t> iter_g(msg, "g");
-  sensor_msgs::PointCloud2ConstIterator<uint8_t> iter_b(msg, "b");
-
-  fprintf(fp, "ply\n");
-  fprintf(fp, "format ascii 1.0\n");
-  fprintf(fp, "element vertex %zu\n", valid_points);
-  fprintf(fp, "property float x\n");
-  fprintf(fp, "property float y\n");
-  fprintf(fp, "property float z\n");
-  fprintf(fp, "property uchar red\n");
-  fprintf(fp, "property uchar green\n");
-  fprintf(fp, "property uchar blue\n");
-  fprintf(fp, "end_header\n");
-
-  for (; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z, ++iter_r, ++iter_g, ++iter_b) {
-    if (!std::isnan(*iter_x) && !std::isnan(*iter_y) && !std::isnan(*iter_z)) {
-      fprintf(fp, "%.3f %.3f %.3f %d %d %d\n", *iter_x, *iter_y, *iter_z, (int)*iter_r,
-              (int)*iter_g, (int)*iter_b);
-    }
-  }
-
-  fflush(fp);
-  fclose(fp);
+  PointCloudExporter exporter(PointCloudFileFormat::PLY);
+  exporter.exportCloud(msg, fileName);
 }
 
 void saveDepthPointCloudMsgToPly(const sensor_msgs::PointCloud2 &msg, const std::string &fileName) {
-  FILE *fp = fopen(fileName.c_str(), "wb+");
-  CHECK_NOTNULL(fp);
-  sensor_msgs::PointCloud2ConstIterator<float> iter_x(msg, "x");
-  sensor_msgs::PointCloud2ConstIterator<float> iter_y(msg, "y");
-  sensor_msgs::PointCloud2ConstIterator<float> iter_z(msg, "z");
-
-  // First, count the actual number of valid points
-  size_t valid_points = 0;
-  for (; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z) {
-    if (!std::isnan(*iter_x) && !std::isnan(*iter_y) && !std::isnan(*iter_z)) {
-      ++valid_points;
-    }
-  }
-
-  // Reset the iterators
-  iter_x = sensor_msgs::PointCloud2ConstIterator<float>(msg, "x");
-  iter_y = sensor_msgs::PointCloud2ConstIterator<float>(msg, "y");
-  iter_z = sensor_msgs::PointCloud2ConstIterator<float>(msg, "z");
-
-  fprintf(fp, "ply\n");
-  fprintf(fp, "format ascii 1.0\n");
-  fprintf(fp, "element vertex %zu\n", valid_points);
-  fprintf(fp, "property float x\n");
-  fprintf(fp, "property float y\n");
-  fprintf(fp, "property float z\n");
-  fprintf(fp, "end_header\n");
-
-  for (; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z) {
-    if (!std::isnan(*iter_x) && !std::isnan(*iter_y) && !std::isnan(*iter_z)) {
-      fprintf(fp, "%.3f %.3f %.3f\n", *iter_x, *iter_y, *iter_z);
-    }
-  }
-
-  fflush(fp);
-  fclose(fp);
+  PointCloudExporter exporter(PointCloudFileFormat::PLY);
+  exporter.exportCloud(msg, fileName);
 }
 
 void savePointsToPly(std::shared_ptr<ob::Frame> frame, const std::string &fileName) {
+  CHECK_NOTNULL(frame.get());
   size_t point_size = frame->dataSize() / sizeof(OBPoint);
-  FILE *fp = fopen(fileName.c_str(), "wb+");
-  CHECK_NOTNULL(fp);
-  fprintf(fp, "ply\n");
-  fprintf(fp, "format ascii 1.0\n");
-  fprintf(fp, "element vertex %zu\n", point_size);
-  fprintf(fp, "property float x\n");
-  fprintf(fp, "property float y\n");
-  fprintf(fp, "property float z\n");
-  fprintf(fp, "end_header\n");
-
   auto *points = (OBPoint *)frame->data();
   CHECK_NOTNULL(points);
-  for (size_t i = 0; i < point_size; i++) {
-    fprintf(fp, "%.3f %.3f %.3f\n", points->x, points->y, points->z);
-    points++;
-  }
-
-  fflush(fp);
-  fclose(fp);
+  PointCloudExporter exporter(PointCloudFileFormat::PLY);
+  exporter.exportPoints(points, point_size, fileName);
 }
 
 tf2::Quaternion rotationMatrixToQuaternion(const float rotation[9]) {
@@ -755,6 +649,45 @@ float depthPrecisionFromString(const std::string &depth_precision_level_str) {
   return std::stof(depth_precision_level_str_num);
 }
 
+PointCloudEncoding pointCloudEncodingFromString(const std::string &encoding) {
+  std::string lower_encoding = encoding;
+  std::transform(lower_encoding.begin(), lower_encoding.end(), lower_encoding.begin(), ::tolower);
+  if (lower_encoding == "compact") {
+    return PointCloudEncoding::COMPACT;
+  } else if (lower_encoding == "float32" || lower_encoding.empty()) {
+    return PointCloudEncoding::FLOAT32;
+  } else {
+    ROS_ERROR_STREAM("Unknown point cloud encoding: " << encoding << ", use float32");
+    return PointCloudEncoding::FLOAT32;
+  }
+}
+
+IdlePolicy idlePolicyFromString(const std::string &policy) {
+  std::string lower_policy = policy;
+  std::transform(lower_policy.begin(), lower_policy.end(), lower_policy.begin(), ::tolower);
+  if (lower_policy == "standby") {
+    return IdlePolicy::STANDBY;
+  } else if (lower_policy == "stop") {
+    return IdlePolicy::STOP;
+  } else if (lower_policy == "keep") {
+    return IdlePolicy::KEEP;
+  } else {
+    ROS_ERROR_STREAM("Unknown idle policy: " << policy << ", use keep");
+    return IdlePolicy::KEEP;
+  }
+}
+
+std::string idlePolicyToString(IdlePolicy policy) {
+  switch (policy) {
+    case IdlePolicy::STANDBY:
+      return "standby";
+    case IdlePolicy::STOP:
+      return "stop";
+    default:
+      return "keep";
+  }
+}
+
 std::ostream &operator<<(std::ostream &os, const OBFormat &rhs) {
   os << OBFormatToString(rhs);
   return os;
@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include "orbbec_camera/worker_pool.h"
+
+#include <algorithm>
+
+namespace orbbec_camera {
+WorkerPool::WorkerPool(int num_workers) {
+  for (int i = 0; i < num_workers; i++) {
+    workers_.emplace_back([this]() { workerLoop(); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto &worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+void WorkerPool::parallelFor(int begin, int end, const std::function<void(int, int)> &fn) {
+  if (end <= begin) {
+    return;
+  }
+  if (workers_.empty() || end - begin < 2) {
+    fn(begin, end);
+    return;
+  }
+  Job job;
+  job.fn = &fn;
+  job.begin = begin;
+  job.end = end;
+  job.chunk_count = std::min(size(), end - begin);
+  job.pending_chunks = job.chunk_count;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(&job);
+  }
+  work_cv_.notify_all();
+  while (true) {
+    int chunk_begin = 0, chunk_end = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!claimChunkLocked(job, chunk_begin, chunk_end)) {
+        break;
+      }
+    }
+    fn(chunk_begin, chunk_end);
+    finishChunk(job);
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [&job]() { return job.pending_chunks == 0; });
+}
+
+void WorkerPool::workerLoop() {
+  while (true) {
+    Job *job = nullptr;
+    int chunk_begin = 0, chunk_end = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+      if (stop_) {
+        return;
+      }
+      job = jobs_.front();
+      claimChunkLocked(*job, chunk_begin, chunk_end);
+      // one chunk per turn, the next worker serves the next caller's job
+      if (!jobs_.empty() && jobs_.front() == job) {
+        jobs_.pop_front();
+        jobs_.push_back(job);
+      }
+    }
+    (*job->fn)(chunk_begin, chunk_end);
+    finishChunk(*job);
+  }
+}
+
+bool WorkerPool::claimChunkLocked(Job &job, int &chunk_begin, int &chunk_end) {
+  if (job.next_chunk >= job.chunk_count) {
+    return false;
+  }
+  const int chunk = job.next_chunk++;
+  const int total = job.end - job.begin;
+  chunk_begin = job.begin + static_cast<int>(static_cast<int64_t>(total) * chunk / job.chunk_count);
+  chunk_end =
+      job.begin + static_cast<int>(static_cast<int64_t>(total) * (chunk + 1) / job.chunk_count);
+  if (job.next_chunk == job.chunk_count) {
+    jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &job));
+  }
+  return true;
+}
+
+void WorkerPool::finishChunk(Job &job) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (--job.pending_chunks == 0) {
+    done_cv_.notify_all();
+  }
+}
+}  // namespace orbbec_camera
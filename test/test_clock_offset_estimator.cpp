@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/clock_offset_estimator.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+
+namespace orbbec_camera {
+namespace {
+// device clock starts at 1000 s, the host clock is 5000 s ahead of it and the device runs
+// 50 ppm slow
+const uint64_t kDeviceStartUs = 1000000000ULL;
+const double kOffsetUs = 5000e6;
+const double kSkewPpm = 50.0;
+const double kFramePeriodUs = 1e6 / 30.0;
+
+// host time of the capture at device_us, before any transfer latency
+double trueHostUs(uint64_t device_us) {
+  const double elapsed = static_cast<double>(device_us - kDeviceStartUs);
+  return static_cast<double>(device_us) + kOffsetUs + elapsed * kSkewPpm * 1e-6;
+}
+
+// feeds frames at 30 fps for the given seconds, latency_us draws the transfer latency of each
+void feed(ClockOffsetEstimator &estimator, uint64_t first_device_us, double seconds,
+          const std::function<double()> &latency_us) {
+  const int frames = static_cast<int>(seconds * 1e6 / kFramePeriodUs);
+  for (int i = 0; i < frames; i++) {
+    const auto device_us = first_device_us + static_cast<uint64_t>(i * kFramePeriodUs);
+    const auto host_us = static_cast<uint64_t>(std::llround(trueHostUs(device_us) + latency_us()));
+    estimator.addSample(device_us, host_us);
+  }
+}
+}  // namespace
+
+TEST(ClockOffsetEstimatorTest, NoHostTimeBeforeTheFirstSample) {
+  ClockOffsetEstimator estimator{ClockOffsetEstimator::Config()};
+  uint64_t host_us = 0;
+  EXPECT_FALSE(estimator.toHostTime(kDeviceStartUs, host_us));
+  EXPECT_FALSE(estimator.state().valid);
+}
+
+TEST(ClockOffsetEstimatorTest, RecoversOffsetAndDriftWithoutNoise) {
+  ClockOffsetEstimator estimator{ClockOffsetEstimator::Config()};
+  const double latency = 2000.0;
+  feed(estimator, kDeviceStartUs, 20.0, [&]() { return latency; });
+  const auto state = estimator.state();
+  ASSERT_TRUE(state.valid);
+  EXPECT_NEAR(state.skew, kSkewPpm, 0.1);
+  EXPECT_NEAR(state.latency, 0.0, 1e-5);
+  EXPECT_NEAR(state.jitter, 0.0, 1e-5);
+  // a constant latency can not be told apart from the offset, it stays in the mapping
+  const uint64_t device_us = kDeviceStartUs + 19000000;
+  uint64_t host_us = 0;
+  ASSERT_TRUE(estimator.toHostTime(device_us, host_us));
+  EXPECT_NEAR(static_cast<double>(host_us), trueHostUs(device_us) + latency, 2.0);
+}
+
+TEST(ClockOffsetEstimatorTest, FollowsTheLowerEnvelopeOfOneSidedLatency) {
+  ClockOffsetEstimator estimator{ClockOffsetEstimator::Config()};
+  // 1 ms minimum transfer, up to 15 ms more of USB and SDK queueing
+  std::mt19937 random(42);
+  std::exponential_distribution<double> queueing(1.0 / 3000.0);
+  const double min_latency = 1000.0;
+  feed(estimator, kDeviceStartUs, 25.0,
+       [&]() { return min_latency + std::min(queueing(random), 15000.0); });
+  const auto state = estimator.state();
+  ASSERT_TRUE(state.valid);
+  EXPECT_NEAR(state.skew, kSkewPpm, 2.0);
+  // the mean latency is reported above the line, not folded into it
+  EXPECT_GT(state.latency, 1e-3);
+  EXPECT_GT(state.jitter, 1e-3);
+  for (double t : {5.0, 12.5, 24.0}) {
+    const auto device_us = kDeviceStartUs + static_cast<uint64_t>(t * 1e6);
+    uint64_t host_us = 0;
+    ASSERT_TRUE(estimator.toHostTime(device_us, host_us));
+    // within a few hundred microseconds of the fastest arrival, far below the mean latency
+    EXPECT_NEAR(static_cast<double>(host_us), trueHostUs(device_us) + min_latency, 500.0)
+        << "at " << t << " s";
+  }
+}
+
+TEST(ClockOffsetEstimatorTest, ResetsWhenTheDeviceClockJumps) {
+  ClockOffsetEstimator estimator{ClockOffsetEstimator::Config()};
+  const double latency = 2000.0;
+  feed(estimator, kDeviceStartUs, 10.0, [&]() { return latency; });
+  EXPECT_EQ(estimator.state().resets, 0u);
+  // the device reboots and its clock starts over near zero, the host clock keeps going
+  const uint64_t rebooted_us = 1000;
+  const double host_at_reboot = trueHostUs(kDeviceStartUs + 10000000);
+  const int frames = 300;
+  for (int i = 0; i < frames; i++) {
+    const auto device_us = rebooted_us + static_cast<uint64_t>(i * kFramePeriodUs);
+    const auto host_us =
+        static_cast<uint64_t>(host_at_reboot + (device_us - rebooted_us) + latency);
+    estimator.addSample(device_us, host_us);
+  }
+  const auto state = estimator.state();
+  EXPECT_EQ(state.resets, 1u);
+  EXPECT_EQ(state.samples, static_cast<uint64_t>(frames));
+  const uint64_t device_us = rebooted_us + 9000000;
+  uint64_t host_us = 0;
+  ASSERT_TRUE(estimator.toHostTime(device_us, host_us));
+  EXPECT_NEAR(static_cast<double>(host_us), host_at_reboot + 9e6 + latency, 5.0);
+}
+
+TEST(ClockOffsetEstimatorTest, OutOfOrderSamplesOfAnotherStreamDoNotReset) {
+  ClockOffsetEstimator estimator{ClockOffsetEstimator::Config()};
+  feed(estimator, kDeviceStartUs, 5.0, []() { return 2000.0; });
+  // a late sample from a second stream, 40 ms older in device time
+  const uint64_t device_us = kDeviceStartUs + 4960000;
+  estimator.addSample(device_us, static_cast<uint64_t>(trueHostUs(device_us) + 50000.0));
+  EXPECT_EQ(estimator.state().resets, 0u);
+}
+
+TEST(ClockOffsetEstimatorTest, ResetForgetsTheModel) {
+  ClockOffsetEstimator estimator{ClockOffsetEstimator::Config()};
+  feed(estimator, kDeviceStartUs, 5.0, []() { return 2000.0; });
+  ASSERT_TRUE(estimator.state().valid);
+  estimator.reset();
+  const auto state = estimator.state();
+  EXPECT_FALSE(state.valid);
+  EXPECT_EQ(state.samples, 0u);
+  uint64_t host_us = 0;
+  EXPECT_FALSE(estimator.toHostTime(kDeviceStartUs, host_us));
+}
+}  // namespace orbbec_camera
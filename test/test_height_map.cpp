@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/height_map.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+namespace orbbec_camera {
+namespace {
+const int kWidth = 640;
+const int kHeight = 480;
+const uint16_t kFloorDepth = 1200;  // millimeters, camera 1.2 m above the floor
+const uint16_t kBoxDepth = 700;     // top of a 0.5 m box under the image center
+
+OBCameraIntrinsic makeIntrinsic(int width, int height) {
+  OBCameraIntrinsic intrinsic{};
+  intrinsic.fx = 400.0f;
+  intrinsic.fy = 400.0f;
+  intrinsic.cx = width / 2.0f;
+  intrinsic.cy = height / 2.0f;
+  intrinsic.width = static_cast<int16_t>(width);
+  intrinsic.height = static_cast<int16_t>(height);
+  return intrinsic;
+}
+
+// Camera looking straight down from 1.2 m, optical x along grid x and optical y along -grid y.
+tf2::Transform downwardCamera() {
+  return tf2::Transform(tf2::Matrix3x3(1, 0, 0, 0, -1, 0, 0, 0, -1), tf2::Vector3(1.0, 0.0, 1.2));
+}
+
+std::vector<uint16_t> floorWithBox(int width, int height) {
+  std::vector<uint16_t> depth(static_cast<size_t>(width) * height, kFloorDepth);
+  for (int v = height / 2 - 20; v < height / 2 + 20; v++) {
+    for (int u = width / 2 - 20; u < width / 2 + 20; u++) {
+      depth[static_cast<size_t>(v) * width + u] = kBoxDepth;
+    }
+  }
+  return depth;
+}
+
+// what the node's RayTableCache hands out for this frame size
+void setRayTable(HeightMapProjector &projector, int width, int height) {
+  projector.setRayTable(std::make_shared<RayTable>(RayTable::makeKey(
+      makeIntrinsic(width, height), width, height, projector.transform().getBasis())));
+}
+
+void setupProjector(HeightMapProjector &projector, int width, int height) {
+  projector.setConfig(HeightMapProjector::Config());
+  projector.setTransform(downwardCamera());
+  setRayTable(projector, width, height);
+}
+
+int8_t cellAt(const nav_msgs::OccupancyGrid &grid, int x, int y) {
+  return grid.data[static_cast<size_t>(y) * grid.info.width + x];
+}
+}  // namespace
+
+TEST(HeightMapProjectorTest, FloorAndBoxLandInExpectedCells) {
+  HeightMapProjector projector(4);
+  setupProjector(projector, kWidth, kHeight);
+  const auto depth = floorWithBox(kWidth, kHeight);
+  nav_msgs::OccupancyGrid grid;
+  ASSERT_TRUE(projector.project(depth.data(), kWidth, kHeight, 1.0f, grid));
+
+  EXPECT_EQ(grid.info.width, 100u);
+  EXPECT_EQ(grid.info.height, 100u);
+  EXPECT_FLOAT_EQ(grid.info.resolution, 0.02f);
+  ASSERT_EQ(grid.data.size(), 100u * 100u);
+  // box top at 0.5 m of a 0..1 m range, floor at 0
+  EXPECT_EQ(cellAt(grid, 50, 50), 50);
+  EXPECT_EQ(cellAt(grid, 10, 50), 0);
+  EXPECT_EQ(cellAt(grid, 90, 20), 0);
+  // the footprint at 1.2 m is +-0.72 m along y, the grid edges stay unobserved
+  EXPECT_EQ(cellAt(grid, 50, 0), -1);
+  EXPECT_EQ(cellAt(grid, 50, 99), -1);
+  // every pixel falls inside the grid
+  EXPECT_EQ(projector.lastCellUpdates(), static_cast<uint64_t>(kWidth) * kHeight);
+}
+
+TEST(HeightMapProjectorTest, IgnoresInvalidAndOutOfRangeDepth) {
+  HeightMapProjector projector(2);
+  auto config = HeightMapProjector::Config();
+  config.range_max = 1.0;
+  projector.setConfig(config);
+  projector.setTransform(downwardCamera());
+  setRayTable(projector, kWidth, kHeight);
+  auto depth = floorWithBox(kWidth, kHeight);
+  depth[0] = 0;
+  nav_msgs::OccupancyGrid grid;
+  ASSERT_TRUE(projector.project(depth.data(), kWidth, kHeight, 1.0f, grid));
+  // only the box is within range_max, the floor is dropped
+  EXPECT_EQ(projector.lastCellUpdates(), 40u * 40u);
+  EXPECT_EQ(cellAt(grid, 50, 50), 50);
+  EXPECT_EQ(cellAt(grid, 10, 50), -1);
+}
+
+TEST(HeightMapProjectorTest, AppliesDepthScale) {
+  HeightMapProjector projector(1);
+  setupProjector(projector, kWidth, kHeight);
+  // 0.1 mm units, the box top is at 0.7 m again
+  std::vector<uint16_t> depth(static_cast<size_t>(kWidth) * kHeight, kBoxDepth * 10);
+  nav_msgs::OccupancyGrid grid;
+  ASSERT_TRUE(projector.project(depth.data(), kWidth, kHeight, 0.1f, grid));
+  EXPECT_EQ(cellAt(grid, 50, 50), 50);
+}
+
+TEST(HeightMapProjectorTest, ThreadCountDoesNotChangeTheGrid) {
+  const auto depth = floorWithBox(kWidth, kHeight);
+  nav_msgs::OccupancyGrid single, multi;
+  HeightMapProjector single_thread(1);
+  setupProjector(single_thread, kWidth, kHeight);
+  ASSERT_TRUE(single_thread.project(depth.data(), kWidth, kHeight, 1.0f, single));
+  HeightMapProjector multi_thread(std::make_shared<WorkerPool>(4));
+  setupProjector(multi_thread, kWidth, kHeight);
+  ASSERT_TRUE(multi_thread.project(depth.data(), kWidth, kHeight, 1.0f, multi));
+  EXPECT_EQ(single.data, multi.data);
+  EXPECT_EQ(single_thread.lastCellUpdates(), multi_thread.lastCellUpdates());
+}
+
+TEST(HeightMapProjectorTest, RejectsFramesOfAnotherSize) {
+  HeightMapProjector projector(1);
+  nav_msgs::OccupancyGrid grid;
+  std::vector<uint16_t> depth(static_cast<size_t>(kWidth) * kHeight, kFloorDepth);
+  // no ray table yet
+  EXPECT_FALSE(projector.project(depth.data(), kWidth, kHeight, 1.0f, grid));
+  setupProjector(projector, kWidth, kHeight);
+  EXPECT_FALSE(projector.project(depth.data(), kWidth / 2, kHeight / 2, 1.0f, grid));
+}
+
+// Full sensor resolution, several frames through the same projector so reused buffers are
+// covered: every pool size yields the single-threaded grid.
+TEST(HeightMapProjectorTest, FullResolutionGridIndependentOfThreadCount) {
+  const int width = 1280;
+  const int height = 800;
+  const int frames = 3;
+  const auto depth = floorWithBox(width, height);
+  HeightMapProjector reference(1);
+  setupProjector(reference, width, height);
+  nav_msgs::OccupancyGrid expected;
+  ASSERT_TRUE(reference.project(depth.data(), width, height, 1.0f, expected));
+  ASSERT_GT(reference.lastCellUpdates(), 0u);
+  for (int threads : {2, 4}) {
+    HeightMapProjector projector(threads);
+    setupProjector(projector, width, height);
+    for (int i = 0; i < frames; i++) {
+      nav_msgs::OccupancyGrid grid;
+      ASSERT_TRUE(projector.project(depth.data(), width, height, 1.0f, grid));
+      EXPECT_EQ(grid.data, expected.data) << threads << " threads, frame " << i;
+      EXPECT_EQ(projector.lastCellUpdates(), reference.lastCellUpdates());
+    }
+  }
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,246 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/imu_unifier.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace orbbec_camera {
+namespace {
+struct Output {
+  double time;
+  double accel[3];
+};
+
+ImuUnifier::Sample makeSample(double time, double x, double y, double z) {
+  ImuUnifier::Sample sample;
+  sample.time = time;
+  sample.value[0] = x;
+  sample.value[1] = y;
+  sample.value[2] = z;
+  return sample;
+}
+
+class ImuUnifierTest : public ::testing::Test {
+ protected:
+  void addGyro(ImuUnifier &unifier, double time) {
+    unifier.addGyro(makeSample(time, 0, 0, 0),
+                    [this](const ImuUnifier::Sample &gyro, const double accel[3]) {
+                      outputs_.push_back({gyro.time, {accel[0], accel[1], accel[2]}});
+                    });
+  }
+
+  std::vector<Output> outputs_;
+};
+}  // namespace
+
+TEST(ImuUnifierMethodTest, ParsesMethodNames) {
+  ImuUnifier::Method method = ImuUnifier::Method::COPY;
+  EXPECT_TRUE(imuUnifierMethodFromString("", method));
+  EXPECT_EQ(method, ImuUnifier::Method::NONE);
+  EXPECT_TRUE(imuUnifierMethodFromString("none", method));
+  EXPECT_EQ(method, ImuUnifier::Method::NONE);
+  EXPECT_TRUE(imuUnifierMethodFromString("copy", method));
+  EXPECT_EQ(method, ImuUnifier::Method::COPY);
+  EXPECT_TRUE(imuUnifierMethodFromString("linear_interpolation", method));
+  EXPECT_EQ(method, ImuUnifier::Method::LINEAR_INTERPOLATION);
+  EXPECT_FALSE(imuUnifierMethodFromString("cubic", method));
+}
+
+TEST_F(ImuUnifierTest, NoneNeverOutputs) {
+  ImuUnifier unifier(ImuUnifier::Method::NONE);
+  unifier.addAccel(makeSample(0.0, 1, 2, 3));
+  addGyro(unifier, 0.001);
+  EXPECT_TRUE(outputs_.empty());
+}
+
+TEST_F(ImuUnifierTest, CopyPairsEachGyroWithLatestAccel) {
+  ImuUnifier unifier(ImuUnifier::Method::COPY);
+  // nothing to pair with, dropped
+  addGyro(unifier, 0.0);
+  unifier.addAccel(makeSample(0.001, 1, 2, 3));
+  addGyro(unifier, 0.0025);
+  addGyro(unifier, 0.005);
+  unifier.addAccel(makeSample(0.0075, 4, 5, 6));
+  unifier.addAccel(makeSample(0.01, 7, 8, 9));
+  addGyro(unifier, 0.0075);
+  ASSERT_EQ(outputs_.size(), 3u);
+  EXPECT_DOUBLE_EQ(outputs_[0].time, 0.0025);
+  EXPECT_DOUBLE_EQ(outputs_[0].accel[0], 1);
+  EXPECT_DOUBLE_EQ(outputs_[1].time, 0.005);
+  EXPECT_DOUBLE_EQ(outputs_[1].accel[2], 3);
+  // the latest accel sample, even when it is newer than the gyro sample
+  EXPECT_DOUBLE_EQ(outputs_[2].time, 0.0075);
+  EXPECT_DOUBLE_EQ(outputs_[2].accel[0], 7);
+  EXPECT_DOUBLE_EQ(outputs_[2].accel[1], 8);
+  EXPECT_DOUBLE_EQ(outputs_[2].accel[2], 9);
+}
+
+TEST_F(ImuUnifierTest, LinearInterpolationWaitsForBracketingAccel) {
+  ImuUnifier unifier(ImuUnifier::Method::LINEAR_INTERPOLATION);
+  unifier.addAccel(makeSample(0.0, 0, 0, 10));
+  addGyro(unifier, 0.0);
+  addGyro(unifier, 0.0025);
+  addGyro(unifier, 0.005);
+  // only the sample at the accel timestamp is complete
+  ASSERT_EQ(outputs_.size(), 1u);
+  EXPECT_DOUBLE_EQ(outputs_[0].accel[2], 10);
+  unifier.addAccel(makeSample(0.01, 4, -8, 20));
+  addGyro(unifier, 0.0075);
+  ASSERT_EQ(outputs_.size(), 4u);
+  const double expected_ratio[] = {0.0, 0.25, 0.5, 0.75};
+  for (size_t i = 0; i < outputs_.size(); i++) {
+    EXPECT_DOUBLE_EQ(outputs_[i].time, 0.0025 * i);
+    EXPECT_NEAR(outputs_[i].accel[0], 4 * expected_ratio[i], 1e-12);
+    EXPECT_NEAR(outputs_[i].accel[1], -8 * expected_ratio[i], 1e-12);
+    EXPECT_NEAR(outputs_[i].accel[2], 10 + 10 * expected_ratio[i], 1e-12);
+  }
+}
+
+TEST_F(ImuUnifierTest, LinearInterpolationHoldsOldestAccelForEarlierGyro) {
+  ImuUnifier unifier(ImuUnifier::Method::LINEAR_INTERPOLATION);
+  unifier.addAccel(makeSample(0.01, 1, 2, 3));
+  addGyro(unifier, 0.005);
+  ASSERT_EQ(outputs_.size(), 1u);
+  EXPECT_DOUBLE_EQ(outputs_[0].accel[0], 1);
+  EXPECT_DOUBLE_EQ(outputs_[0].accel[2], 3);
+}
+
+TEST_F(ImuUnifierTest, StalledAccelFlushesPendingGyroWithLatestAccel) {
+  ImuUnifier unifier(ImuUnifier::Method::LINEAR_INTERPOLATION, 4);
+  unifier.addAccel(makeSample(0.0, 1, 2, 3));
+  addGyro(unifier, 0.0);
+  for (int i = 1; i <= 4; i++) {
+    addGyro(unifier, 0.0025 * i);
+  }
+  // four gyro samples fill the pending ring, the fifth forces them out with a copy
+  ASSERT_EQ(outputs_.size(), 1u);
+  addGyro(unifier, 0.0125);
+  ASSERT_EQ(outputs_.size(), 5u);
+  for (size_t i = 1; i < outputs_.size(); i++) {
+    EXPECT_DOUBLE_EQ(outputs_[i].time, 0.0025 * i);
+    EXPECT_DOUBLE_EQ(outputs_[i].accel[1], 2);
+  }
+}
+
+TEST_F(ImuUnifierTest, CountsAccelRingOverflows) {
+  ImuUnifier unifier(ImuUnifier::Method::COPY, 4);
+  for (int i = 0; i < 6; i++) {
+    unifier.addAccel(makeSample(0.01 * i, i, 0, 0));
+  }
+  EXPECT_EQ(unifier.accelOverflows(), 2u);
+  // the ring keeps the oldest samples, the latest one that made it in is paired
+  addGyro(unifier, 0.05);
+  ASSERT_EQ(outputs_.size(), 1u);
+  EXPECT_DOUBLE_EQ(outputs_[0].accel[0], 3);
+  // drained, there is room again
+  unifier.addAccel(makeSample(0.06, 6, 0, 0));
+  EXPECT_EQ(unifier.accelOverflows(), 2u);
+}
+
+TEST_F(ImuUnifierTest, ResetDropsQueuedSamples) {
+  ImuUnifier unifier(ImuUnifier::Method::LINEAR_INTERPOLATION);
+  unifier.addAccel(makeSample(0.0, 1, 1, 1));
+  addGyro(unifier, 0.005);
+  unifier.reset();
+  unifier.addAccel(makeSample(0.01, 2, 2, 2));
+  // the gyro sample held before the reset is gone
+  addGyro(unifier, 0.01);
+  ASSERT_EQ(outputs_.size(), 1u);
+  EXPECT_DOUBLE_EQ(outputs_[0].time, 0.01);
+  EXPECT_DOUBLE_EQ(outputs_[0].accel[0], 2);
+}
+
+// Accel at 100 Hz arriving 7 ms after capture, gyro at 400 Hz arriving after 1 ms, accel
+// values equal to their timestamps. The callbacks are replayed in arrival order, so the
+// interleaving is the same on every run.
+TEST_F(ImuUnifierTest, InterleavedStreamsStayOrdered) {
+  const double accel_delay = 0.007;
+  const double gyro_delay = 0.001;
+  for (auto method : {ImuUnifier::Method::COPY, ImuUnifier::Method::LINEAR_INTERPOLATION}) {
+    outputs_.clear();
+    ImuUnifier unifier(method);
+    int accel = 0;
+    int gyro = 0;
+    while (gyro < 400) {
+      const double accel_time = accel * 0.01;
+      const double gyro_time = gyro * 0.0025;
+      if (accel <= 100 && accel_time + accel_delay <= gyro_time + gyro_delay) {
+        unifier.addAccel(makeSample(accel_time, accel_time, accel_time, accel_time));
+        accel++;
+      } else {
+        addGyro(unifier, gyro_time);
+        gyro++;
+      }
+    }
+    EXPECT_EQ(unifier.accelOverflows(), 0u);
+    // gyro samples at 0, 2.5 and 5 ms arrive before the first accel sample and are dropped,
+    // interpolation still holds the ones after the last accel sample that arrived (990 ms)
+    const bool interpolate = method == ImuUnifier::Method::LINEAR_INTERPOLATION;
+    ASSERT_EQ(outputs_.size(), interpolate ? 394u : 397u);
+    EXPECT_DOUBLE_EQ(outputs_.front().time, 0.0075);
+    EXPECT_DOUBLE_EQ(outputs_.back().time, interpolate ? 0.99 : 0.9975);
+    for (size_t i = 1; i < outputs_.size(); i++) {
+      EXPECT_LT(outputs_[i - 1].time, outputs_[i].time);
+    }
+    for (const auto &output : outputs_) {
+      if (interpolate) {
+        EXPECT_NEAR(output.accel[0], output.time, 1e-9);
+      } else {
+        // the newest accel sample that had arrived with the gyro sample
+        const double newest = std::floor((output.time + gyro_delay - accel_delay) / 0.01 + 1e-9);
+        EXPECT_NEAR(output.accel[0], newest * 0.01, 1e-9) << "gyro at " << output.time;
+      }
+    }
+  }
+}
+
+// Both streams from their own threads with no pacing, only what holds under any interleaving
+// is checked. The rings are large enough that nothing overflows or is flushed early.
+TEST_F(ImuUnifierTest, ConcurrentStreamsStayOrdered) {
+  for (auto method : {ImuUnifier::Method::COPY, ImuUnifier::Method::LINEAR_INTERPOLATION}) {
+    outputs_.clear();
+    ImuUnifier unifier(method, 512);
+    std::thread accel_thread([&unifier] {
+      for (int i = 0; i <= 100; i++) {
+        const double time = i * 0.01;
+        unifier.addAccel(makeSample(time, time, time, time));
+      }
+    });
+    for (int i = 0; i < 400; i++) {
+      addGyro(unifier, i * 0.0025);
+    }
+    accel_thread.join();
+    addGyro(unifier, 1.0);
+    EXPECT_EQ(unifier.accelOverflows(), 0u);
+    ASSERT_FALSE(outputs_.empty());
+    EXPECT_DOUBLE_EQ(outputs_.back().time, 1.0);
+    for (size_t i = 1; i < outputs_.size(); i++) {
+      EXPECT_LT(outputs_[i - 1].time, outputs_[i].time);
+      // accel only moves forward
+      EXPECT_LE(outputs_[i - 1].accel[0], outputs_[i].accel[0]);
+    }
+    if (method == ImuUnifier::Method::LINEAR_INTERPOLATION) {
+      for (const auto &output : outputs_) {
+        EXPECT_NEAR(output.accel[0], output.time, 1e-9);
+      }
+    }
+  }
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,319 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/point_cloud_exporter.h"
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace orbbec_camera {
+namespace {
+struct FilePoint {
+  float x = 0, y = 0, z = 0;
+  uint8_t r = 0, g = 0, b = 0;
+};
+
+struct ParsedFile {
+  std::vector<std::string> fields;
+  std::vector<FilePoint> points;
+};
+
+std::string readFile(const std::string &filename) {
+  std::ifstream file(filename, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Minimal reader for what the exporter writes, independent of its header code.
+ParsedFile parsePly(const std::string &filename) {
+  ParsedFile parsed;
+  const std::string content = readFile(filename);
+  const std::string end_header = "end_header\n";
+  const size_t body_offset = content.find(end_header);
+  EXPECT_NE(body_offset, std::string::npos);
+  std::istringstream header(content.substr(0, body_offset));
+  std::string line;
+  size_t count = 0;
+  std::getline(header, line);
+  EXPECT_EQ(line, "ply");
+  while (std::getline(header, line)) {
+    std::istringstream words(line);
+    std::string keyword;
+    words >> keyword;
+    if (keyword == "format") {
+      std::string format;
+      words >> format;
+      EXPECT_EQ(format, "binary_little_endian");
+    } else if (keyword == "element") {
+      std::string element;
+      words >> element >> count;
+      EXPECT_EQ(element, "vertex");
+    } else if (keyword == "property") {
+      std::string type, name;
+      words >> type >> name;
+      EXPECT_EQ(type, name == "red" || name == "green" || name == "blue" ? "uchar" : "float");
+      parsed.fields.push_back(name);
+    }
+  }
+  const bool with_color = parsed.fields.size() == 6;
+  const size_t record_size = 3 * sizeof(float) + (with_color ? 3 : 0);
+  const char *body = content.data() + body_offset + end_header.size();
+  EXPECT_EQ(content.size() - (body - content.data()), count * record_size);
+  for (size_t i = 0; i < count; i++, body += record_size) {
+    FilePoint point;
+    std::memcpy(&point.x, body, sizeof(float));
+    std::memcpy(&point.y, body + 4, sizeof(float));
+    std::memcpy(&point.z, body + 8, sizeof(float));
+    if (with_color) {
+      point.r = static_cast<uint8_t>(body[12]);
+      point.g = static_cast<uint8_t>(body[13]);
+      point.b = static_cast<uint8_t>(body[14]);
+    }
+    parsed.points.push_back(point);
+  }
+  return parsed;
+}
+
+ParsedFile parsePcd(const std::string &filename) {
+  ParsedFile parsed;
+  const std::string content = readFile(filename);
+  const std::string data_line = "DATA binary\n";
+  const size_t data_offset = content.find(data_line);
+  EXPECT_NE(data_offset, std::string::npos);
+  std::istringstream header(content.substr(0, data_offset));
+  std::string line;
+  size_t count = 0;
+  while (std::getline(header, line)) {
+    std::istringstream words(line);
+    std::string keyword;
+    words >> keyword;
+    if (keyword == "FIELDS") {
+      std::string name;
+      while (words >> name) {
+        parsed.fields.push_back(name);
+      }
+    } else if (keyword == "POINTS") {
+      words >> count;
+    } else if (keyword == "SIZE" || keyword == "COUNT") {
+      std::string value;
+      while (words >> value) {
+        EXPECT_EQ(value, keyword == "SIZE" ? "4" : "1");
+      }
+    }
+  }
+  const bool with_color = parsed.fields.size() == 4;
+  const size_t record_size = (with_color ? 4 : 3) * sizeof(float);
+  const char *body = content.data() + data_offset + data_line.size();
+  EXPECT_EQ(content.size() - (body - content.data()), count * record_size);
+  for (size_t i = 0; i < count; i++, body += record_size) {
+    FilePoint point;
+    std::memcpy(&point.x, body, sizeof(float));
+    std::memcpy(&point.y, body + 4, sizeof(float));
+    std::memcpy(&point.z, body + 8, sizeof(float));
+    if (with_color) {
+      uint32_t packed;
+      std::memcpy(&packed, body + 12, sizeof(packed));
+      point.r = static_cast<uint8_t>(packed >> 16);
+      point.g = static_cast<uint8_t>(packed >> 8);
+      point.b = static_cast<uint8_t>(packed);
+    }
+    parsed.points.push_back(point);
+  }
+  return parsed;
+}
+
+// 4x3 float32 x/y/z/rgb cloud, every third point NaN.
+sensor_msgs::PointCloud2 makeColorCloud(std::vector<FilePoint> &expected) {
+  sensor_msgs::PointCloud2 msg;
+  int offset = sensor_msgs::addPointField(msg, "x", 1, sensor_msgs::PointField::FLOAT32, 0);
+  offset = sensor_msgs::addPointField(msg, "y", 1, sensor_msgs::PointField::FLOAT32, offset);
+  offset = sensor_msgs::addPointField(msg, "z", 1, sensor_msgs::PointField::FLOAT32, offset);
+  offset = sensor_msgs::addPointField(msg, "rgb", 1, sensor_msgs::PointField::FLOAT32, offset);
+  msg.point_step = static_cast<uint32_t>(offset);
+  msg.width = 4;
+  msg.height = 3;
+  msg.row_step = msg.width * msg.point_step;
+  msg.data.resize(msg.row_step * msg.height);
+  for (uint32_t i = 0; i < msg.width * msg.height; i++) {
+    uint8_t *point = msg.data.data() + i * msg.point_step;
+    FilePoint value;
+    value.x = 0.25f * i - 1.0f;
+    value.y = -0.5f * i;
+    value.z = 1.0f + 0.125f * i;
+    value.r = static_cast<uint8_t>(10 * i);
+    value.g = static_cast<uint8_t>(255 - i);
+    value.b = static_cast<uint8_t>(i * i);
+    float xyz[3] = {value.x, value.y, value.z};
+    if (i % 3 == 0) {
+      xyz[2] = std::numeric_limits<float>::quiet_NaN();
+    } else {
+      expected.push_back(value);
+    }
+    const uint32_t rgb = (static_cast<uint32_t>(value.r) << 16) |
+                         (static_cast<uint32_t>(value.g) << 8) | value.b;
+    std::memcpy(point, xyz, sizeof(xyz));
+    std::memcpy(point + 12, &rgb, sizeof(rgb));
+  }
+  return msg;
+}
+
+void expectSamePoints(const std::vector<FilePoint> &expected, const std::vector<FilePoint> &actual,
+                      bool with_color) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_FLOAT_EQ(expected[i].x, actual[i].x) << "point " << i;
+    EXPECT_FLOAT_EQ(expected[i].y, actual[i].y) << "point " << i;
+    EXPECT_FLOAT_EQ(expected[i].z, actual[i].z) << "point " << i;
+    if (with_color) {
+      EXPECT_EQ(expected[i].r, actual[i].r) << "point " << i;
+      EXPECT_EQ(expected[i].g, actual[i].g) << "point " << i;
+      EXPECT_EQ(expected[i].b, actual[i].b) << "point " << i;
+    }
+  }
+}
+
+class PointCloudExporterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char directory[] = "/tmp/point_cloud_exporter_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    directory_ = directory;
+  }
+
+  void TearDown() override {
+    for (const auto &file : files_) {
+      unlink(file.c_str());
+    }
+    rmdir(directory_.c_str());
+  }
+
+  std::string path(const std::string &name) {
+    files_.push_back(directory_ + "/" + name);
+    return files_.back();
+  }
+
+  std::string directory_;
+  std::vector<std::string> files_;
+};
+}  // namespace
+
+TEST_F(PointCloudExporterTest, ColorCloudRoundTripsThroughPly) {
+  std::vector<FilePoint> expected;
+  auto msg = makeColorCloud(expected);
+  PointCloudExporter exporter(PointCloudFileFormat::PLY);
+  const std::string filename = path("color.ply");
+  EXPECT_EQ(exporter.exportCloud(msg, filename), expected.size());
+  auto parsed = parsePly(filename);
+  EXPECT_EQ(parsed.fields, (std::vector<std::string>{"x", "y", "z", "red", "green", "blue"}));
+  expectSamePoints(expected, parsed.points, true);
+  EXPECT_GT(exporter.lastThroughput(), 0.0);
+}
+
+TEST_F(PointCloudExporterTest, ColorCloudRoundTripsThroughPcd) {
+  std::vector<FilePoint> expected;
+  auto msg = makeColorCloud(expected);
+  PointCloudExporter exporter(PointCloudFileFormat::PCD);
+  const std::string filename = path("color.pcd");
+  EXPECT_EQ(exporter.exportCloud(msg, filename), expected.size());
+  auto parsed = parsePcd(filename);
+  EXPECT_EQ(parsed.fields, (std::vector<std::string>{"x", "y", "z", "rgb"}));
+  expectSamePoints(expected, parsed.points, true);
+}
+
+TEST_F(PointCloudExporterTest, CompactCloudIsWrittenInMeters) {
+  sensor_msgs::PointCloud2 msg;
+  int offset = sensor_msgs::addPointField(msg, "x", 1, sensor_msgs::PointField::INT16, 0);
+  offset = sensor_msgs::addPointField(msg, "y", 1, sensor_msgs::PointField::INT16, offset);
+  offset = sensor_msgs::addPointField(msg, "z", 1, sensor_msgs::PointField::INT16, offset);
+  msg.point_step = static_cast<uint32_t>(offset);
+  msg.width = 3;
+  msg.height = 1;
+  const int16_t values[3][3] = {{-1000, 250, 1500}, {0, 0, 0}, {32, -64, 32767}};
+  msg.data.resize(sizeof(values));
+  std::memcpy(msg.data.data(), values, sizeof(values));
+  std::vector<FilePoint> expected(2);
+  expected[0].x = -1.0f;
+  expected[0].y = 0.25f;
+  expected[0].z = 1.5f;
+  expected[1].x = 0.032f;
+  expected[1].y = -0.064f;
+  expected[1].z = 32.767f;
+  for (auto format : {PointCloudFileFormat::PLY, PointCloudFileFormat::PCD}) {
+    PointCloudExporter exporter(format);
+    const std::string filename = path("compact" + exporter.extension());
+    EXPECT_EQ(exporter.exportCloud(msg, filename), 2u);
+    auto parsed =
+        format == PointCloudFileFormat::PLY ? parsePly(filename) : parsePcd(filename);
+    EXPECT_EQ(parsed.fields.size(), 3u);
+    expectSamePoints(expected, parsed.points, false);
+  }
+}
+
+TEST_F(PointCloudExporterTest, SdkColorPointsKeepMillimeters) {
+  std::vector<OBColorPoint> points(5);
+  std::vector<FilePoint> expected;
+  for (size_t i = 0; i < points.size(); i++) {
+    points[i].x = 100.0f * i;
+    points[i].y = -3.5f * i;
+    points[i].z = 900.0f + i;
+    points[i].r = 20.0f * i;
+    points[i].g = 255.0f;
+    points[i].b = 7.0f;
+    FilePoint point;
+    point.x = points[i].x;
+    point.y = points[i].y;
+    point.z = points[i].z;
+    point.r = static_cast<uint8_t>(points[i].r);
+    point.g = 255;
+    point.b = 7;
+    expected.push_back(point);
+  }
+  PointCloudExporter exporter(PointCloudFileFormat::PLY);
+  const std::string filename = path("sdk.ply");
+  EXPECT_EQ(exporter.exportPoints(points.data(), points.size(), filename), points.size());
+  expectSamePoints(expected, parsePly(filename).points, true);
+}
+
+TEST_F(PointCloudExporterTest, SequenceNumbersConsecutiveFiles) {
+  std::vector<FilePoint> expected;
+  auto msg = makeColorCloud(expected);
+  PointCloudExporter exporter(PointCloudFileFormat::PCD);
+  exporter.startSequence(directory_ + "/cloud");
+  const std::string first = exporter.exportNext(msg);
+  const std::string second = exporter.exportNext(msg);
+  files_.push_back(first);
+  files_.push_back(second);
+  EXPECT_EQ(first, directory_ + "/cloud_000000.pcd");
+  EXPECT_EQ(second, directory_ + "/cloud_000001.pcd");
+  expectSamePoints(expected, parsePcd(second).points, true);
+  EXPECT_GT(exporter.averageThroughput(), 0.0);
+}
+
+TEST_F(PointCloudExporterTest, RejectsCloudsWithoutXyz) {
+  sensor_msgs::PointCloud2 msg;
+  sensor_msgs::addPointField(msg, "intensity", 1, sensor_msgs::PointField::FLOAT32, 0);
+  PointCloudExporter exporter;
+  EXPECT_THROW(exporter.exportCloud(msg, path("invalid.ply")), std::runtime_error);
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,175 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/profile_planner.h"
+
+#include <gtest/gtest.h>
+#include <utility>
+#include <vector>
+
+namespace orbbec_camera {
+namespace {
+ProfilePlanner::Profile makeProfile(uint32_t width, uint32_t height, uint32_t fps,
+                                    OBFormat format) {
+  ProfilePlanner::Profile profile;
+  profile.width = width;
+  profile.height = height;
+  profile.fps = fps;
+  profile.format = format;
+  return profile;
+}
+
+// what a Gemini 330 offers, trimmed
+ProfilePlanner::Stream colorStream() {
+  ProfilePlanner::Stream stream;
+  stream.name = "color";
+  stream.requested = makeProfile(1280, 720, 30, OB_FORMAT_RGB);
+  stream.fallback_formats = {OB_FORMAT_MJPG};
+  const std::vector<std::pair<uint32_t, uint32_t>> resolutions{
+      {1280, 720}, {640, 360}, {1920, 1080}, {640, 480}};
+  for (auto format : {OB_FORMAT_RGB, OB_FORMAT_MJPG, OB_FORMAT_YUYV}) {
+    for (const auto &resolution : resolutions) {
+      for (uint32_t fps : {30, 15, 5}) {
+        stream.candidates.push_back(
+            makeProfile(resolution.first, resolution.second, fps, format));
+      }
+    }
+  }
+  return stream;
+}
+
+ProfilePlanner::Stream depthStream() {
+  ProfilePlanner::Stream stream;
+  stream.name = "depth";
+  stream.requested = makeProfile(848, 480, 30, OB_FORMAT_Y16);
+  const std::vector<std::pair<uint32_t, uint32_t>> resolutions{
+      {848, 480}, {424, 240}, {1280, 800}};
+  for (const auto &resolution : resolutions) {
+    for (uint32_t fps : {30, 15, 5}) {
+      stream.candidates.push_back(
+          makeProfile(resolution.first, resolution.second, fps, OB_FORMAT_Y16));
+    }
+  }
+  return stream;
+}
+
+const ProfilePlanner::Profile &chosen(const ProfilePlanner::Stream &stream,
+                                      const ProfilePlanner::Choice &choice) {
+  return stream.candidates.at(static_cast<size_t>(choice.candidate));
+}
+}  // namespace
+
+TEST(ProfilePlannerTest, KeepsTheRequestedProfileWithinBudget) {
+  std::vector<ProfilePlanner::Stream> streams{colorStream(), depthStream()};
+  auto plan = ProfilePlanner::plan(streams, 400.0);
+  ASSERT_EQ(plan.choices.size(), 2u);
+  EXPECT_TRUE(plan.fits);
+  for (size_t i = 0; i < streams.size(); i++) {
+    const auto &choice = plan.choices[i];
+    ASSERT_GE(choice.candidate, 0);
+    EXPECT_TRUE(choice.exact);
+    EXPECT_FALSE(choice.degraded);
+    const auto &profile = chosen(streams[i], choice);
+    EXPECT_EQ(profile.width, streams[i].requested.width);
+    EXPECT_EQ(profile.height, streams[i].requested.height);
+    EXPECT_EQ(profile.fps, streams[i].requested.fps);
+    EXPECT_EQ(profile.format, streams[i].requested.format);
+  }
+  EXPECT_NEAR(plan.total_mb_per_s, plan.choices[0].mb_per_s + plan.choices[1].mb_per_s, 1e-6);
+}
+
+TEST(ProfilePlannerTest, WildcardTakesTheFirstCandidate) {
+  ProfilePlanner::Stream ir;
+  ir.name = "ir";
+  ir.candidates = {makeProfile(848, 480, 30, OB_FORMAT_Y8),
+                   makeProfile(640, 400, 30, OB_FORMAT_Y8)};
+  auto plan = ProfilePlanner::plan({ir}, 0.0);
+  ASSERT_EQ(plan.choices[0].candidate, 0);
+  EXPECT_TRUE(plan.choices[0].exact);
+}
+
+TEST(ProfilePlannerTest, UnsupportedRequestFallsBackToTheClosestProfile) {
+  auto depth = depthStream();
+  depth.requested = makeProfile(999, 999, 60, OB_FORMAT_Y16);
+  auto plan = ProfilePlanner::plan({depth}, 0.0);
+  ASSERT_GE(plan.choices[0].candidate, 0);
+  EXPECT_FALSE(plan.choices[0].exact);
+  EXPECT_EQ(chosen(depth, plan.choices[0]).format, OB_FORMAT_Y16);
+}
+
+TEST(ProfilePlannerTest, StreamWithoutCandidatesGetsNone) {
+  ProfilePlanner::Stream empty;
+  empty.name = "empty";
+  auto plan = ProfilePlanner::plan({empty, depthStream()}, 35.0);
+  ASSERT_EQ(plan.choices.size(), 2u);
+  EXPECT_EQ(plan.choices[0].candidate, -1);
+  EXPECT_GE(plan.choices[1].candidate, 0);
+}
+
+TEST(ProfilePlannerTest, ColorTriesMjpgBeforeLoweringResolution) {
+  std::vector<ProfilePlanner::Stream> streams{colorStream(), depthStream()};
+  auto plan = ProfilePlanner::plan(streams, 35.0);
+  EXPECT_TRUE(plan.fits);
+  EXPECT_LE(plan.total_mb_per_s, 35.0);
+  const auto &color = chosen(streams[0], plan.choices[0]);
+  EXPECT_TRUE(plan.choices[0].degraded);
+  EXPECT_EQ(color.format, OB_FORMAT_MJPG);
+  EXPECT_EQ(color.width, 1280u);
+  EXPECT_EQ(color.height, 720u);
+  // depth keeps Y16 for point clouds and filters
+  EXPECT_EQ(chosen(streams[1], plan.choices[1]).format, OB_FORMAT_Y16);
+}
+
+TEST(ProfilePlannerTest, UncountedStreamsStayOutOfTheBudget) {
+  ProfilePlanner::Stream ir;
+  ir.name = "ir";
+  ir.counted = false;
+  ir.candidates = {makeProfile(848, 480, 30, OB_FORMAT_Y8), makeProfile(424, 240, 5, OB_FORMAT_Y8)};
+  std::vector<ProfilePlanner::Stream> streams{depthStream(), ir};
+  auto plan = ProfilePlanner::plan(streams, 15.0);
+  EXPECT_TRUE(plan.fits);
+  EXPECT_LE(plan.total_mb_per_s, 15.0);
+  EXPECT_TRUE(plan.choices[0].degraded);
+  EXPECT_EQ(plan.choices[1].candidate, 0);
+  EXPECT_FALSE(plan.choices[1].degraded);
+}
+
+TEST(ProfilePlannerTest, NonPositiveBudgetDisablesStepping) {
+  std::vector<ProfilePlanner::Stream> streams{colorStream(), depthStream()};
+  for (double budget : {0.0, -1.0}) {
+    auto plan = ProfilePlanner::plan(streams, budget);
+    EXPECT_TRUE(plan.fits);
+    EXPECT_FALSE(plan.choices[0].degraded);
+    EXPECT_FALSE(plan.choices[1].degraded);
+  }
+}
+
+TEST(ProfilePlannerTest, ReportsWhenEvenTheLowestProfilesExceedTheBudget) {
+  std::vector<ProfilePlanner::Stream> streams{colorStream(), depthStream()};
+  auto plan = ProfilePlanner::plan(streams, 0.1);
+  EXPECT_FALSE(plan.fits);
+  EXPECT_GT(plan.total_mb_per_s, 0.1);
+  EXPECT_TRUE(plan.choices[0].degraded);
+  EXPECT_TRUE(plan.choices[1].degraded);
+}
+
+TEST(ProfilePlannerTest, LinkBudgetFollowsTheConnectionType) {
+  EXPECT_DOUBLE_EQ(ProfilePlanner::linkBudget("USB2.0"), 35.0);
+  EXPECT_DOUBLE_EQ(ProfilePlanner::linkBudget("usb3.2"), 400.0);
+  EXPECT_DOUBLE_EQ(ProfilePlanner::linkBudget("Ethernet"), 110.0);
+  EXPECT_DOUBLE_EQ(ProfilePlanner::linkBudget("unknown"), 0.0);
+}
+}  // namespace orbbec_camera
@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * Copyright (c) 2023 Orbbec 3D Technology, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "orbbec_camera/worker_pool.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace orbbec_camera {
+TEST(WorkerPoolTest, CoversEveryIndexOnce) {
+  WorkerPool pool(3);
+  EXPECT_EQ(pool.size(), 4);
+  std::vector<std::atomic<int>> visits(1000);
+  std::atomic<int> chunks{0};
+  pool.parallelFor(3, 1003, [&](int begin, int end) {
+    EXPECT_LT(begin, end);
+    chunks++;
+    for (int i = begin; i < end; i++) {
+      visits[i - 3]++;
+    }
+  });
+  EXPECT_EQ(chunks.load(), pool.size());
+  for (const auto &count : visits) {
+    EXPECT_EQ(count.load(), 1);
+  }
+}
+
+TEST(WorkerPoolTest, RunsSmallRangesOnTheCaller) {
+  WorkerPool pool(2);
+  int calls = 0;
+  pool.parallelFor(5, 5, [&](int, int) { calls++; });
+  EXPECT_EQ(calls, 0);
+  const auto caller = std::this_thread::get_id();
+  pool.parallelFor(7, 8, [&](int begin, int end) {
+    calls++;
+    EXPECT_EQ(begin, 7);
+    EXPECT_EQ(end, 8);
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+  });
+  EXPECT_EQ(calls, 1);
+  WorkerPool inline_pool(0);
+  inline_pool.parallelFor(0, 100, [&](int begin, int end) {
+    calls++;
+    EXPECT_EQ(end - begin, 100);
+  });
+  EXPECT_EQ(calls, 2);
+}
+
+// Cameras sharing one pool: every caller's job blocks until all callers are inside their own
+// job, which only completes if the calls run side by side instead of one after another.
+TEST(WorkerPoolTest, ConcurrentCallersRunSideBySide) {
+  const int callers = 4;
+  WorkerPool pool(3);
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<bool> entered(callers, false);
+  int entered_count = 0;
+  std::atomic<int> timeouts{0};
+  std::vector<std::thread> threads;
+  for (int caller = 0; caller < callers; caller++) {
+    threads.emplace_back([&, caller]() {
+      pool.parallelFor(0, 64, [&](int, int) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!entered[caller]) {
+          entered[caller] = true;
+          entered_count++;
+          cv.notify_all();
+        }
+        if (!cv.wait_for(lock, std::chrono::seconds(5),
+                         [&]() { return entered_count == callers; })) {
+          timeouts++;
+        }
+      });
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(entered_count, callers);
+  EXPECT_EQ(timeouts.load(), 0);
+}
+
+TEST(WorkerPoolTest, ConcurrentCallersGetTheirOwnResults) {
+  const int callers = 4;
+  const int frames = 200;
+  auto pool = std::make_shared<WorkerPool>(3);
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int caller = 0; caller < callers; caller++) {
+    threads.emplace_back([&, caller]() {
+      const int rows = 100 + caller * 37;
+      for (int frame = 0; frame < frames; frame++) {
+        std::vector<int> row_owner(rows, -1);
+        pool->parallelFor(0, rows, [&](int begin, int end) {
+          for (int row = begin; row < end; row++) {
+            row_owner[row] = caller;
+          }
+        });
+        for (int row = 0; row < rows; row++) {
+          if (row_owner[row] != caller) {
+            failures++;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures.load(), 0);
+}
+
+TEST(WorkerPoolTest, NestedCallsComplete) {
+  WorkerPool pool(2);
+  std::atomic<int> inner_rows{0};
+  pool.parallelFor(0, 6, [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      pool.parallelFor(0, 10, [&](int inner_begin, int inner_end) {
+        inner_rows += inner_end - inner_begin;
+      });
+    }
+  });
+  EXPECT_EQ(inner_rows.load(), 60);
+}
+}  // namespace orbbec_camera